@@ -13,6 +13,7 @@
 #define BODE_Analysis
 
 #include<iostream>
+#include<memory>
 #include<vector>
 #include<string>
 
@@ -21,11 +22,27 @@
 #include<TGraphErrors.h>
 #include<TPad.h>
 #include<TString.h>
+#include<Fit/FitResult.h>
+
+#include"Bode/Archive.h"
+#include"Bode/Decimate.h"
+#include"Bode/InputReader.h"
+#include"Bode/Models.h"
+#include"Bode/Propagate.h"
+#include"Bode/Renderer.h"
+#include"Bode/Stats.h"
+#include"Bode/Sweep.h"
+#include"Bode/Waveform.h"
 
 // typedefs
 typedef int NPar_t;
 typedef TString System_t;
 
+class BodeFitCache;
+class TGaxis;
+class TLegend;
+class TLine;
+
 
 class Bode{
 private:
@@ -40,17 +57,20 @@ private:
     System_t            fSystem = "";
 
     bool                _isfunctioncalled   = false; ///> check if user called for function different from base;
-    bool                _residualOn         = false;
+    bool                _residualOn         = false; ///> Plot() adds a pad with the pulls of the fitted components
     bool                _islowhighpass      = true;
     bool                _hasfittedgain      = false;
     bool                _hasfittedphase     = false;
+    bool                _drawgainfit        = true;  ///> fit option "0" turns it off
+    bool                _drawphasefit       = true;
+    bool                _hasseedgain        = false; ///> SetParGain called since SetFunctions, otherwise seeds are estimated
+    bool                _hasseedphase       = false;
 
     // font size for calling ATLASStyle
     Size_t              tsize = 30;
 
-    // phase and gain fit formula
-    const char         *_gainfit    = ""; 
-    const char         *_phasefit   = "";
+    // phase and gain fit model (compiled, see Bode/Models.h)
+    BodeModel::Filter_t fFilter     = BodeModel::kUnknown;
     NPar_t              _CutoffPar  = 1;
     NPar_t              _GainPar    = 0;
     NPar_t              _QPar       = 2;
@@ -64,12 +84,48 @@ private:
     Double_t            gErrCutoff  = -1111; ///> Cutoff value error
     Double_t            gGain       = -1111; ///> Gain value
     Double_t            gErrGain    = -1111; ///> Gain value error
-
-    /// graphical objects []
-    TGraphErrors       *fGain       = 0;
-    TGraphErrors       *fPhase      = 0;
-    TF1                *fGainFit    = 0; 
-    TF1                *fPhaseFit   = 0;
+    Double_t            gQ          = -1111; ///> Q factor (bandpass only)
+    Double_t            gErrQ       = -1111; ///> Q factor error
+
+    ULong_t             fId         = 0;     ///> unique per object, used in ROOT object names
+
+    /// graphical objects, owned and reused: graphs are refilled from fSweep when
+    /// plotting, functions made again only if the filter changes
+    std::unique_ptr<TGraphErrors> fGain;
+    std::unique_ptr<TGraphErrors> fPhase;
+    std::unique_ptr<TF1> fGainFit;
+    std::unique_ptr<TF1> fPhaseFit;
+    BodeModel::Filter_t fFuncFilter = BodeModel::kUnknown;  ///> model of fGainFit/fPhaseFit
+
+    /// Plot() canvas, kept for the next Plot(); the canvas goes last (declared first)
+    std::unique_ptr<TCanvas> fFigure;
+    std::unique_ptr<TPad> fGainPad;
+    std::unique_ptr<TPad> fPhasePad;
+    std::unique_ptr<TLegend> fLegend;
+    std::unique_ptr<TLine> fCutoffLine;
+    std::unique_ptr<TGaxis> fPhaseAxis;
+    std::unique_ptr<TGraph> fGainCurve;     ///> fitted curves as drawn, see SampleCurve
+    std::unique_ptr<TGraph> fPhaseCurve;
+    std::vector<Double_t> fCurveX;
+    std::vector<Double_t> fCurveY;
+    std::unique_ptr<TPad> fResidualPad;     ///> SetResidual(): pulls of the plotted points, see ComputePulls
+    std::unique_ptr<TGraph> fGainPull;
+    std::unique_ptr<TGraph> fPhasePull;
+
+    /// what the graphs show: fSweep itself or its level-of-detail reduction, and
+    /// its extent; made again only after fSweep changes
+    Sweep               fPlotSweep;
+    SweepRange_t        fPlotRange;
+    bool                _plotstale  = true;
+    Int_t               fLODBins    = 0;    ///> <= 0: every point is drawn
+    Double_t            fLODOutlier = 5;
+    ROOT::Fit::FitResult fGainResult;       ///> last gain fit, with covariance
+    ROOT::Fit::FitResult fPhaseResult;      ///> last phase fit, with covariance
+    ROOT::Fit::FitResult fCorrelatedResult; ///> last joint gain+phase fit, with covariance
+    TString             fGainGOption;       ///> goption of the last gain fit, used when drawing the curve
+    TString             fPhaseGOption;
+    Axis_t              fGainRange[2]  = {0, 0};   ///> of the last gain fit, after "R"; {0, 0}: whole sweep
+    Axis_t              fPhaseRange[2] = {0, 0};
 
     Float_t             legendX1    = 0.2;
     Float_t             legendY1    = 0.2;
@@ -79,48 +135,98 @@ private:
     /// function variables declaration
     Double_t            fmin = (0.0);   ///> minimum for frequency range
     Double_t            fmax = (1.0);   ///> maximum for frequency range
-    Double_t            fNpoints = -1111;       ///> points in graph
-    std::vector<double> fPointGain;     ///>[fNpoints] array for gain points
-    std::vector<double> fPErrGain;      ///>[fNpoints] array for error gain points
-    std::vector<double> fPointPhase;    ///>[fNpoints] array for phase points
-    std::vector<double> fPErrPhase;     ///>[fNpoints] array for error phase points
-    std::vector<double> fPointFreq;     ///>[fNpoints] array for frequency points
-    std::vector<double> fPErrFreq;      ///>[fNpoints] array for error frequency points
+    Sweep               fSweep;         ///> freq, gain, phase and their errors, read/fit/plot all use it
+    std::vector<MalformedLine_t> fMalformed;    ///> lines skipped by the last ReadInput
+    std::vector<Double_t> fRaw;         ///> readings behind fSweep, 8 columns as RawColumns_t; empty unless read from them
+    BodeFitCache       *fCache      = 0;    ///> not owned, 0: always minimize
+    BodeStats           fStats;                 ///> per-stage timings and counters, off unless SetStats()
+
+    Bool_t              CheckSize(std::size_t n, const char *what);
+    Bool_t              DoFit(bool fitgain, bool fitphase, const Double_t *seed, Option_t *option, Axis_t xmin, Axis_t xmax, ROOT::Fit::FitResult &result, BodeStats::Stage_t stage);
+    void                FitRange(TF1 *func, Option_t *option, Axis_t &xmin, Axis_t &xmax) const;    ///> option "R": the function's range
+    void                StoreFit(TF1 *func, const ROOT::Fit::FitResult &result, Option_t *option, Axis_t xmin, Axis_t xmax, bool &hasfitted, bool &drawfit);
+    void                DrawCurve(TF1 *func, BodeModel::Component_t comp, bool logy, const TString &goption, std::unique_ptr<TGraph> &curve);   ///> goption mapped onto TGraph options, a line when none is left
+    void                DrawPulls(bool plotgain, bool plotphase);
+    void                MakeGraphs();
+    void                SetFitResult(TF1 *func, const ROOT::Fit::FitResult &result, Axis_t xmin, Axis_t xmax);
+    void                SetSummary(const ROOT::Fit::FitResult &result);     ///> fills gCutoff, gGain, gQ, gGBW and errors; all -1111 unless result.IsValid()
 
 public:
     // Bode();
     Bode(System_t sys);                                             ///> sys: OP_AMP: 0x1 high pass, 0x2 low pass; RLC 0x101 high pass, 0x102 low pass, 0x103 band pass;
     Bode(System_t sys, const char *filename, Option_t *option="");  ///> sys: OP_AMP: 0x1 high pass, 0x2 low pass; RLC 0x101 high pass, 0x102 low pass, 0x103 band pass;
     ~Bode();
+    Bode(const Bode &) = delete;
+    Bode &operator=(const Bode &) = delete;
+    Bool_t              AppendPoint(Double_t freq, Double_t efreq, Double_t gain, Double_t egain, Double_t phase, Double_t ephase);  ///> grows the sweep in place, fits and seeds are kept; false, nothing appended, unless Sweep::IsValid
+    static TString      CurveOption(const TString &goption);   ///> TF1 draw option as the option of the sampled TGraph: "L", "C", "P", "*", "F", "B" kept, "L" when none is left
+    Bool_t              EstimatePar(bool setgain = true, bool setphase = true, Axis_t xmin = 0, Axis_t xmax = 0);    ///> seeds from the data (Bode/Estimate.h) in [xmin, xmax]; FitX does it when no SetParX was given
+    /**
+     * @brief Fit in [xmin, xmax] (xmin >= xmax: whole sweep). option, as TH1::Fit:
+     * "Q" quiet, "V" verbose, "E" Minos errors, "R" range of the fit function,
+     * "N" function not updated nor drawn, "0" not drawn. goption is the draw
+     * option of the fitted curve, "L" when empty; Plot() draws the curve as a
+     * TGraph sampled by SampleCurve (Bode/Decimate.h), keeping its "L", "C",
+     * "P", "*", "F" and "B" and dropping the rest.
+     */
     Bool_t              FitGain(Option_t *option="", Option_t *goption="", Axis_t xmin=0, Axis_t xmax=0);
     Bool_t              FitPhase(Option_t *option="", Option_t *goption="", Axis_t xmin=0, Axis_t xmax=0);
     Bool_t              FitCorrelated(Option_t *option="", Option_t *goption="", Axis_t xmin=0, Axis_t xmax=0);
+    inline const ROOT::Fit::FitResult &GetCorrelatedResult() const { return fCorrelatedResult; }    ///> parameters and full covariance of FitCorrelated
+    void                GetFitRange(BodeModel::Component_t comp, Axis_t &xmin, Axis_t &xmax) const;    ///> range the last fit of comp used, xmin >= xmax: whole sweep; e.g. for BodeProfile::SetRange
+    inline const ROOT::Fit::FitResult &GetGainResult() const { return fGainResult; }
+    inline const ROOT::Fit::FitResult &GetPhaseResult() const { return fPhaseResult; }
     inline Double_t     GetCutoff()     const { return gCutoff; }
     inline Double_t     GetErrCutoff()  const { return gErrCutoff; }
     inline Double_t     GetErrGain()    const { return gErrGain; }
+    inline Double_t     GetErrQ()       const { return gErrQ; }
     inline Double_t     GetErrGBW()     const { return gErrGBW; }
     inline Double_t     GetGain()       const { return gGain; }
+    inline BodeModel::Filter_t GetFilter() const { return fFilter; }
     inline Double_t     GetGBW()        const { return gGBW; }
+    inline Double_t     GetQ()          const { return gQ; }
+    inline const BodeStats &GetStats()  const { return fStats; }
+    inline const std::vector<MalformedLine_t> &GetMalformedLines() const { return fMalformed; }
+    inline Int_t        GetNpoints()    const { return fSweep.Size(); }
+    BodePlot_t          GetPlotData(bool plotphase = true, bool plotgain = true) const;    ///> snapshot for BodeRenderer, independent of this object
+    inline const std::vector<Double_t> &GetRaw() const { return fRaw; }   ///> 8 columns of Size() readings, empty unless read from them
+    inline const Sweep &GetSweep()      const { return fSweep; }
     void                Plot(const char *filename = "", bool plotphase = true, bool plotgain = true);
     void                PlotGain(const char *filename = "");
     void                PlotPhase(const char *filename = "");
     Bool_t              ReadInput(const char *filename = "", Option_t *option="");       ///> read input for both phase and gain data 
+    void                Reset(System_t sys = "");   ///> empty, as just constructed (sys "": same system), keeping every allocation for the next sweep
+    Bool_t              ReadArchive(const BodeArchiveReader &archive, long entry);      ///> sweep, readings and fits of one entry, see Bode/Archive.h
+    Bool_t              ReadArchive(const char *filename, const char *name);
+    Bool_t              ReadWaveforms(const std::vector<std::string> &files, const WaveformFormat_t &format,
+                                      const std::vector<Double_t> &frequencies = {}, unsigned nthreads = 0);    ///> one raw capture per point, see Bode/Waveform.h
     // bool                ReadInputGain(const char *filename, Option_t *option="");   ///> read input for gain data
     // bool                ReadInputPhase(const char *filename, Option_t *option="");  ///> read input for phase data
     // bool                ReadInputRDF()  // TO BE IMPLEMENTED
     inline void         SetCutoffNpar(NPar_t npar = 1)  { _CutoffPar = npar; }
+    inline void         SetFitCache(BodeFitCache *cache) { fCache = cache; }    ///> fits found in cache are read back instead of minimized
     inline void         SetGainNpar(NPar_t npar = 0)    { _GainPar = npar; }
-    Bool_t              SetFreqVec(std::vector<Double_t> Freq, std::vector<Double_t> ErrFreq);
+    Bool_t              SetFreqVec(const std::vector<Double_t> &Freq, const std::vector<Double_t> &ErrFreq);
+    Bool_t              SetFreqVec(const Double_t *Freq, const Double_t *ErrFreq, Int_t n);
     Bool_t              SetFunctions();
     // void                SetGainFunction(const char *formula, Option_t *option="");
-    Bool_t              SetGainVec(std::vector<Double_t> Gain, std::vector<Double_t> ErrGain);
+    Bool_t              SetGainVec(const std::vector<Double_t> &Gain, const std::vector<Double_t> &ErrGain);
+    Bool_t              SetGainVec(const Double_t *Gain, const Double_t *ErrGain, Int_t n);
     inline void         SetLabel(Option_t *fmt) { label = fmt; }
+    inline void         SetLOD(Int_t nbins = 1000, Double_t outlier = 5) { fLODBins = nbins; fLODOutlier = outlier; _plotstale = true; }   ///> plots show about 6 points per log-frequency bin (envelope, typical, outliers beyond outlier rms), see Bode/Decimate.h; nbins <= 0: all points
     void                SetParGain(Double_t gain, Double_t cutoff, Double_t Q = -1);
     void                SetParPhase(Double_t gain, Double_t cutoff, Double_t Q = -1);
     // void                SetPhaseFunction(const char *formula, Option_t *option="");
-    Bool_t              SetPhaseVec(std::vector<Double_t> Phase, std::vector<Double_t> ErrPhase);
+    Bool_t              SetPhaseVec(const std::vector<Double_t> &Phase, const std::vector<Double_t> &ErrPhase);
+    Bool_t              SetPhaseVec(const Double_t *Phase, const Double_t *ErrPhase, Int_t n);
+    Bool_t              SetRawData(std::size_t n, const RawColumns_t &raw);   ///> scope readings already in memory, as ReadInput without the file
+    void                SetSweep(Sweep &&sweep);        ///> takes the data over, no copy; call SetFunctions() after
+    static void         SetStyle(Size_t tsize = 30);   ///> ATLAS style on gStyle, once per process; the first plot does it, the constructors do not
+    inline void         SetStats(bool on = true) { fStats.SetEnabled(on); }     ///> also on for every object with BODE_STATS=1
     void                SetSystem(System_t sys);
-    inline void         SetResidual(bool residual = true) { _residualOn = residual; }
+    inline void         SetResidual(bool residual = true) { _residualOn = residual; }     ///> Plot() shows the pulls (y - fit)/error under the fit; see BodeProfile for scans and intervals
+    Bool_t              WriteArchive(BodeArchiveWriter &archive, const char *name) const;    ///> sweep, readings (if any) and fits done so far
+    Bool_t              WriteStats(const char *filename) const;     ///> GetStats() as JSON, with object id and system
 };
 
 #endif
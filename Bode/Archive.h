@@ -0,0 +1,136 @@
+/**
+ * @file Archive.h
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief Binary archive of many sweeps, their raw readings and fit results
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * Layout, in the byte order of the writing host (doubles are copied as they are
+ * in memory); the u32 after the version reads 0x01020304 there, and a reader on
+ * a host of the other byte order rejects the file:
+ *
+ *     "BODEARC1" u32 version u32 0x01020304
+ *     chunk 0 | chunk 1 | ...              one per sweep, optionally deflated
+ *     index: per chunk u64 offset, u64 stored size, u64 size, u64 npoints,
+ *            u32 filter, u32 flags, u32 name length, name
+ *     u64 index offset, u64 entries, "BODEIDX1"
+ *
+ * A chunk holds the six sweep columns, the eight raw reading columns (if kept),
+ * then three length-prefixed fit results (gain, phase, correlated; length 0 if
+ * not fitted, see BodeFitCache::Encode). Columns are stored whole, one after the
+ * other; deflated chunks have their doubles byte-shuffled first (all first bytes,
+ * then all second bytes, ...), which deflate compresses far better.
+ *
+ * Reading one sweep is one pread at the offset from the index, so several
+ * threads can share a reader. The writer appends chunks under a lock and writes
+ * the index on Close(); a file without its index (crashed writer) is rejected.
+ * After a failed write the writer refuses any further Write() and Close() leaves
+ * the file without an index, so a partial chunk is never listed.
+ *
+ *     BodeArchiveWriter out("sweeps.bda", true);
+ *     bode.WriteArchive(out, "run42");
+ *     out.Close();
+ *
+ *     BodeArchiveReader in("sweeps.bda");
+ *     bode.ReadArchive(in, in.Find("run42"));
+ */
+
+#ifndef BODE_Archive
+#define BODE_Archive
+
+#include<cstdint>
+#include<cstdio>
+#include<mutex>
+#include<string>
+#include<vector>
+
+#include<Fit/FitResult.h>
+
+#include"Bode/Models.h"
+#include"Bode/Sweep.h"
+
+/**
+ * @brief One sweep as stored, owned by value
+ */
+struct ArchiveSweep_t {
+    enum Fit_t {
+        kGainFit        = 0,
+        kPhaseFit       = 1,
+        kCorrelatedFit  = 2,
+        kNFits          = 3
+    };
+
+    std::string         name;
+    BodeModel::Filter_t filter      = BodeModel::kUnknown;
+    Sweep               sweep;
+    std::vector<double> raw;                    ///> 8*Size() readings, column after column as RawColumns_t; empty if not kept
+    bool                hasfit[kNFits] = {false, false, false};
+    ROOT::Fit::FitResult fit[kNFits];
+};
+
+/**
+ * @brief Index row, enough to pick a sweep without reading it
+ */
+struct ArchiveEntry_t {
+    enum Flag_t {
+        kRaw            = 1 << 0,
+        kDeflated       = 1 << 1,
+        kGainFit        = 1 << 2,   ///> kGainFit << ArchiveSweep_t::Fit_t for the others
+        kPhaseFit       = 1 << 3,
+        kCorrelatedFit  = 1 << 4
+    };
+
+    std::string         name;
+    std::uint64_t       offset      = 0;
+    std::uint64_t       stored      = 0;        ///> bytes on disk
+    std::uint64_t       size        = 0;        ///> bytes once inflated
+    std::uint64_t       npoints     = 0;
+    std::uint32_t       filter      = 0;
+    std::uint32_t       flags       = 0;
+};
+
+class BodeArchiveWriter{
+private:
+    FILE               *fFile       = 0;
+    std::string         fFilename;
+    bool                _deflate;
+    std::vector<ArchiveEntry_t> fIndex;
+    std::uint64_t       fOffset     = 0;
+    bool                _failed     = false;    ///> a write came up short, the file ends in a partial chunk
+    std::mutex          fMutex;                 ///> Write() may be called from several threads
+
+public:
+    BodeArchiveWriter(const char *filename, bool deflate = false);     ///> truncates; deflate needs zlib at build time
+    ~BodeArchiveWriter();                       ///> calls Close()
+    BodeArchiveWriter(const BodeArchiveWriter &) = delete;
+    BodeArchiveWriter &operator=(const BodeArchiveWriter &) = delete;
+
+    bool                Close();                ///> writes the index, the archive is unreadable before; false, no index, if a write failed
+    inline std::size_t  GetNEntries() const { return fIndex.size(); }
+    inline bool         IsFailed() const { return _failed; }
+    inline bool         IsOpen() const { return fFile != 0; }
+    bool                Write(const ArchiveSweep_t &sweep);     ///> compressed on the calling thread, appended under the lock; false from the first failed write on
+};
+
+class BodeArchiveReader{
+private:
+    int                 fFd         = -1;
+    std::string         fFilename;
+    std::vector<ArchiveEntry_t> fIndex;
+
+public:
+    BodeArchiveReader(const char *filename);    ///> reads the index only
+    ~BodeArchiveReader();
+    BodeArchiveReader(const BodeArchiveReader &) = delete;
+    BodeArchiveReader &operator=(const BodeArchiveReader &) = delete;
+
+    long                Find(const char *name) const;           ///> entry with that name, -1 if none
+    inline const ArchiveEntry_t &GetEntry(std::size_t i) const { return fIndex[i]; }
+    inline std::size_t  GetNEntries() const { return fIndex.size(); }
+    inline bool         IsOpen() const { return fFd >= 0; }
+    bool                Read(std::size_t i, ArchiveSweep_t &sweep) const;     ///> thread safe
+};
+
+#endif
@@ -0,0 +1,72 @@
+/**
+ * @file BatchFit.h
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief Many small sweeps of one filter type fitted in lockstep, one per vector lane
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * The sweeps are sorted by size and packed kLanes at a time into blocks laid out
+ * point-major (point i of every lane side by side, shorter sweeps padded with zero
+ * weight), so one pass over a block evaluates chi2, gradient and J^T W J of all its
+ * lanes with the lane loop innermost, which the compiler turns into AVX2/AVX-512
+ * code (picked at run time, as for PropagateColumns). The Levenberg-Marquardt
+ * iteration is NativeMinimize's (Bode/Minimize.h) with a damping factor and an
+ * active mask per lane: a lane that has converged or failed stops updating, the
+ * block stops when no lane is active. Blocks run in parallel on a ThreadPool.
+ * No ROOT involved (library BodeCore).
+ *
+ *     BodeBatchFit fit("lowpass");
+ *     fit.Fit(sweeps);                         // std::vector<Sweep>
+ *     fit.GetCutoff(i), fit.GetErrCutoff(i)    // as Bode::GetCutoff for sweep i
+ */
+
+#ifndef BODE_BatchFit
+#define BODE_BatchFit
+
+#include<cstddef>
+#include<vector>
+
+#include"Bode/Minimize.h"
+#include"Bode/Models.h"
+#include"Bode/Sweep.h"
+
+class BodeBatchFit{
+public:
+    enum { kLanes = 8 };
+
+private:
+    BodeModel::Filter_t fFilter;
+    BodeModel::Component_t fComp = BodeModel::kGain;
+    MinimizeOptions_t   fOptions;
+    unsigned            fNThreads   = 0;
+    double              fSeed[BodeModel::kMaxPar] = {1, 1, 1};
+    bool                _hasseed    = false;    ///> otherwise estimated for each sweep
+    std::vector<MinimizeResult_t> fResults;
+
+    inline double       Par(std::size_t i, int k) const { return fResults[i].valid? fResults[i].par[k] : -1111; }
+    inline double       Err(std::size_t i, int k) const { return fResults[i].valid? fResults[i].err[k] : -1111; }
+
+public:
+    BodeBatchFit(BodeModel::Filter_t filter);
+    BodeBatchFit(const char *filter);               ///> "lowpass", "highpass" or "bandpass"
+
+    std::size_t         Fit(const Sweep *const *sweeps, std::size_t n);    ///> converged fits
+    std::size_t         Fit(const std::vector<Sweep> &sweeps);
+    inline double       GetCutoff(std::size_t i)    const { return Par(i, 1); }    ///> -1111 if sweep i did not converge
+    inline double       GetErrCutoff(std::size_t i) const { return Err(i, 1); }
+    inline double       GetGain(std::size_t i)      const { return Par(i, 0); }
+    inline double       GetErrGain(std::size_t i)   const { return Err(i, 0); }
+    inline double       GetQ(std::size_t i)         const { return fFilter == BodeModel::kBandpass? Par(i, 2) : -1111; }
+    inline double       GetErrQ(std::size_t i)      const { return fFilter == BodeModel::kBandpass? Err(i, 2) : -1111; }
+    inline const MinimizeResult_t &GetResult(std::size_t i) const { return fResults[i]; }
+    inline const std::vector<MinimizeResult_t> &GetResults() const { return fResults; }
+    static const char  *Kernel();                  ///> "avx512", "avx2" or "scalar"
+    inline void         SetComponent(BodeModel::Component_t comp) { fComp = comp; }  ///> kPhase: gain fixed at its seed
+    inline void         SetNThreads(unsigned nthreads) { fNThreads = nthreads; }     ///> 0: one per hardware thread
+    inline void         SetOptions(const MinimizeOptions_t &options) { fOptions = options; }
+    void                SetSeed(double gain, double cutoff, double Q = 1);          ///> same start for every sweep
+};
+
+#endif
@@ -0,0 +1,81 @@
+/**
+ * @file BodeBatch.h
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief Parallel read -> fit -> summarize over many sweep files
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef BODE_BodeBatch
+#define BODE_BodeBatch
+
+#include<string>
+#include<vector>
+
+#include"Bode/Analysis.h"
+#include"Bode/Renderer.h"
+
+class BodePool;
+
+/**
+ * @brief One row of the batch results table, -1111 marks values not available
+ * for the system (e.g. Q for a lowpass) or not computed because the fit failed.
+ */
+struct BodeResult_t {
+    std::string         filename;
+    Bool_t              status      = false;    ///> read and gain fit succeeded
+    Int_t               npoints     = 0;
+    Int_t               malformed   = 0;        ///> lines skipped by ReadInput
+    Double_t            gain        = -1111;
+    Double_t            errGain     = -1111;
+    Double_t            cutoff      = -1111;
+    Double_t            errCutoff   = -1111;
+    Double_t            Q           = -1111;
+    Double_t            errQ        = -1111;
+    Double_t            GBW         = -1111;
+    Double_t            errGBW      = -1111;
+    Int_t               stable      = -1;       ///> window scan: 1 stable, 0 rejected, -1 not scanned
+    Double_t            maxPull     = -1111;    ///> window scan: largest cutoff (or Q) pull
+};
+
+class BodeBatch{
+private:
+    System_t            fSystem;
+    std::vector<std::string> fFiles;
+    std::vector<BodeResult_t> fResults;
+
+    unsigned            fNThreads   = 0;        ///> 0: one per hardware thread
+    Double_t            fParGain[3] = {1, 1, -1};
+    Double_t            fParPhase[3] = {1, 1, -1};
+    bool                _hasseedgain    = false;    ///> otherwise seeds are estimated per sweep
+    bool                _hasseedphase   = false;
+    bool                _fitphase   = false;
+    std::string         fPlotOutput;            ///> empty: no plots
+    std::string         fCacheDir;              ///> empty: no fit cache
+    Int_t               fScanTrim[2] = {0, 0};  ///> low, high; {0, 0}: no window scan
+    Double_t            fScanThreshold = 3;
+
+    BodeResult_t        Process(const std::string &filename, BodePlot_t *plot, BodeFitCache *cache, BodePool &pool) const;    ///> plot: filled if not 0 and the sweep was read
+
+public:
+    BodeBatch(System_t sys);
+    ~BodeBatch() = default;
+
+    void                AddFile(const char *filename);
+    Int_t               AddGlob(const char *pattern);           ///> shell glob, e.g. "sweeps/*.txt"; returns files added
+    inline const std::vector<BodeResult_t> &GetResults() const { return fResults; }
+    Bool_t              Run();                                  ///> true if every file was fitted (and, with SetWindowScan, stable)
+    inline void         SetFitCache(const char *dir) { fCacheDir = dir; }       ///> see BodeFitCache
+    inline void         SetFitPhase(bool fitphase = true) { _fitphase = fitphase; }
+    inline void         SetNThreads(unsigned nthreads) { fNThreads = nthreads; }
+    void                SetParGain(Double_t gain, Double_t cutoff, Double_t Q = -1);
+    void                SetParPhase(Double_t gain, Double_t cutoff, Double_t Q = -1);
+    void                SetWindowScan(Int_t nlow, Int_t nhigh, Double_t threshold = 3);   ///> see BodeWindowScan; unstable sweeps are rejected
+    inline void         SetPlotOutput(const char *output) { fPlotOutput = output; }   ///> see BodeRenderer; one page per file read, in the order of the files
+    Bool_t              WriteResults(const char *filename) const;   ///> tab separated, one line per file
+};
+
+#endif
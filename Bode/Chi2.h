@@ -0,0 +1,74 @@
+/**
+ * @file Chi2.h
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief Least-squares objective over a sweep, with analytic gradient
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef BODE_Chi2
+#define BODE_Chi2
+
+#include<cstddef>
+#include<vector>
+
+#include"Bode/Models.h"
+
+/**
+ * @brief chi2(p) = sum_terms sum_i w_i (y_i - model(f_i; p))^2
+ *
+ * A term is one measured component (gain or phase) sharing the frequency column.
+ * Frequency errors enter as effective variance, w_i = 1/(ey_i^2 + (dmodel/df ex_i)^2),
+ * with the slope evaluated at the parameters passed to UpdateWeights(); for a fixed
+ * set of weights value and gradient are exact. Points with zero weight (no error,
+ * not finite or outside the range) are skipped, never multiplied by 0.
+ * With exactly one gain and one phase term (the complex H fit) both are computed
+ * in a single pass over the frequency array.
+ */
+class Chi2Function{
+private:
+    struct Term_t {
+        BodeModel::Component_t  comp;
+        const double           *y;
+        const double           *ey;
+        std::vector<double>     w;
+    };
+
+    BodeModel::Filter_t fFilter;
+    std::size_t         fN;
+    const double       *fX;
+    const double       *fEX;
+    std::vector<Term_t> fTerms;
+    double              fXmin;
+    double              fXmax;
+    int                 fGainTerm  = -1;
+    int                 fPhaseTerm = -1;
+
+    template<class Model>
+    double              DoEval(const double *p, double *grad) const;
+    template<class Model>
+    double              DoEvalJoint(const double *p, double *grad) const;
+    template<class Model>
+    double              DoEvalNormal(const double *p, double *grad, double *hess) const;
+    void                ResetWeights(Term_t &term) const;
+
+public:
+    Chi2Function(BodeModel::Filter_t filter, std::size_t n, const double *x, const double *ex = 0);
+
+    void                AddTerm(BodeModel::Component_t comp, const double *y, const double *ey);
+    inline double       Eval(const double *p) const { return EvalGrad(p, 0); }
+    double              EvalGrad(const double *p, double *grad) const;     ///> grad may be 0
+    double              EvalNormal(const double *p, double *grad, double *hess) const;    ///> hess: npar*npar Gauss-Newton 2 J^T W J
+    inline BodeModel::Filter_t GetFilter() const { return fFilter; }
+    inline bool         HasXErrors() const { return fEX != 0; }
+    inline bool         IsJoint() const { return fTerms.size() == 2 && fGainTerm >= 0 && fPhaseTerm >= 0; }
+    std::size_t         NData() const;                                      ///> points entering the sum, all terms
+    inline int          NPar() const { return BodeModel::NPar(fFilter); }
+    void                SetRange(double xmin, double xmax);                 ///> xmin >= xmax: whole sweep
+    void                UpdateWeights(const double *p);
+};
+
+#endif
@@ -0,0 +1,85 @@
+/**
+ * @file Core.h
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief Read, propagate and fit a sweep without ROOT (library BodeCore)
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * BodeCore is what a fit-only job needs: the input parser, the error propagation,
+ * the compiled models, the start-value estimate and NativeMinimize (Bode/Minimize.h).
+ * It links neither ROOT nor LabTools, so nothing is initialized before main and
+ * no graphics style is set up. Bode (Bode/Analysis.h) is the ROOT layer on top:
+ * it reads through ReadSweep and adds Minuit2, Minos, graphs and plots.
+ *
+ *     BodeCore core("lowpass");
+ *     core.ReadInput("sweep.txt");
+ *     if(core.FitGain()) printf("%g +- %g\n", core.GetCutoff(), core.GetErrCutoff());
+ */
+
+#ifndef BODE_Core
+#define BODE_Core
+
+#include<string>
+#include<vector>
+
+#include"Bode/InputReader.h"
+#include"Bode/Minimize.h"
+#include"Bode/Models.h"
+#include"Bode/Stats.h"
+#include"Bode/Sweep.h"
+
+/**
+ * @brief Read an 8-column readings file into sweep, propagated (Bode/Propagate.h).
+ * raw, if given, gets the readings kept (8 columns of sweep.Size(), as RawColumns_t),
+ * malformed the lines skipped. false, with error set if given, if it cannot be opened.
+ */
+bool ReadSweep(const char *filename, Sweep &sweep, std::vector<double> *raw = 0,
+               std::vector<MalformedLine_t> *malformed = 0, std::string *error = 0);
+
+class BodeCore{
+private:
+    BodeModel::Filter_t fFilter;
+    Sweep               fSweep;
+    std::vector<MalformedLine_t> fMalformed;
+    double              fPar[BodeModel::kMaxPar] = {1, 1, 1};    ///> start values of the next fit
+    bool                _hasseed    = false;    ///> SetPar or EstimatePar since the last fit
+    MinimizeOptions_t   fOptions;
+    MinimizeResult_t    fGainResult;
+    MinimizeResult_t    fPhaseResult;
+    MinimizeResult_t    fCorrelatedResult;
+    FitCounters_t       fCounters;
+
+    bool                DoFit(bool fitgain, bool fitphase, double xmin, double xmax, MinimizeResult_t &result);
+
+public:
+    BodeCore(BodeModel::Filter_t filter);
+    BodeCore(const char *filter);                   ///> "lowpass", "highpass" or "bandpass"
+
+    bool                EstimatePar(double xmin = 0, double xmax = 0);  ///> seeds from the data in [xmin, xmax]
+    /// fit in [xmin, xmax] (xmin >= xmax: whole sweep), from the seeds or an estimate
+    bool                FitGain(double xmin = 0, double xmax = 0);
+    bool                FitPhase(double xmin = 0, double xmax = 0);     ///> gain fixed at its seed
+    bool                FitCorrelated(double xmin = 0, double xmax = 0);
+    inline double       GetCutoff()     const { return fGainResult.par[1]; }   ///> of the gain fit, as the rest below
+    inline double       GetErrCutoff()  const { return fGainResult.err[1]; }
+    inline double       GetGain()       const { return fGainResult.par[0]; }
+    inline double       GetErrGain()    const { return fGainResult.err[0]; }
+    inline double       GetQ()          const { return fFilter == BodeModel::kBandpass? fGainResult.par[2] : -1111; }
+    inline double       GetErrQ()       const { return fFilter == BodeModel::kBandpass? fGainResult.err[2] : -1111; }
+    inline const FitCounters_t &GetCounters() const { return fCounters; }
+    inline const MinimizeResult_t &GetCorrelatedResult() const { return fCorrelatedResult; }
+    inline BodeModel::Filter_t GetFilter() const { return fFilter; }
+    inline const MinimizeResult_t &GetGainResult() const { return fGainResult; }
+    inline const std::vector<MalformedLine_t> &GetMalformedLines() const { return fMalformed; }
+    inline const MinimizeResult_t &GetPhaseResult() const { return fPhaseResult; }
+    inline Sweep       &GetSweep()      { return fSweep; }
+    inline const Sweep &GetSweep()      const { return fSweep; }
+    bool                ReadInput(const char *filename, std::string *error = 0);
+    inline void         SetOptions(const MinimizeOptions_t &options) { fOptions = options; }
+    void                SetPar(double gain, double cutoff, double Q = 1);
+    inline void         SetSweep(const Sweep &sweep) { fSweep = sweep; _hasseed = false; }
+};
+
+#endif
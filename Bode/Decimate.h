@@ -0,0 +1,60 @@
+/**
+ * @file Decimate.h
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief Level-of-detail reduction of dense sweeps and adaptive sampling of model curves, for plotting
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * A plot cannot show more than one point per pixel column. DecimateSweep splits
+ * the log-frequency range into that many bins and keeps, in each, the lowest and
+ * highest gain and phase (the envelope), the points closest to the bin's weighted
+ * means (what is typical) and any point further than a given number of bin rms
+ * from the mean (outliers). Points are kept whole, errors included, so the reduced
+ * sweep has exactly the extent of the full one and every error bar drawn is real.
+ *
+ * SampleCurve evaluates a model on a grid refined where the curve bends (in the
+ * axis scales it is drawn with), instead of TF1's fixed number of linear steps.
+ */
+
+#ifndef BODE_Decimate
+#define BODE_Decimate
+
+#include<cstddef>
+#include<vector>
+
+#include"Bode/Models.h"
+#include"Bode/Sweep.h"
+
+/**
+ * @brief Extent of a sweep: frequency and gain over positive values (log axes),
+ * phase over all; each lo > hi if there is nothing to take it from
+ */
+typedef struct {
+    double              freq[2];
+    double              gain[2];
+    double              phase[2];
+} SweepRange_t;
+
+/**
+ * @brief Points of in worth drawing with nbins pixel columns, in their original order.
+ * Sweeps of at most 4*nbins points, or nbins <= 0, are copied whole. Points with
+ * frequency <= 0 cannot be placed on a log axis and are dropped.
+ * @param outlier in units of the bin rms; <= 0: only envelope and typical points
+ * @param range if given, extent of in (equal to that of out)
+ * @return points kept
+ */
+std::size_t DecimateSweep(const Sweep &in, Sweep &out, int nbins = 1000, double outlier = 5, SweepRange_t *range = 0);
+
+/**
+ * @brief Model curve on [xmin, xmax] (xmin > 0 if logx): intervals are halved until
+ * the midpoint is within tolerance (fraction of the curve's y span, in the scale of
+ * the axis) of the straight line drawn between the ends, at most maxdepth times.
+ * @return points in x, y (cleared first), ascending in x
+ */
+std::size_t SampleCurve(BodeModel::Filter_t filter, BodeModel::Component_t comp, const double *par,
+                        double xmin, double xmax, bool logx, bool logy,
+                        std::vector<double> &x, std::vector<double> &y, double tolerance = 1e-3, int maxdepth = 10);
+
+#endif
@@ -0,0 +1,53 @@
+/**
+ * @file ErrorModel.h
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief Instrument (full-scale, type-B) error model for the 8-column sweep rows
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * Row layout: V_in, V_in(fs), V_out, V_out(fs), T, T(fs), dt, dt(fs).
+ * Voltage readings are good to 3.5% (4.5% at or below 10 mV/div) of the 8
+ * divisions, time readings to 0.16% of the 10 divisions; both are taken as
+ * uniform, hence the 1/sqrt(3).
+ */
+
+#ifndef BODE_ErrorModel
+#define BODE_ErrorModel
+
+#include<cmath>
+
+inline double get_VRangeErr(double errPercent, int partitions, double range1){return errPercent * partitions *  range1;}
+inline double get_TRangeErr(double range1, double errPercent = 0.0016, int partition = 10){return range1 * errPercent * partition;}
+inline double get_HErr(double Vin, double Vout, double eVin, double eVout){ double a = eVout/Vin, b = (eVin*Vout)/(Vin*Vin); return sqrt(a*a + b*b);}
+inline double get_phi(double T, double dt){return 2 * M_PI * dt / T;}
+inline double get_phiErr(double T, double dt, double eT, double edt){ double c = edt/T, d = (dt*eT)/(T*T); return 2 * M_PI * sqrt(c*c + d*d);}
+
+/// half width of the uniform error on a voltage reading at full-scale fs
+inline double get_VRange(double fs){ return get_VRangeErr((fs<=0.01)? 0.045 : 0.035, 8, fs); }
+/// half width of the uniform error on a time reading at full-scale fs
+inline double get_TRange(double fs){ return get_TRangeErr(fs); }
+
+/**
+ * @brief One raw row to frequency, gain and phase with their errors.
+ * out = {freq, err freq, gain, err gain, phase, err phase}, the Sweep column order
+ */
+inline void PropagateRow(const double *row, double *out){
+    double Vin = row[0], fsVin = row[1], Vout = row[2], fsVout = row[3];
+    double T = row[4], fsT = row[5], dt = row[6], fsdt = row[7];
+
+    double eVin = get_VRange(fsVin)/sqrt(3);
+    double eVout = get_VRange(fsVout)/sqrt(3);
+    double eT = get_TRangeErr(fsT)/sqrt(3);
+    double edt = get_TRangeErr(fsdt)/sqrt(3);
+
+    out[0] = 1/T;
+    out[1] = eT/(T*T);
+    out[2] = Vout/Vin;
+    out[3] = get_HErr(Vin, Vout, eVin, eVout);
+    out[4] = get_phi(T, dt);
+    out[5] = get_phiErr(T, dt, eT, edt);
+}
+
+#endif
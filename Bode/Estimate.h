@@ -0,0 +1,44 @@
+/**
+ * @file Estimate.h
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief Start values for the fits, computed from the sweep itself
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * 1/|H|^2 is linear in the parameters of every model once the right powers of f
+ * are taken as basis:
+ *     lowpass     1/|H|^2 = 1/G^2 + f^2/(G fc)^2
+ *     highpass    1/|H|^2 = 1/G^2 + (fc/G)^2/f^2
+ *     bandpass    1/|H|^2 = (1 - 2Q^2)/G^2 + Q^2/(G f0)^2 f^2 + (Q f0/G)^2/f^2
+ * so one weighted linear least-squares solve gives all of them. The -3 dB
+ * crossing(s), interpolated in log f, are the fallback when the linear solution
+ * is unphysical (noisy or very partial sweeps).
+ */
+
+#ifndef BODE_Estimate
+#define BODE_Estimate
+
+#include<cstddef>
+
+#include"Bode/Models.h"
+
+namespace BodeModel {
+
+    /**
+     * @brief Gain, cutoff (peak frequency) and, for a bandpass, Q from the gain column.
+     * egain may be 0 (equal relative errors assumed). The points need not be sorted.
+     * @return false if nothing sensible could be derived, par is then untouched
+     */
+    bool Estimate(Filter_t filter, std::size_t n, const double *f, const double *gain, const double *egain, double *par);
+
+    /// the -3 dB crossing part of Estimate alone
+    bool EstimateCrossing(Filter_t filter, std::size_t n, const double *f, const double *gain, double *par);
+
+    /// the linear least-squares part of Estimate alone
+    bool EstimateLinear(Filter_t filter, std::size_t n, const double *f, const double *gain, const double *egain, double *par);
+
+}
+
+#endif
@@ -0,0 +1,65 @@
+/**
+ * @file FitCache.h
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief On-disk fit results, addressed by a hash of everything the fit depends on
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * The key covers the sweep columns entering the fit, the filter, the fitted
+ * components, the range, the start parameters and which parameters are the gain
+ * and the cutoff (Bode::SetGainNpar, SetCutoffNpar), so any change in the inputs
+ * gives a different key and the old entry is simply not found again; there is
+ * nothing to invalidate by hand. Entries are small binary files named after the
+ * key, written to a temporary name and renamed, so several processes or threads
+ * can share one directory. Only valid results are kept: a fit that failed is
+ * minimized again next time, never read back.
+ *
+ *     BodeFitCache cache(".bodecache");
+ *     bode.SetFitCache(&cache);
+ *     bode.FitGain();      // second run: read back, no minimization
+ */
+
+#ifndef BODE_FitCache
+#define BODE_FitCache
+
+#include<atomic>
+#include<cstdint>
+#include<string>
+
+#include<Fit/FitResult.h>
+
+#include"Bode/Models.h"
+#include"Bode/Sweep.h"
+
+class BodeFitCache{
+public:
+    typedef struct { std::uint64_t h[2]; } Key_t;
+
+private:
+    std::string         fDir;
+    std::atomic<long>   fHits;
+    std::atomic<long>   fMisses;
+
+    std::string         Path(const Key_t &key) const;
+
+public:
+    BodeFitCache(const char *dir = ".bodecache");  ///> created if missing
+    BodeFitCache(const BodeFitCache &) = delete;
+    BodeFitCache &operator=(const BodeFitCache &) = delete;
+
+    static Key_t        MakeKey(const Sweep &sweep, BodeModel::Filter_t filter, bool fitgain, bool fitphase,
+                                double xmin, double xmax, const double *seed, int gainpar = 0, int cutoffpar = 1);
+    static std::string  ToHex(const Key_t &key);
+    static void         Encode(const ROOT::Fit::FitResult &result, std::string &buf);       ///> appends; also used by BodeArchive
+    static bool         Decode(const char *&cur, const char *end, ROOT::Fit::FitResult &result);   ///> advances cur
+
+    inline const std::string &GetDir() const { return fDir; }
+    inline long         GetNHits() const { return fHits; }
+    inline long         GetNMisses() const { return fMisses; }
+    bool                Load(const Key_t &key, ROOT::Fit::FitResult &result);          ///> false on a miss, an unreadable entry or an invalid result
+    bool                Store(const Key_t &key, const ROOT::Fit::FitResult &result) const;    ///> false, nothing written, if !result.IsValid()
+};
+
+#endif
@@ -0,0 +1,99 @@
+/**
+ * @file FitFCN.h
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief Exposes a Chi2Function to ROOT::Fit::Fitter as a gradient function
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef BODE_FitFCN
+#define BODE_FitFCN
+
+#include<vector>
+
+#include<Fit/Fitter.h>
+#include<Math/IFunction.h>
+#include<Math/Minimizer.h>
+
+#include"Bode/Chi2.h"
+#include"Bode/Stats.h"
+
+/**
+ * @brief Thin, non-owning adapter: the minimizer gets value and analytic gradient
+ * from the compiled models instead of finite differences on a TFormula.
+ */
+class BodeFCN : public ROOT::Math::IMultiGradFunction {
+private:
+    const Chi2Function *fChi2;
+    FitCounters_t      *fCounters;  ///> shared with the clones the fitter makes, may be 0
+
+    double DoEval(const double *p) const override {
+        if(fCounters) fCounters->nfcn++;
+        return fChi2->Eval(p);
+    }
+    double DoDerivative(const double *p, unsigned int icoord) const override {
+        double grad[BodeModel::kMaxPar];
+        if(fCounters) fCounters->ngrad++;
+        fChi2->EvalGrad(p, grad);
+        return grad[icoord];
+    }
+
+public:
+    BodeFCN(const Chi2Function &chi2, FitCounters_t *counters = 0) : fChi2(&chi2), fCounters(counters) {}
+
+    ROOT::Math::IMultiGenFunction *Clone() const override { return new BodeFCN(*this); }
+    unsigned int NDim() const override { return fChi2->NPar(); }
+    void Gradient(const double *p, double *grad) const override {
+        if(fCounters) fCounters->ngrad++;
+        fChi2->EvalGrad(p, grad);
+    }
+    void FdF(const double *p, double &f, double *grad) const override {
+        if(fCounters){ fCounters->nfcn++; fCounters->ngrad++; }
+        f = fChi2->EvalGrad(p, grad);
+    }
+};
+
+/**
+ * @brief Minuit2 minimization of chi2 starting from par, which gets the result.
+ * With frequency errors the effective-variance weights are re-evaluated at the
+ * first minimum and the fit is repeated from there. The cutoff is kept positive,
+ * the gain is fixed at its start value if fixgain (phase-only fits).
+ * counters, if given, are added to. minos: asymmetric errors of the last pass.
+ */
+inline bool BodeMinimize(Chi2Function &chi2, std::vector<double> &par, bool fixgain, int printlevel,
+        ROOT::Fit::FitResult &result, int gainpar = 0, int cutoffpar = 1, FitCounters_t *counters = 0, bool minos = false){
+
+    unsigned int npar = chi2.NPar();
+    par.resize(npar);
+
+    ROOT::Fit::Fitter fitter;
+    fitter.Config().SetMinimizer("Minuit2");
+    fitter.Config().MinimizerOptions().SetPrintLevel(printlevel);
+
+    BodeFCN fcn(chi2, counters);
+    bool ok = true;
+    int npass = chi2.HasXErrors()? 2 : 1;
+    for(int pass = 0; pass < npass && ok; pass++){
+        // settings go in before each pass, FitFCN(fcn, params) would reset them
+        fitter.Config().SetParamsSettings(npar, par.data());
+        fitter.Config().ParSettings(cutoffpar).SetLowerLimit(0);
+        if(fixgain) fitter.Config().ParSettings(gainpar).Fix();
+        fitter.Config().SetMinosErrors(minos && pass == npass - 1);
+
+        chi2.UpdateWeights(par.data());
+        ok = fitter.FitFCN(fcn, 0, chi2.NData(), true);
+        if(counters){
+            counters->npass++;
+            if(fitter.GetMinimizer()) counters->niter += fitter.GetMinimizer()->NIterations();
+        }
+        par.assign(fitter.Result().GetParams(), fitter.Result().GetParams() + npar);
+    }
+    result = fitter.Result();
+
+    return ok && result.IsValid();
+}
+
+#endif
@@ -0,0 +1,104 @@
+/**
+ * @file GlobalFit.h
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief One fit over the sweeps of a lot of boards, some parameters shared by all
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * Each parameter of the model (0 gain, 1 cutoff, 2 Q) is either shared by every
+ * board or fitted per board. Board j only sees the shared parameters s and its own
+ * l_j, so the normal matrix is block-arrow shaped,
+ *     | A     B_1 ... B_N |
+ *     | B_1^T C_1         |
+ *     | ...       ...     |
+ *     | B_N^T         C_N |
+ * and each Levenberg-Marquardt step eliminates the l_j through the Schur
+ * complement S = A - sum_j B_j C_j^-1 B_j^T: the boards are visited once (in
+ * parallel) and only an ns x ns system is solved, so a step costs O(N). The
+ * covariance is kept in the same factored form, S^-1 and C_j^-1 B_j^T per board,
+ * from which GetCovariance() gives any element of the full matrix. No ROOT
+ * involved (library BodeCore).
+ *
+ *     BodeGlobalFit lot("bandpass");
+ *     for(const Bode &b: boards) lot.Add(b.GetSweep());
+ *     lot.SetShared(2);                // one Q for the lot, gain and f0 per board
+ *     lot.Fit();
+ *     lot.GetShared(2), lot.GetCutoff(j), lot.GetCovariance(j, 1, k, 1)
+ */
+
+#ifndef BODE_GlobalFit
+#define BODE_GlobalFit
+
+#include<cstddef>
+#include<vector>
+
+#include"Bode/Chi2.h"
+#include"Bode/Minimize.h"
+#include"Bode/Models.h"
+#include"Bode/Sweep.h"
+
+class ThreadPool;
+
+class BodeGlobalFit{
+public:
+    enum Role_t { kLocal = 0, kShared = 1, kFixed = 2 };
+
+private:
+    BodeModel::Filter_t fFilter;
+    std::vector<const Sweep *> fSweeps;         ///> not owned
+    bool                fShared[BodeModel::kMaxPar] = {false, false, false};
+    bool                _fitgain    = true;
+    bool                _fitphase   = false;
+    MinimizeOptions_t   fOptions;
+    unsigned            fNThreads   = 0;
+
+    // result
+    Role_t              fRole[BodeModel::kMaxPar];
+    int                 fNShared    = 0;
+    int                 fNLocal     = 0;
+    std::vector<double> fPar;                   ///> kMaxPar per board, shared ones repeated
+    std::vector<double> fCovShared;             ///> S^-1, fNShared^2
+    std::vector<double> fCInv;                  ///> C_j^-1, fNLocal^2 per board
+    std::vector<double> fCB;                    ///> C_j^-1 B_j^T, fNLocal*fNShared per board
+    double              fChi2       = -1;
+    int                 fNdf        = -1;
+    int                 fNIter      = 0;
+    bool                _valid      = false;
+
+    int                 Slot(int par) const;    ///> index of par among the shared or the local ones
+    bool                Step(ThreadPool &pool, const std::vector<double> &grad, const std::vector<double> &hess, double lambda,
+                             std::vector<double> &trial);   ///> damped step from fPar; also fills the factored covariance
+
+public:
+    BodeGlobalFit(BodeModel::Filter_t filter);
+    BodeGlobalFit(const char *filter);          ///> "lowpass", "highpass" or "bandpass"
+
+    inline void         Add(const Sweep &sweep) { fSweeps.push_back(&sweep); }     ///> one board; not copied, must outlive Fit()
+    inline void         Clear() { fSweeps.clear(); _valid = false; }
+    bool                Fit();
+    inline double       GetChi2()       const { return fChi2; }
+    double              GetCovariance(std::size_t board1, int par1, std::size_t board2, int par2) const;   ///> any element of the full covariance
+    inline double       GetCutoff(std::size_t board)    const { return GetPar(board, 1); }
+    inline double       GetErrCutoff(std::size_t board) const { return GetErr(board, 1); }
+    inline double       GetGain(std::size_t board)      const { return GetPar(board, 0); }
+    inline double       GetErrGain(std::size_t board)   const { return GetErr(board, 0); }
+    double              GetErr(std::size_t board, int par) const;
+    inline std::size_t  GetNBoards()    const { return fSweeps.size(); }
+    inline int          GetNdf()        const { return fNdf; }
+    inline int          GetNIter()      const { return fNIter; }
+    double              GetPar(std::size_t board, int par) const;   ///> -1111 if not fitted
+    inline double       GetQ(std::size_t board)         const { return GetPar(board, 2); }
+    inline double       GetErrQ(std::size_t board)      const { return GetErr(board, 2); }
+    inline Role_t       GetRole(int par)    const { return fRole[par]; }
+    inline double       GetShared(int par)      const { return GetPar(0, par); }  ///> a shared parameter
+    inline double       GetErrShared(int par)   const { return GetErr(0, par); }
+    inline bool         IsValid()       const { return _valid; }
+    inline void         SetComponents(bool fitgain, bool fitphase) { _fitgain = fitgain; _fitphase = fitphase; }   ///> phase only: gain fixed at the estimate
+    inline void         SetNThreads(unsigned nthreads) { fNThreads = nthreads; }
+    inline void         SetOptions(const MinimizeOptions_t &options) { fOptions = options; }
+    inline void         SetShared(int par, bool shared = true) { if(par >= 0 && par < BodeModel::kMaxPar) fShared[par] = shared; }
+};
+
+#endif
@@ -0,0 +1,61 @@
+/**
+ * @file InputReader.h
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief Memory-mapped, locale-free reader for whitespace separated sweep tables
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef BODE_InputReader
+#define BODE_InputReader
+
+#include<cstddef>
+#include<string>
+#include<vector>
+
+struct MalformedLine_t {
+    std::size_t         line;       ///> 1-based line number in the input file
+    std::string         reason;     ///> short description of what went wrong
+};
+
+/**
+ * @brief Parse a floating point number from [cur, end) without touching the C locale.
+ *
+ * Accepts an optional sign, digits with an optional '.' and an optional exponent,
+ * the same grammar `std::ifstream >>` accepts. On success `cur` is moved past the number.
+ * Short mantissas are converted exactly (Clinger fast path), longer ones fall back
+ * to a correctly rounded conversion, so the result matches `std::ifstream >>`.
+ */
+bool ParseDouble(const char *&cur, const char *end, double &value);
+
+class InputReader{
+private:
+    const char         *fBegin  = 0;
+    const char         *fEnd    = 0;
+    const char         *fCursor = 0;
+    void               *fMap    = 0;        ///> mmap'd region, 0 when using fBuffer
+    std::size_t         fMapSize = 0;
+    std::vector<char>   fBuffer;            ///> fallback storage if mmap is not possible
+    std::size_t         fLine   = 0;        ///> line number of the last row returned
+    std::vector<MalformedLine_t> fMalformed;
+
+    bool                _isopen = false;
+
+public:
+    InputReader(const char *filename);
+    ~InputReader();
+    InputReader(const InputReader &) = delete;
+    InputReader &operator=(const InputReader &) = delete;
+
+    std::size_t         CountRows() const;                      ///> upper bound on the number of rows (line count)
+    inline const std::vector<MalformedLine_t> &GetMalformed() const { return fMalformed; }
+    inline std::size_t  GetLine() const { return fLine; }
+    inline bool         IsOpen() const { return _isopen; }
+    bool                NextRow(double *row, int ncols);       ///> fill next valid row, skipping blank, comment and malformed lines
+    void                Reject(const char *reason);            ///> mark the last returned row as malformed
+};
+
+#endif
@@ -0,0 +1,110 @@
+/**
+ * @file Live.h
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief Points arriving one at a time during a sweep, fit updated as they come
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * Each acquisition thread gets its own SPSCQueue from AddProducer(), so no lock
+ * is taken on the way in. The analysis thread started by Start() drains all the
+ * queues, appends to the Bode sweep (Bode::AppendPoint, no SetFunctions) and
+ * refits, starting from the previous parameters, every SetRefitEvery() points;
+ * whatever arrived meanwhile goes into the same refit, so a slow fit never
+ * backs the queues up for long. The Bode object belongs to the analysis thread
+ * between Start() and Finish(); read progress with GetState().
+ *
+ *     Bode bode("lowpass");
+ *     BodeLive live(bode);
+ *     live.Start();
+ *     std::thread daq([&](){ sim.Stream(live); });
+ *     ...  live.GetState() ...
+ *     daq.join();
+ *     live.Finish();          // drains, last fit
+ */
+
+#ifndef BODE_Live
+#define BODE_Live
+
+#include<atomic>
+#include<functional>
+#include<memory>
+#include<mutex>
+#include<thread>
+
+#include<Rtypes.h>
+
+#include"Bode/Models.h"
+#include"Bode/SPSCQueue.h"
+#include"Bode/Sweep.h"
+
+class Bode;
+
+struct LivePoint_t {
+    Double_t            freq    = 0;
+    Double_t            efreq   = 0;
+    Double_t            gain    = 0;
+    Double_t            egain   = 0;
+    Double_t            phase   = 0;
+    Double_t            ephase  = 0;
+
+    inline bool         IsValid() const { return Sweep::IsValid(freq, efreq, gain, egain, phase, ephase); }
+};
+
+/**
+ * @brief Progress so far, copied out under a lock; -1111 where not fitted yet
+ */
+struct LiveState_t {
+    std::size_t         npoints     = 0;
+    std::size_t         nrejected   = 0;        ///> points dropped, not finite or freq/gain <= 0
+    long                nfits       = 0;
+    bool                valid       = false;    ///> last fit converged
+    Double_t            par[BodeModel::kMaxPar] = {-1111, -1111, -1111};
+    Double_t            err[BodeModel::kMaxPar] = {-1111, -1111, -1111};
+    Double_t            chi2        = -1;
+    Int_t               ndf         = -1;
+};
+
+class BodeLive{
+public:
+    typedef SPSCQueue<LivePoint_t> Queue_t;
+    enum { kMaxProducers = 16 };
+
+private:
+    Bode               &fBode;
+    std::size_t         fCapacity;
+    std::unique_ptr<Queue_t> fQueues[kMaxProducers];
+    std::atomic<int>    fNQueues{0};
+    std::mutex          fAddMutex;              ///> AddProducer only, never the data path
+
+    std::thread         fThread;
+    std::atomic<bool>   _closed{false};
+    Int_t               fRefitEvery = 1;
+    bool                _fitphase   = false;
+    std::function<void(const LiveState_t &)> fCallback;
+
+    mutable std::mutex  fStateMutex;
+    LiveState_t         fState;
+
+    std::size_t         Drain();                ///> points appended, rejected ones are counted in fState
+    void                Loop();
+    void                Refit();
+
+public:
+    BodeLive(Bode &bode, std::size_t capacity = 4096);     ///> capacity of each producer queue
+    ~BodeLive();                                ///> calls Finish()
+    BodeLive(const BodeLive &) = delete;
+    BodeLive &operator=(const BodeLive &) = delete;
+
+    Queue_t            *AddProducer();          ///> one per acquisition thread, also after Start(); 0 past kMaxProducers
+    void                Finish();               ///> no more points: drain, refit, stop the analysis thread
+    LiveState_t         GetState() const;
+    static LivePoint_t  FromReading(const Double_t *row);  ///> 8 scope readings, as in the input files; all zeros (not IsValid()) if V_in == 0, T <= 0 or not finite
+    inline void         SetCallback(std::function<void(const LiveState_t &)> callback) { fCallback = callback; }   ///> after each refit, on the analysis thread
+    inline void         SetFitPhase(bool fitphase = true) { _fitphase = fitphase; }
+    inline void         SetRefitEvery(Int_t npoints) { fRefitEvery = npoints > 0? npoints : 1; }
+    void                Start();
+};
+
+#endif
@@ -0,0 +1,56 @@
+/**
+ * @file Minimize.h
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief Levenberg-Marquardt on a Chi2Function, no ROOT needed
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * Every model has at most three parameters, so each step solves a 3x3 system
+ * (J^T W J + lambda diag) dp = -grad/2 from Chi2Function::EvalNormal; lambda goes
+ * down by 10 on a step that lowers chi2 and up by 10 otherwise. Effective-variance
+ * passes, positive cutoff and fixed gain are handled as BodeMinimize (FitFCN.h)
+ * does, so the two agree to the convergence tolerance; the covariance is the
+ * inverse of J^T W J at the minimum (what Minuit's Hesse gives for a chi2).
+ */
+
+#ifndef BODE_Minimize
+#define BODE_Minimize
+
+#include"Bode/Chi2.h"
+#include"Bode/Models.h"
+#include"Bode/Stats.h"
+
+struct MinimizeResult_t {
+    bool                valid   = false;
+    int                 npar    = 0;
+    double              par[BodeModel::kMaxPar] = {-1111, -1111, -1111};
+    double              err[BodeModel::kMaxPar] = {-1111, -1111, -1111};
+    double              cov[BodeModel::kMaxPar][BodeModel::kMaxPar] = {};
+    double              chi2    = -1;
+    int                 ndf     = -1;
+    int                 niter   = 0;    ///> all passes
+};
+
+struct MinimizeOptions_t {
+    int                 maxiter     = 200;      ///> per pass
+    double              tolerance   = 1e-10;    ///> relative chi2 change to stop at
+    double              lambda      = 1e-3;     ///> starting damping
+};
+
+/// in place inverse of the leading n x n block, partial pivoting; false if singular
+bool InvertMatrix(double a[][BodeModel::kMaxPar], int n);
+
+/**
+ * @brief Minimize chi2 from par, which gets the result. Same conventions as
+ * BodeMinimize: gain fixed if fixgain, cutoff kept positive, counters added to.
+ */
+bool NativeMinimize(Chi2Function &chi2, double *par, bool fixgain, MinimizeResult_t &result,
+        int gainpar = 0, int cutoffpar = 1, FitCounters_t *counters = 0, const MinimizeOptions_t &options = MinimizeOptions_t());
+
+/// as above, any parameters fixed (isfree[k] false) at their value in par; profile scans use it
+bool NativeMinimize(Chi2Function &chi2, double *par, const bool *isfree, MinimizeResult_t &result,
+        int cutoffpar = 1, FitCounters_t *counters = 0, const MinimizeOptions_t &options = MinimizeOptions_t());
+
+#endif
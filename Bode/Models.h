@@ -0,0 +1,232 @@
+/**
+ * @file Models.h
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief Compiled transfer-function models with analytic parameter gradients
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * All models share one parameter layout, [0] gain, [1] cutoff (peak frequency
+ * for the bandpass), [2] Q factor (bandpass only), so gain and phase fits of the
+ * same system talk about the same parameters. Phase is arg(H(j2πf)) in radians.
+ * ResponseGrad() gives gain and phase of the complex H together, sharing the
+ * intermediate terms, for the joint fit.
+ * Everything here is plain C++ (no ROOT) and inline, so it can be used in tight loops.
+ */
+
+#ifndef BODE_Models
+#define BODE_Models
+
+#include<cmath>
+#include<cstring>
+
+namespace BodeModel {
+
+    enum Filter_t {
+        kUnknown    = 0,
+        kLowpass    = 1,
+        kHighpass   = 2,
+        kBandpass   = 3
+    };
+
+    enum Component_t {
+        kGain       = 0,
+        kPhase      = 1
+    };
+
+    const int kMaxPar = 3;
+
+    /// H = G / (1 + j f/fc)
+    struct Lowpass {
+        static const int NPar = 2;
+
+        static inline double Gain(double f, const double *p){
+            double u = f/p[1];
+            return p[0]/std::sqrt(1 + u*u);
+        }
+        static inline double GainGrad(double f, const double *p, double *grad){
+            double u = f/p[1];
+            double s = 1/std::sqrt(1 + u*u);
+            grad[0] = s;
+            grad[1] = p[0]*s*s*s*u*u/p[1];
+            return p[0]*s;
+        }
+        static inline double GainSlope(double f, const double *p){
+            double u = f/p[1];
+            double s = 1/std::sqrt(1 + u*u);
+            return -p[0]*s*s*s*u/p[1];
+        }
+        static inline double Phase(double f, const double *p){
+            return -std::atan(f/p[1]);
+        }
+        static inline double PhaseGrad(double f, const double *p, double *grad){
+            double u = f/p[1];
+            grad[0] = 0;
+            grad[1] = u/(p[1]*(1 + u*u));
+            return -std::atan(u);
+        }
+        static inline double PhaseSlope(double f, const double *p){
+            double u = f/p[1];
+            return -1/(p[1]*(1 + u*u));
+        }
+        static inline void ResponseGrad(double f, const double *p, double &gain, double *ggain, double &phase, double *gphase){
+            double u = f/p[1];
+            double d = 1 + u*u;
+            double s = 1/std::sqrt(d);
+            gain = p[0]*s;
+            ggain[0] = s;
+            ggain[1] = gain*s*s*u*u/p[1];
+            phase = -std::atan(u);
+            gphase[0] = 0;
+            gphase[1] = u/(p[1]*d);
+        }
+    };
+
+    /// H = G j(f/fc) / (1 + j f/fc)
+    struct Highpass {
+        static const int NPar = 2;
+
+        static inline double Gain(double f, const double *p){
+            double u = p[1]/f;
+            return p[0]/std::sqrt(1 + u*u);
+        }
+        static inline double GainGrad(double f, const double *p, double *grad){
+            double u = p[1]/f;
+            double s = 1/std::sqrt(1 + u*u);
+            grad[0] = s;
+            grad[1] = -p[0]*s*s*s*u/f;
+            return p[0]*s;
+        }
+        static inline double GainSlope(double f, const double *p){
+            double u = p[1]/f;
+            double s = 1/std::sqrt(1 + u*u);
+            return p[0]*s*s*s*u*u/f;
+        }
+        static inline double Phase(double f, const double *p){
+            return std::atan(p[1]/f);
+        }
+        static inline double PhaseGrad(double f, const double *p, double *grad){
+            double u = p[1]/f;
+            grad[0] = 0;
+            grad[1] = 1/(f*(1 + u*u));
+            return std::atan(u);
+        }
+        static inline double PhaseSlope(double f, const double *p){
+            double u = p[1]/f;
+            return -u/(f*(1 + u*u));
+        }
+        static inline void ResponseGrad(double f, const double *p, double &gain, double *ggain, double &phase, double *gphase){
+            double u = p[1]/f;
+            double d = 1 + u*u;
+            double s = 1/std::sqrt(d);
+            gain = p[0]*s;
+            ggain[0] = s;
+            ggain[1] = -gain*s*s*u/f;
+            phase = std::atan(u);
+            gphase[0] = 0;
+            gphase[1] = 1/(f*d);
+        }
+    };
+
+    /// H = G / (1 + jQ (f/f0 - f0/f))
+    struct Bandpass {
+        static const int NPar = 3;
+
+        static inline double Gain(double f, const double *p){
+            double x = f/p[1] - p[1]/f;
+            return p[0]/std::sqrt(1 + p[2]*p[2]*x*x);
+        }
+        static inline double GainGrad(double f, const double *p, double *grad){
+            double x = f/p[1] - p[1]/f;
+            double dxdf0 = -f/(p[1]*p[1]) - 1/f;
+            double s = 1/std::sqrt(1 + p[2]*p[2]*x*x);
+            double s3 = s*s*s;
+            grad[0] = s;
+            grad[1] = -p[0]*s3*p[2]*p[2]*x*dxdf0;
+            grad[2] = -p[0]*s3*p[2]*x*x;
+            return p[0]*s;
+        }
+        static inline double GainSlope(double f, const double *p){
+            double x = f/p[1] - p[1]/f;
+            double dxdf = 1/p[1] + p[1]/(f*f);
+            double s = 1/std::sqrt(1 + p[2]*p[2]*x*x);
+            return -p[0]*s*s*s*p[2]*p[2]*x*dxdf;
+        }
+        static inline double Phase(double f, const double *p){
+            return -std::atan(p[2]*(f/p[1] - p[1]/f));
+        }
+        static inline double PhaseGrad(double f, const double *p, double *grad){
+            double x = f/p[1] - p[1]/f;
+            double dxdf0 = -f/(p[1]*p[1]) - 1/f;
+            double d = 1/(1 + p[2]*p[2]*x*x);
+            grad[0] = 0;
+            grad[1] = -p[2]*dxdf0*d;
+            grad[2] = -x*d;
+            return -std::atan(p[2]*x);
+        }
+        static inline double PhaseSlope(double f, const double *p){
+            double x = f/p[1] - p[1]/f;
+            double dxdf = 1/p[1] + p[1]/(f*f);
+            return -p[2]*dxdf/(1 + p[2]*p[2]*x*x);
+        }
+        static inline void ResponseGrad(double f, const double *p, double &gain, double *ggain, double &phase, double *gphase){
+            double x = f/p[1] - p[1]/f;
+            double dxdf0 = -f/(p[1]*p[1]) - 1/f;
+            double d = 1 + p[2]*p[2]*x*x;
+            double s = 1/std::sqrt(d);
+            gain = p[0]*s;
+            ggain[0] = s;
+            ggain[1] = -gain*s*s*p[2]*p[2]*x*dxdf0;
+            ggain[2] = -gain*s*s*p[2]*x*x;
+            phase = -std::atan(p[2]*x);
+            gphase[0] = 0;
+            gphase[1] = -p[2]*dxdf0/d;
+            gphase[2] = -x/d;
+        }
+    };
+
+    /// same keys as Bode::SetSystem / SimEngine::SetFilterType
+    inline Filter_t FilterFromName(const char *name){
+        if(!name) return kUnknown;
+        if(strcmp(name, "lowpass") == 0) return kLowpass;
+        if(strcmp(name, "highpass") == 0) return kHighpass;
+        if(strcmp(name, "bandpass") == 0) return kBandpass;
+        return kUnknown;
+    }
+
+    inline int NPar(Filter_t filter){
+        return (filter == kBandpass)? Bandpass::NPar : Lowpass::NPar;
+    }
+
+    // runtime dispatch, for callers that evaluate one point at a time
+    inline double Eval(Filter_t filter, Component_t comp, double f, const double *p){
+        switch(filter){
+            case kLowpass:  return (comp == kGain)? Lowpass::Gain(f, p)  : Lowpass::Phase(f, p);
+            case kHighpass: return (comp == kGain)? Highpass::Gain(f, p) : Highpass::Phase(f, p);
+            case kBandpass: return (comp == kGain)? Bandpass::Gain(f, p) : Bandpass::Phase(f, p);
+            default:        return 0;
+        }
+    }
+
+    inline double EvalGrad(Filter_t filter, Component_t comp, double f, const double *p, double *grad){
+        switch(filter){
+            case kLowpass:  return (comp == kGain)? Lowpass::GainGrad(f, p, grad)  : Lowpass::PhaseGrad(f, p, grad);
+            case kHighpass: return (comp == kGain)? Highpass::GainGrad(f, p, grad) : Highpass::PhaseGrad(f, p, grad);
+            case kBandpass: return (comp == kGain)? Bandpass::GainGrad(f, p, grad) : Bandpass::PhaseGrad(f, p, grad);
+            default:        return 0;
+        }
+    }
+
+    inline double Slope(Filter_t filter, Component_t comp, double f, const double *p){
+        switch(filter){
+            case kLowpass:  return (comp == kGain)? Lowpass::GainSlope(f, p)  : Lowpass::PhaseSlope(f, p);
+            case kHighpass: return (comp == kGain)? Highpass::GainSlope(f, p) : Highpass::PhaseSlope(f, p);
+            case kBandpass: return (comp == kGain)? Bandpass::GainSlope(f, p) : Bandpass::PhaseSlope(f, p);
+            default:        return 0;
+        }
+    }
+
+}
+
+#endif
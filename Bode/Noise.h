@@ -0,0 +1,37 @@
+/**
+ * @file Noise.h
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief Colored Gaussian noise in bulk, by FFT, for simulated instrument drift
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * A series with power spectrum S(f) ~ 1/f^alpha is the inverse FFT of a spectrum
+ * whose bins are complex Gaussians of variance S(f_k) (Timmer & Koenig 1995).
+ * Without Hermitian symmetry the result is complex, its real and imaginary parts
+ * being two independent series with the same spectrum, so one transform gives two.
+ * The transform is padded to a power of two at least twice the length, so the
+ * lowest frequencies are not forced periodic over the series. Draws come from
+ * Philox, addressed by (counter, stream): the same series for any thread split.
+ */
+
+#ifndef BODE_Noise
+#define BODE_Noise
+
+#include<complex>
+#include<cstddef>
+#include<cstdint>
+
+/// in place radix-2 transform, n a power of two; inverse: e^{+i}, not scaled
+void FFT(std::complex<double> *data, std::size_t n, bool inverse = false);
+
+/**
+ * @brief Two independent unit-variance series x, y of length n (either may be 0) with
+ * spectrum 1/f^alpha: 0 white, 1 flicker (1/f), 2 random walk. counter and stream
+ * select the draws, e.g. sweep number and channel pair
+ */
+void ColoredNoise(std::size_t n, double alpha, std::uint64_t seed, std::uint64_t counter, std::uint32_t stream,
+                  double *x, double *y);
+
+#endif
@@ -0,0 +1,62 @@
+/**
+ * @file Philox.h
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief Counter-based random numbers (Philox4x32-10, Salmon et al. 2011)
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * A draw is a pure function of (key, counter): with the seed as key and e.g.
+ * (sweep, point, ...) as counter every number is addressable directly, so results
+ * do not depend on how the work is split between threads.
+ */
+
+#ifndef BODE_Philox
+#define BODE_Philox
+
+#include<cmath>
+#include<cstdint>
+
+namespace Philox {
+
+    typedef struct { std::uint32_t v[4]; } Block_t;
+
+    inline Block_t Generate(std::uint32_t c0, std::uint32_t c1, std::uint32_t c2, std::uint32_t c3, std::uint64_t seed){
+
+        const std::uint32_t M0 = 0xD2511F53, M1 = 0xCD9E8D57;
+        const std::uint32_t W0 = 0x9E3779B9, W1 = 0xBB67AE85;
+
+        std::uint32_t k0 = static_cast<std::uint32_t>(seed);
+        std::uint32_t k1 = static_cast<std::uint32_t>(seed >> 32);
+
+        for(int round = 0; round < 10; round++){
+            std::uint64_t p0 = static_cast<std::uint64_t>(M0) * c0;
+            std::uint64_t p1 = static_cast<std::uint64_t>(M1) * c2;
+            std::uint32_t n0 = static_cast<std::uint32_t>(p1 >> 32) ^ c1 ^ k0;
+            std::uint32_t n2 = static_cast<std::uint32_t>(p0 >> 32) ^ c3 ^ k1;
+            c1 = static_cast<std::uint32_t>(p1);
+            c3 = static_cast<std::uint32_t>(p0);
+            c0 = n0;
+            c2 = n2;
+            k0 += W0;
+            k1 += W1;
+        }
+
+        Block_t out = {{c0, c1, c2, c3}};
+        return out;
+    }
+
+    /// 32 random bits to a double uniform in (0, 1), never 0 or 1
+    inline double ToUniform(std::uint32_t x){
+        return (x + 0.5) * (1.0/4294967296.0);
+    }
+
+    /// two uniforms to one standard normal (Box-Muller)
+    inline double ToGaus(std::uint32_t a, std::uint32_t b){
+        return std::sqrt(-2*std::log(ToUniform(a))) * std::cos(2*M_PI*ToUniform(b));
+    }
+
+}
+
+#endif
@@ -0,0 +1,84 @@
+/**
+ * @file Planner.h
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief Picks the frequencies to measure next, for the most precise cutoff and Q
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * From the current fit the planner builds the Fisher information of the points
+ * measured so far, I = sum_i J_i J_i^T / s_i^2 (J the model gradient, s_i the
+ * effective error of the fit, frequency error included), and its inverse, the
+ * expected covariance C. A new point at f with error s(f) changes C by a rank-one
+ * update, C' = C - (C J)(C J)^T / (s^2 + J^T C J), so every candidate on a log grid
+ * is scored by the relative variance of cutoff (plus Q, for a bandpass) it leaves;
+ * Next(n) picks n points greedily. The errors at unmeasured frequencies are
+ * interpolated (in log f) from the relative errors of the measured points unless
+ * SetErrorFunction() says otherwise.
+ *
+ *     BodePlanner plan(bode);          // bode fitted
+ *     plan.SetTarget(0.002);           // 0.2% on the cutoff
+ *     while(!plan.IsDone()){
+ *         for(Double_t f: plan.Next(3)) { ... measure f, bode.AppendPoint(...) ... }
+ *         bode.FitGain("Q");
+ *         plan.Update(bode);
+ *     }
+ */
+
+#ifndef BODE_Planner
+#define BODE_Planner
+
+#include<functional>
+#include<vector>
+
+#include<Rtypes.h>
+
+#include"Bode/Models.h"
+#include"Bode/Sweep.h"
+
+class Bode;
+
+class BodePlanner{
+public:
+    /// err[0] frequency, err[1] gain, err[2] phase error expected at f
+    typedef std::function<void(Double_t f, Double_t *err)> ErrorFunction_t;
+
+private:
+    Sweep               fSweep;
+    BodeModel::Filter_t fFilter;
+    Double_t            fPar[BodeModel::kMaxPar] = {1, 1, 1};
+    Double_t            fCov[BodeModel::kMaxPar][BodeModel::kMaxPar];  ///> expected, from the points so far
+
+    Double_t            fFmin       = -1;       ///> <= 0: half the lowest measured frequency
+    Double_t            fFmax       = -1;       ///> <= 0: twice the highest
+    Int_t               fNCandidates = 400;
+    Double_t            fTarget[BodeModel::kMaxPar] = {-1, 1e-3, 1e-3};    ///> relative; <= 0: not a goal
+    bool                _fitgain    = true;
+    bool                _fitphase   = false;
+    ErrorFunction_t     fErrors;
+    std::vector<Double_t> fLogF;                ///> measured points by frequency, for the default errors
+    std::vector<Double_t> fRelErr[3];           ///> efreq/freq, egain/gain, ephase at fLogF
+
+    void                AddPoint(Double_t cov[][BodeModel::kMaxPar], Double_t f, const Double_t *err) const;
+    void                Errors(Double_t f, Double_t *err) const;
+    void                Init();
+    Double_t            Score(const Double_t cov[][BodeModel::kMaxPar]) const;
+
+public:
+    BodePlanner(const Bode &bode);                  ///> sweep, filter and last fitted parameters of bode
+    BodePlanner(const Sweep &sweep, BodeModel::Filter_t filter, const Double_t *par);
+
+    Double_t            GetRelError(Int_t par) const;   ///> expected sigma/value with the points so far
+    Bool_t              IsDone() const;                 ///> every target reached
+    std::vector<Double_t> Next(Int_t n = 1) const;      ///> n frequencies, best first; empty if done
+    Double_t            Predict(const std::vector<Double_t> &freqs, Int_t par) const;    ///> GetRelError after measuring freqs
+    inline void         SetComponents(bool fitgain, bool fitphase) { _fitgain = fitgain; _fitphase = fitphase; Init(); }   ///> what the fit uses (default: gain)
+    inline void         SetErrorFunction(ErrorFunction_t errors) { fErrors = errors; }
+    inline void         SetNCandidates(Int_t n) { fNCandidates = n > 1? n : 2; }
+    inline void         SetRange(Double_t fmin, Double_t fmax) { fFmin = fmin; fFmax = fmax; }
+    inline void         SetTarget(Double_t cutoff, Double_t Q = 1e-3) { fTarget[1] = cutoff; fTarget[2] = Q; }   ///> Q only counts for a bandpass
+    void                Update(const Bode &bode);      ///> after new points and a refit
+};
+
+#endif
@@ -0,0 +1,68 @@
+/**
+ * @file Pool.h
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief Reusable Bode objects for long-running services
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * A Bode object keeps its sweep buffers, graphs, functions and canvas between
+ * sweeps once Reset() is called, so a service that takes one from the pool per
+ * sweep and gives it back allocates nothing in steady state. Objects are kept
+ * per system; the handle returned by Acquire() resets the object and gives it back
+ * when it goes out of scope. The pool must outlive its handles.
+ *
+ *     BodePool pool;
+ *     for(...){
+ *         BodePool::Handle_t bode = pool.Acquire("lowpass");
+ *         bode->ReadInput(filename);
+ *         bode->FitGain("Q");
+ *     }   // back to the pool, emptied
+ */
+
+#ifndef BODE_Pool
+#define BODE_Pool
+
+#include<cstddef>
+#include<map>
+#include<memory>
+#include<mutex>
+#include<string>
+#include<vector>
+
+#include"Bode/Analysis.h"
+
+class BodePool{
+public:
+    class Releaser_t{
+    private:
+        BodePool       *fPool = 0;
+        std::string     fKey;
+    public:
+        Releaser_t() = default;
+        Releaser_t(BodePool *pool, const std::string &key) : fPool(pool), fKey(key) {}
+        void            operator()(Bode *bode) const;
+    };
+    typedef std::unique_ptr<Bode, Releaser_t> Handle_t;
+
+private:
+    std::mutex          fMutex;
+    std::map<std::string, std::vector<std::unique_ptr<Bode>>> fIdle;   ///> by system
+    std::size_t         fMaxIdle    = 64;       ///> per system, more are deleted on release
+    std::size_t         fNCreated   = 0;
+
+    void                Release(const std::string &key, Bode *bode);
+
+public:
+    BodePool() = default;
+    BodePool(const BodePool &) = delete;
+    BodePool &operator=(const BodePool &) = delete;
+
+    Handle_t            Acquire(System_t sys);          ///> idle object of that system, or a new one; thread safe
+    std::size_t         GetNCreated();                  ///> objects made so far, flat once the pool is warm
+    std::size_t         GetNIdle();
+    void                SetMaxIdle(std::size_t n);
+};
+
+#endif
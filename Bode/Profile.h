@@ -0,0 +1,109 @@
+/**
+ * @file Profile.h
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief Chi2 profile scans of cutoff and Q, asymmetric intervals, residuals and pulls
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * The covariance errors of the fit assume chi2 is a parabola around the minimum,
+ * which fails where the model bends strongly in its parameters (a bandpass with low
+ * Q, a cutoff at the edge of the sweep). A profile scan fixes the scanned
+ * parameter(s) on a grid and refits the others at every node; the interval is
+ * where chi2 - chi2_min stays below up (1 for 68%, 4 for 95% on one parameter),
+ * read off the curve on each side, so it need not be symmetric. Nodes are refitted
+ * in parallel, two chains per row of the grid that walk outwards from the best
+ * fit, each node starting from its neighbour's result; a one-parameter scan is
+ * therefore two chains. The conditions of the Bode fit being profiled (range,
+ * fixed parameters, fitted components) are given with SetRange, SetFixed and
+ * SetComponents. No ROOT involved (library BodeCore).
+ *
+ *     BodeProfile prof(bode.GetSweep(), bode.GetFilter(), par);   // par: gain, cutoff, Q
+ *     bode.GetFitRange(BodeModel::kGain, xmin, xmax);
+ *     prof.SetRange(xmin, xmax);       // as the fit did
+ *     prof.Scan(1);                    // cutoff, +- 3 sigma, 41 nodes
+ *     prof.GetErrLow(1), prof.GetErrHigh(1)
+ *     prof.Scan2D(1, 2);               // cutoff x Q map, for the joint contour
+ */
+
+#ifndef BODE_Profile
+#define BODE_Profile
+
+#include<cstddef>
+#include<vector>
+
+#include"Bode/Minimize.h"
+#include"Bode/Models.h"
+#include"Bode/Sweep.h"
+
+/**
+ * @brief One node of a scan, -1111 marks what was not scanned
+ */
+struct ProfilePoint_t {
+    double              value[2]    = {-1111, -1111};   ///> scanned parameter(s), fixed
+    double              par[BodeModel::kMaxPar] = {-1111, -1111, -1111};   ///> all, the others refitted
+    double              chi2        = -1;
+    bool                status      = false;            ///> refit converged
+};
+
+/**
+ * @brief Residuals y - model and pulls, residual over the effective error
+ * sqrt(ey^2 + (dmodel/df ef)^2) the fits use, of one component at par
+ */
+void ComputePulls(BodeModel::Filter_t filter, BodeModel::Component_t comp, const Sweep &sweep, const double *par,
+                  double *residual, double *pull);
+
+class BodeProfile{
+private:
+    Sweep               fSweep;
+    BodeModel::Filter_t fFilter;
+    double              fStart[BodeModel::kMaxPar] = {1, 1, 1};
+    bool                _fitgain    = true;
+    bool                _fitphase   = false;
+    bool                fFixed[BodeModel::kMaxPar] = {false, false, false};    ///> held at their start value by every fit
+    double              fXmin       = 0;        ///> fit range, fXmin >= fXmax: whole sweep
+    double              fXmax       = 0;
+    unsigned            fNThreads   = 0;        ///> 0: one per hardware thread
+    MinimizeOptions_t   fOptions;
+
+    MinimizeResult_t    fBest;                  ///> free fit, the reference of every scan
+    bool                _hasbest    = false;
+    std::vector<double> fResidual[2];           ///> gain, phase at fBest
+    std::vector<double> fPull[2];
+
+    // last scan
+    int                 fScanPar[2] = {-1, -1};
+    std::vector<double> fGrid[2];
+    std::vector<ProfilePoint_t> fPoints;        ///> fGrid[0] runs fastest
+
+    void                AddTerms(Chi2Function &chi2) const;    ///> components and range, as every fit here sees them
+    bool                DoPoint(ProfilePoint_t &point, const double *start) const;
+    bool                FitBest();
+    std::vector<double> MakeGrid(int par, int n, double nsigma) const;
+    void                RunChain(std::size_t first, std::size_t n, std::ptrdiff_t stride);    ///> n nodes from first, each started from the one before
+
+public:
+    BodeProfile(const Sweep &sweep, BodeModel::Filter_t filter, const double *par);   ///> par: where the free fit starts, e.g. the last fit
+
+    inline const MinimizeResult_t &GetBest() const { return fBest; }
+    inline double       GetChi2Min() const { return fBest.chi2; }
+    double              GetErrHigh(int par, double up = 1) const;   ///> hi - best, -1111 if not reached in the scan range
+    double              GetErrLow(int par, double up = 1) const;    ///> best - lo, -1111 if not reached
+    inline const std::vector<double> &GetGrid(int axis = 0) const { return fGrid[axis]; }
+    bool                GetInterval(int par, double &lo, double &hi, double up = 1) const;    ///> from the last one-parameter scan of par; false if a side is not reached
+    std::size_t         GetNFailed() const;             ///> nodes of the last scan whose refit did not converge
+    inline const std::vector<ProfilePoint_t> &GetPoints() const { return fPoints; }
+    const std::vector<double> &GetPulls(BodeModel::Component_t comp);       ///> at the free fit, in sweep order
+    const std::vector<double> &GetResiduals(BodeModel::Component_t comp);
+    bool                Scan(int par, int n = 41, double nsigma = 3);      ///> par 0 gain, 1 cutoff, 2 Q; range: nsigma Hesse errors around the best fit; false if the free fit failed or par is fixed
+    bool                Scan2D(int par1, int par2, int n1 = 31, int n2 = 31, double nsigma = 3);    ///> two-parameter map, par1 runs fastest
+    inline void         SetComponents(bool fitgain, bool fitphase) { _fitgain = fitgain; _fitphase = fitphase; _hasbest = false; }   ///> what is fitted (default: gain); phase only: gain fixed
+    inline void         SetFixed(int par, bool fixed = true) { if(par >= 0 && par < BodeModel::kMaxPar) fFixed[par] = fixed; _hasbest = false; }   ///> par held at its start value, as a fixed parameter of the Bode fit
+    inline void         SetNThreads(unsigned nthreads) { fNThreads = nthreads; }
+    inline void         SetOptions(const MinimizeOptions_t &options) { fOptions = options; _hasbest = false; }
+    inline void         SetRange(double xmin, double xmax) { fXmin = xmin; fXmax = xmax; _hasbest = false; }   ///> only points in [xmin, xmax] are fitted, xmin >= xmax: whole sweep (default)
+    bool                WriteResults(const char *filename) const;   ///> tab separated, one line per node
+};
+
+#endif
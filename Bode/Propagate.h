@@ -0,0 +1,47 @@
+/**
+ * @file Propagate.h
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief Column-wise (vectorized) version of the ErrorModel.h row propagation
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * Same operations in the same order as PropagateRow, four (AVX2) or eight
+ * (AVX-512) points at a time, the full-scale threshold as a blend instead of a
+ * branch; the instruction set is picked at run time, with a plain loop as fallback.
+ * Results are bit-identical to PropagateRow as long as neither is compiled with
+ * floating-point contraction (FMA), which this file's source never is.
+ */
+
+#ifndef BODE_Propagate
+#define BODE_Propagate
+
+#include<cstddef>
+
+/**
+ * @brief Raw scope readings as columns, see the row layout in Bode/ErrorModel.h
+ */
+struct RawColumns_t {
+    const double       *Vin     = 0;
+    const double       *fsVin   = 0;    ///> full scale of V_in, V/div
+    const double       *Vout    = 0;
+    const double       *fsVout  = 0;
+    const double       *T       = 0;
+    const double       *fsT     = 0;    ///> s/div
+    const double       *dt      = 0;
+    const double       *fsdt    = 0;
+};
+
+/**
+ * @brief n readings to frequency, gain and phase with their errors.
+ * Output columns may be the six columns of a Sweep; nothing is checked, rows with
+ * V_in == 0 or T <= 0 give inf/nan as they would through PropagateRow.
+ */
+void PropagateColumns(std::size_t n, const RawColumns_t &raw,
+                      double *freq, double *efreq, double *gain, double *egain, double *phase, double *ephase);
+
+/// "avx512", "avx2" or "scalar": the kernel PropagateColumns runs on this machine
+const char *PropagateKernel();
+
+#endif
@@ -0,0 +1,114 @@
+/**
+ * @file Renderer.h
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief Headless rendering of many sweeps on one reused canvas
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * Plots are made from BodePlot_t snapshots (data + fitted parameters), not from
+ * a Bode object, so fitting and drawing are independent: snapshots can be
+ * rendered right away, queued for a background thread, or kept and drawn later.
+ *
+ *     BodeRenderer renderer("report.pdf");         // one multi-page PDF
+ *     BodeRenderer renderer("plots/sweep_%04d.png"); // one PNG per sweep
+ *     renderer.Start();                            // optional: draw on its own thread
+ *     renderer.Push(bode.GetPlotData());
+ *     renderer.Close();                            // or let the destructor do it
+ */
+
+#ifndef BODE_Renderer
+#define BODE_Renderer
+
+#include<condition_variable>
+#include<deque>
+#include<mutex>
+#include<string>
+#include<thread>
+#include<vector>
+
+#include<Rtypes.h>
+
+#include"Bode/Models.h"
+#include"Bode/Sweep.h"
+
+class TCanvas;
+class TGraph;
+class TGraphErrors;
+class TH1F;
+class TLegend;
+class TLine;
+class TPad;
+
+/**
+ * @brief Everything needed to draw one sweep, owned by value
+ */
+struct BodePlot_t {
+    Sweep               sweep;
+    BodeModel::Filter_t filter      = BodeModel::kUnknown;
+    Double_t            parGain[BodeModel::kMaxPar]  = {1, 1, 1};
+    Double_t            parPhase[BodeModel::kMaxPar] = {1, 1, 1};
+    bool                hasGainFit  = false;
+    bool                hasPhaseFit = false;
+    std::string         goptGain;               ///> draw options of the fitted curves, see Bode::CurveOption
+    std::string         goptPhase;
+    Double_t            cutoff      = -1111;    ///> dashed vertical line, not drawn if <= 0
+    std::string         label       = "Preliminary";
+    bool                plotGain    = true;
+    bool                plotPhase   = true;
+    Int_t               lodBins     = 0;        ///> DecimateSweep bins, <= 0: every point is drawn
+    Double_t            lodOutlier  = 5;
+};
+
+class BodeRenderer{
+private:
+    std::string         fOutput;
+    bool                _multipage  = true;     ///> false: fOutput is a printf pattern, one file per page
+    bool                _isopen     = false;    ///> multi-page file opened with "["
+    Int_t               fPages      = 0;
+    ULong_t             fId         = 0;
+
+    /// drawing primitives, made once on the drawing thread and reused for every page
+    TCanvas            *fCanvas     = 0;
+    TPad               *fGainPad    = 0;
+    TPad               *fPhasePad   = 0;
+    TH1F               *fGainFrame  = 0;
+    TH1F               *fPhaseFrame = 0;
+    TGraphErrors       *fGain       = 0;
+    TGraphErrors       *fPhase      = 0;
+    TGraph             *fGainCurve  = 0;    ///> fitted curves, sampled by SampleCurve
+    TGraph             *fPhaseCurve = 0;
+    TLegend            *fLegend     = 0;
+    TLine              *fCutoffLine = 0;
+    Float_t             fRightMargin = 0.05;    ///> pad default, 0.16 leaves room for the phase axis
+    Float_t             fLabelSize  = 0.05;
+    Sweep               fPlotSweep;             ///> points of the page being drawn, after DecimateSweep
+    std::vector<Double_t> fCurveX;
+    std::vector<Double_t> fCurveY;
+
+    /// background drawing
+    std::thread         fThread;
+    std::mutex          fMutex;
+    std::condition_variable fCond;
+    std::deque<BodePlot_t> fQueue;
+    bool                _stop       = false;
+
+    void                Init();
+    void                Finish();           ///> closes the output and frees the primitives
+    void                Loop();
+
+public:
+    BodeRenderer(const char *output);       ///> "name.pdf": multi-page; "name_%04d.png" (any printf pattern): one file per page
+    ~BodeRenderer();
+    BodeRenderer(const BodeRenderer &) = delete;
+    BodeRenderer &operator=(const BodeRenderer &) = delete;
+
+    void                Close();            ///> draws what is still queued and closes the output
+    void                Draw(const BodePlot_t &plot);           ///> one page, on the calling thread
+    inline Int_t        GetNPages() const { return fPages; }
+    void                Push(BodePlot_t &&plot);                ///> queue a page; drawn by Start()'s thread, or at Close()
+    void                Start();            ///> draw queued pages on a background thread
+};
+
+#endif
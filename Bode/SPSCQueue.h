@@ -0,0 +1,75 @@
+/**
+ * @file SPSCQueue.h
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief Bounded lock-free queue, one producer thread and one consumer thread
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * Ring buffer of a power-of-two size. The producer only writes fTail, the
+ * consumer only writes fHead, each on its own cache line; each side keeps a
+ * cached copy of the other index and reloads it only when the ring looks full
+ * (or empty), so a push or pop is normally one store and no shared-line traffic.
+ */
+
+#ifndef BODE_SPSCQueue
+#define BODE_SPSCQueue
+
+#include<atomic>
+#include<cstddef>
+#include<thread>
+#include<vector>
+
+template<class T>
+class SPSCQueue{
+private:
+    std::vector<T>      fRing;
+    std::size_t         fMask;
+
+    alignas(64) std::atomic<std::size_t> fHead{0};     ///> next slot to pop, consumer
+    std::size_t         fTailCache = 0;
+    alignas(64) std::atomic<std::size_t> fTail{0};     ///> next slot to push, producer
+    std::size_t         fHeadCache = 0;
+
+public:
+    SPSCQueue(std::size_t capacity = 4096){     ///> rounded up to a power of two
+        std::size_t n = 2;
+        while(n < capacity) n <<= 1;
+        fRing.resize(n);
+        fMask = n - 1;
+    }
+    SPSCQueue(const SPSCQueue &) = delete;
+    SPSCQueue &operator=(const SPSCQueue &) = delete;
+
+    inline std::size_t  Capacity() const { return fRing.size(); }
+    inline bool         Empty() const { return fHead.load(std::memory_order_acquire) == fTail.load(std::memory_order_acquire); }
+
+    bool TryPush(const T &value){       ///> producer only, false if full
+        std::size_t tail = fTail.load(std::memory_order_relaxed);
+        if(tail - fHeadCache == fRing.size()){
+            fHeadCache = fHead.load(std::memory_order_acquire);
+            if(tail - fHeadCache == fRing.size()) return false;
+        }
+        fRing[tail & fMask] = value;
+        fTail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    void Push(const T &value){          ///> producer only, yields while full
+        while(!TryPush(value)) std::this_thread::yield();
+    }
+
+    bool TryPop(T &value){              ///> consumer only, false if empty
+        std::size_t head = fHead.load(std::memory_order_relaxed);
+        if(head == fTailCache){
+            fTailCache = fTail.load(std::memory_order_acquire);
+            if(head == fTailCache) return false;
+        }
+        value = fRing[head & fMask];
+        fHead.store(head + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+#endif
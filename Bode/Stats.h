@@ -0,0 +1,102 @@
+/**
+ * @file Stats.h
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief Per-stage timings and counters of a Bode object
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * Off by default: a disabled StageTimer is one branch, no clock is read. Turn it
+ * on with Bode::SetStats() or, for every Bode in the process, BODE_STATS=1 in the
+ * environment.
+ */
+
+#ifndef BODE_Stats
+#define BODE_Stats
+
+#include<chrono>
+#include<string>
+
+/**
+ * @brief Minimizer work done by one fit, filled by BodeFCN / BodeMinimize
+ */
+struct FitCounters_t {
+    long                nfcn    = 0;    ///> chi2 evaluations
+    long                ngrad   = 0;    ///> gradient evaluations
+    long                niter   = 0;    ///> minimizer iterations, all passes
+    long                npass   = 0;    ///> effective-variance passes
+};
+
+class BodeStats{
+public:
+    enum Stage_t {
+        kReadInput      = 0,
+        kSetFunctions   = 1,
+        kFitGain        = 2,
+        kFitPhase       = 3,
+        kFitCorrelated  = 4,
+        kPlot           = 5,
+        kNStages        = 6
+    };
+
+    /**
+     * @brief Totals since the last Reset(); fit fields describe the last call
+     */
+    struct StageStats_t {
+        long            calls       = 0;
+        double          wall        = 0;    ///> s, all calls
+        double          last        = 0;    ///> s, last call
+        long            points      = 0;    ///> ReadInput: rows kept
+        long            rejected    = 0;    ///> ReadInput: malformed or rejected lines
+        FitCounters_t   fit;                ///> fits: all calls
+        long            cachehits   = 0;
+        int             status      = -1;   ///> fits: minimizer status of the last call
+        bool            valid       = false;
+        double          chi2        = -1;
+        int             ndf         = -1;
+    };
+
+    /**
+     * @brief Adds the wall time of its scope to a stage, when stats are on
+     */
+    class StageTimer{
+    private:
+        BodeStats      *fStats;
+        Stage_t         fStage;
+        std::chrono::steady_clock::time_point fStart;
+    public:
+        StageTimer(BodeStats &stats, Stage_t stage) : fStats(stats.IsEnabled()? &stats : 0), fStage(stage) {
+            if(fStats) fStart = std::chrono::steady_clock::now();
+        }
+        ~StageTimer(){
+            if(!fStats) return;
+            double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - fStart).count();
+            StageStats_t &stage = fStats->fStages[fStage];
+            stage.calls++;
+            stage.wall += s;
+            stage.last = s;
+        }
+        StageTimer(const StageTimer &) = delete;
+        StageTimer &operator=(const StageTimer &) = delete;
+    };
+
+private:
+    bool                _enabled;
+    StageStats_t        fStages[kNStages];
+
+public:
+    BodeStats();                                    ///> enabled if BODE_STATS is set and not "0"
+
+    inline StageStats_t &Get(Stage_t stage) { return fStages[stage]; }
+    inline const StageStats_t &Get(Stage_t stage) const { return fStages[stage]; }
+    inline bool         IsEnabled() const { return _enabled; }
+    static std::string  JSONNumber(double x);       ///> %.9g, null if not finite (JSON has no nan/inf)
+    static std::string  JSONString(const char *s);  ///> quoted, with quotes, backslashes and control characters escaped
+    static const char  *Name(Stage_t stage);
+    void                Reset();
+    inline void         SetEnabled(bool enabled = true) { _enabled = enabled; }
+    std::string         ToJSON() const;             ///> one object, stages that ran only
+};
+
+#endif
@@ -0,0 +1,82 @@
+/**
+ * @file Sweep.h
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief Structure-of-arrays storage for one frequency sweep
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef BODE_Sweep
+#define BODE_Sweep
+
+#include<cmath>
+#include<cstddef>
+
+/**
+ * @brief Frequency, gain and phase, each with its error, as six columns of one
+ * 64-byte aligned block. Every column starts on a cache line, so kernels can
+ * stream them with aligned vector loads; moving a Sweep never copies the data.
+ * The same block is read into, fitted and plotted from.
+ */
+class Sweep{
+public:
+    enum Column_t {
+        kFreq       = 0,
+        kErrFreq    = 1,
+        kGain       = 2,
+        kErrGain    = 3,
+        kPhase      = 4,
+        kErrPhase   = 5,
+        kNColumns   = 6
+    };
+
+private:
+    double             *fData       = 0;
+    std::size_t         fSize       = 0;
+    std::size_t         fCapacity   = 0;    ///> per column, multiple of 8 doubles
+
+    void                Reallocate(std::size_t capacity);
+
+public:
+    Sweep() = default;
+    explicit Sweep(std::size_t n);
+    Sweep(const Sweep &other);
+    Sweep(Sweep &&other) noexcept;
+    Sweep &operator=(const Sweep &other);
+    Sweep &operator=(Sweep &&other) noexcept;
+    ~Sweep();
+
+    inline std::size_t  Capacity() const { return fCapacity; }
+    void                Clear() { fSize = 0; }
+    inline double      *Column(Column_t c) { return fData + c*fCapacity; }
+    inline const double *Column(Column_t c) const { return fData + c*fCapacity; }
+    inline bool         Empty() const { return fSize == 0; }
+    void                PushBack(double freq, double efreq, double gain, double egain, double phase, double ephase);
+    void                Reserve(std::size_t n);
+    void                Resize(std::size_t n);          ///> keeps the first min(n, Size()) points
+    inline std::size_t  Size() const { return fSize; }
+
+    /// what a point needs to be fitted and drawn on log axes: finite, freq and gain > 0
+    static inline bool  IsValid(double freq, double efreq, double gain, double egain, double phase, double ephase) {
+        return std::isfinite(freq) && freq > 0 && std::isfinite(gain) && gain > 0 && std::isfinite(phase)
+            && std::isfinite(efreq) && std::isfinite(egain) && std::isfinite(ephase);
+    }
+
+    inline double      *Freq()          { return Column(kFreq); }
+    inline double      *ErrFreq()       { return Column(kErrFreq); }
+    inline double      *Gain()          { return Column(kGain); }
+    inline double      *ErrGain()       { return Column(kErrGain); }
+    inline double      *Phase()         { return Column(kPhase); }
+    inline double      *ErrPhase()      { return Column(kErrPhase); }
+    inline const double *Freq()     const { return Column(kFreq); }
+    inline const double *ErrFreq()  const { return Column(kErrFreq); }
+    inline const double *Gain()     const { return Column(kGain); }
+    inline const double *ErrGain()  const { return Column(kErrGain); }
+    inline const double *Phase()    const { return Column(kPhase); }
+    inline const double *ErrPhase() const { return Column(kErrPhase); }
+};
+
+#endif
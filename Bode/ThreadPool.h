@@ -0,0 +1,118 @@
+/**
+ * @file ThreadPool.h
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief Small work-stealing thread pool used by the batch and parallel fit engines
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef BODE_ThreadPool
+#define BODE_ThreadPool
+
+#include<atomic>
+#include<chrono>
+#include<condition_variable>
+#include<cstddef>
+#include<deque>
+#include<exception>
+#include<functional>
+#include<memory>
+#include<mutex>
+#include<thread>
+#include<vector>
+
+/**
+ * @brief Fixed set of workers, one task deque each.
+ *
+ * A worker pops from the back of its own deque and, when empty, steals from the
+ * front of the others. Tasks submitted from inside a worker go to that worker's
+ * deque, so nested parallel loops stay local. Threads blocked in Wait() or
+ * ParallelFor() run queued tasks instead of sleeping, so nesting cannot deadlock.
+ */
+class ThreadPool{
+private:
+    struct Queue_t {
+        std::mutex                          lock;
+        std::deque<std::function<void()>>   tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue_t>>   fQueues;
+    std::vector<std::thread>                fWorkers;
+    std::mutex                              fMutex;
+    std::condition_variable                 fWake;      ///> signalled on new work or stop
+    std::condition_variable                 fIdle;      ///> signalled when a task completes
+    std::atomic<std::size_t>                fQueued{0};
+    std::atomic<std::size_t>                fPending{0};///> submitted and not yet finished
+    std::atomic<unsigned>                   fNext{0};
+    bool                                    _stop = false;
+    std::mutex                              fErrorMutex;
+    std::exception_ptr                      fError;     ///> first exception of a Submit()ted task, rethrown by Wait()
+
+    void                Drain();                ///> until every submitted task has finished; never throws, fError is left for Wait()
+    bool                RunOne();               ///> run one queued task on the calling thread, if any
+    bool                TryRun(unsigned self);
+    void                WorkerLoop(unsigned id);
+
+public:
+    ThreadPool(unsigned nthreads = 0);                      ///> nthreads = 0: one per hardware thread
+    ~ThreadPool();                                          ///> finishes the queued tasks; an exception no Wait() collected is dropped
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    inline unsigned     GetNThreads() const { return fWorkers.size(); }
+    void                Submit(std::function<void()> task);
+    void                Wait();                             ///> until every submitted task has finished (not from inside a task); rethrows the first exception a task threw
+
+    /**
+     * @brief Run fn(i) for i in [0, n), in chunks of `grain` indices, and wait for them.
+     * If fn throws, the rest of that chunk is skipped, the other chunks still run,
+     * and the first exception is rethrown here once all of them are done.
+     */
+    template<class Func>
+    void                ParallelFor(std::size_t n, Func fn, std::size_t grain = 1);
+};
+
+template<class Func>
+void ThreadPool::ParallelFor(std::size_t n, Func fn, std::size_t grain){
+
+    if(n == 0) return;
+    if(grain == 0) grain = 1;
+
+    std::size_t nchunks = (n + grain - 1) / grain;
+    auto left = std::make_shared<std::atomic<std::size_t>>(nchunks);
+    auto error = std::make_shared<std::exception_ptr>();
+    auto errorlock = std::make_shared<std::mutex>();
+
+    for(std::size_t c = 0; c < nchunks; c++){
+        std::size_t first = c * grain;
+        std::size_t last = (first + grain < n)? first + grain : n;
+        Submit([first, last, left, error, errorlock, &fn](){
+            // counted down however the chunk ends, or the loop below never returns
+            struct Done_t {
+                std::atomic<std::size_t> *left;
+                ~Done_t() { left->fetch_sub(1); }
+            } done{left.get()};
+            try{
+                for(std::size_t i = first; i < last; i++) fn(i);
+            }catch(...){
+                std::lock_guard<std::mutex> lock(*errorlock);
+                if(!*error) *error = std::current_exception();
+            }
+        });
+    }
+
+    // help out until our own chunks are done
+    while(left->load() > 0){
+        if(!RunOne()){
+            std::unique_lock<std::mutex> lock(fMutex);
+            fIdle.wait_for(lock, std::chrono::microseconds(200), [&left](){ return left->load() == 0; });
+        }
+    }
+
+    if(*error) std::rethrow_exception(*error);
+}
+
+#endif
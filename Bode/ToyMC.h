@@ -0,0 +1,112 @@
+/**
+ * @file ToyMC.h
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief Toy Monte Carlo / bootstrap distributions of gain, cutoff, Q and GBW
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * Each replica is a resampled copy of one sweep, refitted on its own; the spread
+ * of the replica results replaces the covariance estimate, which is poor with the
+ * flat (type-B) full-scale errors. Toys are drawn at the level of the scope
+ * readings (V_in, V_out, T, dt, Bode/ErrorModel.h) and propagated again, so the
+ * gain and phase of one point share the noise of T as the measured ones do.
+ * Replicas are fitted in the range of the nominal fit (the last gain fit of the
+ * Bode object, or SetRange), so they vary what the measurement varied.
+ * Replicas are drawn from Philox counters
+ * (seed, replica, point), so a run gives the same numbers on any number of threads.
+ *
+ *     bode.FitGain("Q");
+ *     BodeToyMC toys(bode);
+ *     toys.Run(5000);
+ *     toys.Print();
+ *     Double_t hi = toys.Percentile(BodeToyMC::kCutoff, 0.975);
+ */
+
+#ifndef BODE_ToyMC
+#define BODE_ToyMC
+
+#include<vector>
+
+#include<Rtypes.h>
+
+#include"Bode/Models.h"
+#include"Bode/Sweep.h"
+
+class Bode;
+
+/**
+ * @brief Summary of one parameter over the converged replicas
+ */
+struct ToyStat_t {
+    Double_t            mean    = -1111;
+    Double_t            rms     = -1111;
+    Double_t            median  = -1111;
+    Double_t            lo68    = -1111;    ///> 15.87 percentile
+    Double_t            hi68    = -1111;    ///> 84.13 percentile
+    Double_t            lo95    = -1111;    ///> 2.5 percentile
+    Double_t            hi95    = -1111;    ///> 97.5 percentile
+};
+
+class BodeToyMC{
+public:
+    enum Mode_t {
+        kToy        = 0,    ///> readings at the nominal parameters plus instrument noise, propagated; without readings, noise on the propagated points
+        kBootstrap  = 1     ///> points drawn with replacement from the measured sweep
+    };
+    enum Noise_t {
+        kUniform    = 0,    ///> flat, as the full-scale reading errors are
+        kGaus       = 1
+    };
+    enum Par_t {
+        kGain       = 0,
+        kCutoff     = 1,
+        kQ          = 2,
+        kGBW        = 3,
+        kNPar       = 4
+    };
+
+private:
+    Sweep               fSweep;
+    BodeModel::Filter_t fFilter;
+    Double_t            fPar[BodeModel::kMaxPar] = {1, 1, 1};  ///> nominal parameters, toy truth and fit start
+    std::vector<Double_t> fRaw;                 ///> readings behind fSweep, as Bode::GetRaw; empty if not known
+    Axis_t              fXmin       = 0;        ///> fit range of the replicas, xmin >= xmax: whole sweep
+    Axis_t              fXmax       = 0;
+
+    Mode_t              fMode       = kToy;
+    Noise_t             fNoise      = kUniform;
+    ULong64_t           fSeed       = 0;
+    unsigned            fNThreads   = 0;        ///> 0: one per hardware thread
+    bool                _fitgain    = true;
+    bool                _fitphase   = false;
+
+    std::vector<Double_t> fValues[kNPar];       ///> per replica, -1111 where not defined
+    std::vector<char>   fStatus;                ///> per replica, fit converged
+
+    bool                DoReplica(ULong64_t replica, Sweep &toy, Double_t *out) const;
+    void                MakeReplica(ULong64_t replica, Sweep &toy) const;
+
+public:
+    BodeToyMC(const Bode &bode);                ///> sweep, readings, filter, last fitted parameters and gain fit range of bode
+    BodeToyMC(const Sweep &sweep, BodeModel::Filter_t filter, const Double_t *par, const Double_t *raw = 0);   ///> raw: 8 columns of sweep.Size() readings, or 0
+
+    inline Int_t        GetNFailed() const { return fStatus.size() - GetNGood(); }
+    Int_t               GetNGood() const;
+    ToyStat_t           GetStat(Par_t par) const;
+    inline const std::vector<Double_t> &GetValues(Par_t par) const { return fValues[par]; }   ///> all replicas, see GetStatus
+    inline const std::vector<char> &GetStatus() const { return fStatus; }
+    Double_t            Percentile(Par_t par, Double_t q) const;    ///> q in [0, 1], converged replicas only
+    void                Print() const;
+    Bool_t              Run(ULong64_t nreplicas);
+    inline void         SetComponents(bool fitgain, bool fitphase) { _fitgain = fitgain; _fitphase = fitphase; }    ///> what each replica fits (default: gain)
+    inline void         SetMode(Mode_t mode) { fMode = mode; }
+    inline void         SetNoise(Noise_t noise) { fNoise = noise; }
+    inline void         SetNThreads(unsigned nthreads) { fNThreads = nthreads; }
+    inline void         SetRange(Axis_t xmin, Axis_t xmax) { fXmin = xmin; fXmax = xmax; }   ///> only points in [xmin, xmax] are fitted, xmin >= xmax: whole sweep
+    inline void         SetSeed(ULong64_t seed) { fSeed = seed; }
+    Bool_t              WriteResults(const char *filename) const;   ///> tab separated, one line per replica
+};
+
+#endif
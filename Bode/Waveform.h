@@ -0,0 +1,65 @@
+/**
+ * @file Waveform.h
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief Gain, phase and frequency from a raw two-channel scope capture
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * The capture (channel 1 = V_in, channel 2 = V_out) is streamed in fixed-size
+ * blocks, never held in memory, and read up to three times:
+ *   1. mean and range of both channels (and the time span, for text with times);
+ *   2. rising crossings of V_in, a straight-line fit of crossing time vs index
+ *      gives the period and its error (skipped if the frequency is given);
+ *   3. lock-in (single-bin DFT, as Goertzel) of both channels at that frequency
+ *      over a whole number of periods, giving complex amplitudes A_in, A_out;
+ *      H = A_out/A_in, the residual power gives the amplitude errors.
+ * The phase is arg(H), the convention of the models and of the 8-column files.
+ */
+
+#ifndef BODE_Waveform
+#define BODE_Waveform
+
+#include<cstddef>
+#include<string>
+
+/**
+ * @brief How a capture file is laid out
+ */
+struct WaveformFormat_t {
+    enum Type_t {
+        kText       = 0,    ///> whitespace separated "V_in V_out" or "t V_in V_out" lines, '#' comments
+        kFloat32    = 1,    ///> binary, interleaved V_in, V_out
+        kFloat64    = 2,
+        kInt16      = 3     ///> binary, interleaved raw ADC counts, see scale/offset
+    };
+    Type_t              type        = kText;
+    double              rate        = 0;        ///> samples/s; text with a time column may leave it 0
+    bool                hastime     = false;    ///> text only, first column is time [s]
+    double              scale[2]    = {1, 1};   ///> volts per unit (count) for V_in, V_out
+    double              offset[2]   = {0, 0};   ///> volts added after scaling
+};
+
+struct WaveformResult_t {
+    double              freq        = 0;
+    double              efreq       = 0;        ///> 0 when the frequency was given
+    double              gain        = 0;
+    double              egain       = 0;
+    double              phase       = 0;        ///> arg(A_out/A_in), rad in (-pi, pi]
+    double              ephase      = 0;
+    double              ampIn       = 0;        ///> V, amplitude (not peak-to-peak)
+    double              ampOut      = 0;
+    std::size_t         nsamples    = 0;        ///> in the capture
+    std::size_t         nperiods    = 0;        ///> whole periods used by the lock-in
+};
+
+/**
+ * @brief Analyze one capture. frequency > 0: the excitation is known, pass 2 is skipped.
+ * @return false with a reason in error (if given) when the file cannot be read
+ * or holds less than one period of a signal
+ */
+bool AnalyzeWaveform(const char *filename, const WaveformFormat_t &format, double frequency,
+                     WaveformResult_t &result, std::string *error = 0);
+
+#endif
@@ -0,0 +1,93 @@
+/**
+ * @file WindowScan.h
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief Stability of cutoff and Q against the frequency window of the fit
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * The sweep is refitted, in parallel, on every window obtained by dropping up to
+ * SetTrim(nlow, nhigh) points from the low and high ends of the nominal range
+ * (that of the last gain fit of the Bode object, or SetRange; the whole sweep by
+ * default). Each window result is compared with the fit on the nominal range: since the window data are a subset of the
+ * full data, the expected spread of the difference is sqrt(|err_w^2 - err_full^2|)
+ * (floored to a tenth of err_w). A pull above the threshold on cutoff or Q means
+ * the result depends on where the sweep stops, as with parasitic high-frequency
+ * behaviour, and the sweep is not stable.
+ *
+ *     bode.FitGain("Q");
+ *     BodeWindowScan scan(bode);
+ *     scan.Run();
+ *     if(!scan.IsStable()) scan.Print();
+ */
+
+#ifndef BODE_WindowScan
+#define BODE_WindowScan
+
+#include<vector>
+
+#include<Rtypes.h>
+
+#include"Bode/Models.h"
+#include"Bode/Sweep.h"
+
+class Bode;
+
+/**
+ * @brief One refit, -1111 marks parameters the filter does not have
+ */
+struct FitWindow_t {
+    Double_t            xmin        = 0;
+    Double_t            xmax        = 0;
+    Int_t               trimlow     = 0;        ///> points dropped at the low end
+    Int_t               trimhigh    = 0;        ///> points dropped at the high end
+    Int_t               npoints     = 0;
+    Bool_t              status      = false;    ///> fit converged
+    Double_t            par[BodeModel::kMaxPar] = {-1111, -1111, -1111};
+    Double_t            err[BodeModel::kMaxPar] = {-1111, -1111, -1111};
+    Double_t            pull[BodeModel::kMaxPar] = {0, 0, 0};  ///> vs the full range, see above
+    Double_t            chi2        = -1;
+    Int_t               ndf         = -1;
+};
+
+class BodeWindowScan{
+private:
+    Sweep               fSweep;
+    BodeModel::Filter_t fFilter;
+    Double_t            fPar[BodeModel::kMaxPar] = {1, 1, 1};  ///> fit start for every window
+    Axis_t              fXmin       = 0;        ///> nominal range, the windows are trimmed inside it; xmin >= xmax: whole sweep
+    Axis_t              fXmax       = 0;
+
+    Int_t               fTrimLow    = 2;
+    Int_t               fTrimHigh   = 8;
+    Double_t            fThreshold  = 3;
+    unsigned            fNThreads   = 0;        ///> 0: one per hardware thread
+    bool                _fitgain    = true;
+    bool                _fitphase   = false;
+
+    FitWindow_t         fFull;                  ///> nominal range, the reference
+    std::vector<FitWindow_t> fWindows;          ///> fFull excluded
+
+    void                DoWindow(FitWindow_t &window) const;
+
+public:
+    BodeWindowScan(const Bode &bode);               ///> sweep, filter, last fitted parameters and gain fit range of bode
+    BodeWindowScan(const Sweep &sweep, BodeModel::Filter_t filter, const Double_t *par);
+
+    inline const FitWindow_t &GetFull() const { return fFull; }
+    Double_t            GetMaxPull(Int_t par) const;    ///> largest |pull| over converged windows
+    Double_t            GetSpread(Int_t par) const;     ///> rms of the window results, in units of the full-range error
+    inline const std::vector<FitWindow_t> &GetWindows() const { return fWindows; }
+    Bool_t              IsStable() const;               ///> full fit converged, no cutoff (or Q) pull above threshold
+    void                Print() const;
+    Bool_t              Run();
+    inline void         SetComponents(bool fitgain, bool fitphase) { _fitgain = fitgain; _fitphase = fitphase; }    ///> what each window fits (default: gain)
+    inline void         SetNThreads(unsigned nthreads) { fNThreads = nthreads; }
+    inline void         SetRange(Axis_t xmin, Axis_t xmax) { fXmin = xmin; fXmax = xmax; }   ///> nominal range, xmin >= xmax: whole sweep
+    inline void         SetThreshold(Double_t threshold) { fThreshold = threshold; }
+    inline void         SetTrim(Int_t nlow, Int_t nhigh) { fTrimLow = nlow; fTrimHigh = nhigh; }
+    Bool_t              WriteResults(const char *filename) const;   ///> tab separated, one line per window
+};
+
+#endif
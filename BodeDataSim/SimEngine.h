@@ -12,14 +12,15 @@
 #ifndef BODEDATASIM_SimEngine
 #define BODEDATASIM_SimEngine
 
+#include<vector>
+
 #include<Rtypes.h>
 #include<RtypesCore.h>
 
-#include<TFormula.h>
-#include<TRandom.h>
-
 #include"Logger.h"
 #include"Bode/Analysis.h"
+#include"Bode/Live.h"
+#include"Bode/Models.h"
 
 typedef TString System_t;
 
@@ -33,13 +34,29 @@ private:
     Double_t            gGain   = -99999;
     Double_t            gQ      = -99999;
 
-    const char         *_gainformula  = ""; 
-    const char         *_phaseformula = "";
+    BodeModel::Filter_t fFilter = BodeModel::kUnknown;  ///> compiled filter model, see Bode/Models.h
 
     Bool_t              _islowhighpass = true;
 
-    TRandom            *gen;    ///> random generator
-    TFormula           *fFunctionFilter;
+    // sweep settings
+    Double_t            fFmin       = 10;       ///> lowest frequency [Hz]
+    Double_t            fFmax       = 1e5;      ///> highest frequency [Hz]
+    Int_t               fNpoints    = 50;       ///> points, log spaced in [fFmin, fFmax]
+    Double_t            fVin        = 1;        ///> input amplitude [V]
+    Double_t            fNoiseScale = 1;        ///> reading noise, in units of the full-scale error bound
+
+    // slow instrument noise, correlated along the sweep (points in acquisition order), see Bode/Noise.h
+    Double_t            fDrift      = 0;        ///> amplitude drift, relative rms; 0: none
+    Double_t            fDriftAlpha = 1;        ///> its spectrum 1/f^alpha: 1 flicker, 2 random walk
+    Double_t            fDriftCorrelation = 0;  ///> V_in/V_out drift correlation, 1: common source drift (cancels in the gain)
+    Double_t            fTimeDrift  = 0;        ///> dt drift, rms in units of the period
+    Int_t               fADCBits    = 0;        ///> voltage readings quantized to 8 divisions/2^bits of their full scale; 0: not quantized
+
+    template<class Model>
+    void                DoGenerate(ULong64_t sweep, Double_t *rows) const;
+    template<class Model>
+    void                DoPoint(Double_t f, ULong64_t point, ULong64_t sweep, Double_t *row, const Double_t *drift = 0) const;   ///> drift: V_in, V_out, dt of this point
+    void                ToSweep(const std::vector<Double_t> &rows, Sweep &sweep) const;
 
     enum {
         lowpass     = 244089597,    // "lowpass"
@@ -50,19 +67,30 @@ private:
 
 public:
     SimEngine();
-    Bool_t              DataSim(const char *filename = "datasim.txt");
-    void                GenLowNoise();
-    void                GenHighNoise();
+    Bool_t              DataSim(const char *filename = "datasim.txt", ULong64_t sweep = 0);    ///> write sweep number `sweep` in the 8-column format
+    Bool_t              DataSimArchive(const char *filename, ULong64_t nsweeps, bool deflate = false, unsigned nthreads = 0);   ///> sweeps "sweep_<n>" with their readings, see Bode/Archive.h
+    Bool_t              DataSimBatch(const char *pattern, ULong64_t nsweeps, unsigned nthreads = 0);  ///> pattern with one %llu, e.g. "sim_%llu.txt"
+    Bool_t              Fill(Bode &bode, ULong64_t sweep = 0) const;   ///> stream sweep number `sweep` straight into bode
+    void                GenLowNoise();      ///> readings scattered over a quarter of the full-scale error bound
+    void                GenHighNoise();     ///> readings scattered over the whole full-scale error bound (default)
+    std::vector<Double_t> Generate(ULong64_t sweep = 0) const;         ///> rows, 8 values each, fNpoints of them
+    Bool_t              GenerateSweeps(ULong64_t first, ULong64_t nsweeps, std::vector<Sweep> &sweeps, unsigned nthreads = 0) const;   ///> sweeps first.. in parallel, propagated as ReadInput does; same result for any nthreads
+    inline Int_t        GetNpoints() const { return fNpoints; }
+    Bool_t              Measure(Double_t freq, ULong64_t point, Double_t *row, ULong64_t sweep = 0) const;    ///> one 8-reading row at any frequency; point numbers the noise draw; no drift (it needs the whole sweep)
+    Bool_t              Stream(BodeLive &live, ULong64_t sweep = 0, Double_t rate = 0) const;   ///> stand-in instrument: one producer, a point every 1/rate s (0: as fast as the queue takes them)
     void                SetCutoff(Double_t cutoff)  { gCutoff = cutoff; }
+    inline void         SetDrift(Double_t rms, Double_t alpha = 1, Double_t correlation = 0) { fDrift = rms; fDriftAlpha = alpha; fDriftCorrelation = correlation; }   ///> 1/f^alpha drift of V_in and V_out along the sweep
+    void                SetFrequencyRange(Double_t fmin, Double_t fmax, Int_t npoints);
     void                SetGain(Double_t gain)      { gGain = gain; }
+    inline void         SetNoiseScale(Double_t scale) { fNoiseScale = scale; }
     void                SetQ(Double_t Q)             { gQ = Q; }
+    inline void         SetQuantization(Int_t bits = 8) { fADCBits = bits; }     ///> scope ADC resolution; 0: off
+    inline void         SetSeed(ULong_t s)          { seed = s; }
+    inline void         SetTimeDrift(Double_t rms)  { fTimeDrift = rms; }       ///> dt drift, same spectrum as SetDrift, rms in periods
+    inline void         SetVin(Double_t vin)        { fVin = vin; }
     void                SetFilterType(System_t filter = "lowpass");
     ~SimEngine();
 };
 
-SimEngine::~SimEngine(){
-    fprintf(stderr, "%s\n", Logger::warning("Deleted obj. SimEngine"));
-}
-
 
 #endif
\ No newline at end of file
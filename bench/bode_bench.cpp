@@ -0,0 +1,168 @@
+/**
+ * @file bode_bench.cpp
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief Stage timings (read, functions, fits, plot) on synthetic sweeps
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * Usage: bode_bench [--min-points N] [--max-points N] [--repeat N] [--full]
+ *                   [--filters lowpass,highpass,bandpass] [--tmpdir DIR] [--no-plot]
+ *
+ * By default 10 to 10^4 points, 3 repeats, a few seconds; --full runs up to 10^7
+ * points, 5 repeats (minutes, and gigabytes in tmpdir). A read or fit that fails
+ * stops the run with exit status 1: its timings would mean nothing.
+ *
+ * Writes one JSON object per line on stdout, one per (filter, points, stage), e.g.
+ * {"filter":"bandpass","npoints":1000,"stage":"FitGain","repeat":5,"min_s":...,"median_s":...,"max_s":...}
+ * so runs can be diffed or loaded as a table. Progress goes to stderr.
+ */
+
+#include<algorithm>
+#include<chrono>
+#include<cstdio>
+#include<cstdlib>
+#include<cstring>
+#include<functional>
+#include<map>
+#include<string>
+#include<vector>
+
+#include<TROOT.h>
+#include<TError.h>
+
+#include"Bode/Analysis.h"
+#include"BodeDataSim/SimEngine.h"
+
+namespace {
+
+    struct Options_t {
+        long                        minpoints   = 10;
+        long                        maxpoints   = 10000;
+        int                         repeat      = 3;
+        bool                        plot        = true;
+        std::string                 tmpdir      = "/tmp";
+        std::vector<std::string>    filters     = {"lowpass", "highpass", "bandpass"};
+    };
+
+    double seconds(std::function<void()> fn){
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void report(const char *filter, long npoints, const char *stage, std::vector<double> times){
+        std::sort(times.begin(), times.end());
+        printf("{\"filter\":\"%s\",\"npoints\":%ld,\"stage\":\"%s\",\"repeat\":%zu,"
+               "\"min_s\":%.9g,\"median_s\":%.9g,\"max_s\":%.9g}\n",
+               filter, npoints, stage, times.size(), times.front(), times[times.size()/2], times.back());
+        fflush(stdout);
+    }
+
+    std::vector<std::string> split(const char *list){
+        std::vector<std::string> out;
+        std::string item;
+        for(const char *c = list; ; c++){
+            if(*c == ',' || *c == '\0'){
+                if(!item.empty()) out.push_back(item);
+                item.clear();
+                if(*c == '\0') break;
+            }else{
+                item += *c;
+            }
+        }
+        return out;
+    }
+
+    bool parse(int argc, char **argv, Options_t &opt){
+        for(int i = 1; i < argc; i++){
+            const char *arg = argv[i];
+            bool hasval = (i + 1 < argc);
+            if(strcmp(arg, "--min-points") == 0 && hasval)     opt.minpoints = atol(argv[++i]);
+            else if(strcmp(arg, "--max-points") == 0 && hasval) opt.maxpoints = atol(argv[++i]);
+            else if(strcmp(arg, "--repeat") == 0 && hasval)    opt.repeat = atoi(argv[++i]);
+            else if(strcmp(arg, "--filters") == 0 && hasval)   opt.filters = split(argv[++i]);
+            else if(strcmp(arg, "--tmpdir") == 0 && hasval)    opt.tmpdir = argv[++i];
+            else if(strcmp(arg, "--no-plot") == 0)             opt.plot = false;
+            else if(strcmp(arg, "--full") == 0){               opt.maxpoints = 10000000; opt.repeat = 5; }
+            else{
+                fprintf(stderr, "usage: %s [--min-points N] [--max-points N] [--repeat N] [--full] "
+                    "[--filters a,b] [--tmpdir DIR] [--no-plot]\n", argv[0]);
+                return false;
+            }
+        }
+        return opt.repeat > 0 && opt.minpoints > 0 && opt.maxpoints >= opt.minpoints;
+    }
+
+}
+
+int main(int argc, char **argv){
+
+    Options_t opt;
+    if(!parse(argc, argv, opt)) return 1;
+
+    gROOT->SetBatch(true);
+    gErrorIgnoreLevel = kWarning;
+
+    // (gain, cutoff, Q) of the simulated device
+    const Double_t truth[3] = {2, 3e3, 5};
+
+    for(const std::string &filter: opt.filters){
+        for(long npoints = opt.minpoints; npoints <= opt.maxpoints; npoints *= 10){
+
+            fprintf(stderr, "bode_bench: %s, %ld points\n", filter.c_str(), npoints);
+
+            SimEngine sim;
+            sim.SetFilterType(filter.c_str());
+            sim.SetGain(truth[0]);
+            sim.SetCutoff(truth[1]);
+            sim.SetQ(truth[2]);
+            sim.SetFrequencyRange(10, 1e6, npoints);
+            sim.GenLowNoise();
+
+            std::string datafile = opt.tmpdir + "/bode_bench_" + filter + "_" + std::to_string(npoints) + ".txt";
+            std::string plotfile = opt.tmpdir + "/bode_bench_" + filter + "_" + std::to_string(npoints) + ".pdf";
+            if(!sim.DataSim(datafile.c_str())) return 1;
+
+            std::map<std::string, std::vector<double>> times;
+            const char *failed = 0;
+            for(int r = 0; r < opt.repeat && !failed; r++){
+                Bode bode(filter.c_str());
+                bool ok = true;
+
+                // ReadInput includes a SetFunctions call, timed again on its own below
+                times["ReadInput"].push_back(seconds([&](){ ok = bode.ReadInput(datafile.c_str()); }));
+                if(!ok){ failed = "ReadInput"; break; }
+                times["SetFunctions"].push_back(seconds([&](){ bode.SetFunctions(); }));
+
+                // slightly off seeds, as a user would give them
+                bode.SetParGain(1.1*truth[0], 0.9*truth[1], 1.2*truth[2]);
+                bode.SetParPhase(1.1*truth[0], 0.9*truth[1], 1.2*truth[2]);
+                times["FitGain"].push_back(seconds([&](){ ok = bode.FitGain("Q"); }));
+                if(!ok){ failed = "FitGain"; break; }
+                times["FitPhase"].push_back(seconds([&](){ ok = bode.FitPhase("Q"); }));
+                if(!ok){ failed = "FitPhase"; break; }
+
+                if(opt.plot) times["Plot"].push_back(seconds([&](){ bode.Plot(plotfile.c_str()); }));
+            }
+
+            if(failed){
+                fprintf(stderr, "bode_bench: %s failed for %s, %ld points\n", failed, filter.c_str(), npoints);
+                remove(datafile.c_str());
+                remove(plotfile.c_str());
+                return 1;
+            }
+
+            const char *stages[] = {"ReadInput", "SetFunctions", "FitGain", "FitPhase", "Plot"};
+            for(const char *stage: stages){
+                if(!times[stage].empty()) report(filter.c_str(), npoints, stage, times[stage]);
+            }
+
+            remove(datafile.c_str());
+            remove(plotfile.c_str());
+        }
+    }
+
+    return 0;
+}
@@ -9,7 +9,11 @@
  * 
  */
 
+#include<algorithm>
+#include<atomic>
 #include<iostream>
+#include<limits>
+#include<mutex>
 #include<vector>
 
 #include<TBox.h>
@@ -22,18 +26,32 @@
 #include<TLegend.h>
 #include<TLine.h>
 #include<TStyle.h>
+#include<Fit/Fitter.h>
 
 #include"Bode/Analysis.h"
+#include"Bode/Chi2.h"
+#include"Bode/Core.h"
+#include"Bode/Estimate.h"
+#include"Bode/FitCache.h"
+#include"Bode/FitFCN.h"
+#include"Bode/Profile.h"
+#include"Bode/Propagate.h"
+#include"Bode/ThreadPool.h"
 #include"ErrorAnalysis.h"
 #include"LabPlot.h" // set_atlas_style() called from here
 #include"Logger.h"
 
+namespace {
+    std::atomic<ULong_t> gBodeCounter(0);   // gives each Bode its own ROOT object names
+    std::once_flag       gStyleOnce;        // gStyle is global, set it up only once
+}
+
 Bode::Bode(System_t sys){
     fSystem = sys;
-    // set_atlas_style(tsize);
+    fId = gBodeCounter++;
+    // set_atlas_style(tsize): left to the first plot, see SetStyle
 
     SetSystem(sys);
-    set_atlas_style(tsize);
 
     // We cant do much more, since its impossible to allocate memory for graphs, use functions!
 }
@@ -41,47 +59,87 @@ Bode::Bode(System_t sys){
 
 Bode::Bode(System_t sys, const char *filename, Option_t *option){
     fSystem = sys;
-    // set_atlas_style(tsize);
+    fId = gBodeCounter++;
+    // set_atlas_style(tsize): left to the first plot, see SetStyle
 
     SetSystem(sys);
 
     ReadInput(filename, option);
-    set_atlas_style(tsize);
 
 }
 
+void Bode::SetStyle(Size_t tsize){
+    std::call_once(gStyleOnce, [tsize](){ set_atlas_style(tsize); });
+}
+
 void Bode::Plot(const char *filename, bool plotphase, bool plotgain){
 
-    TCanvas *fFigure = new TCanvas("fFigure", "", 800, 600);
-    TLine *cutoff_line = new TLine();
+    BodeStats::StageTimer timer(fStats, BodeStats::kPlot);
+
+    SetStyle(tsize);
+    MakeGraphs();
+
+    // styles first, the curves copy them when they are made
+    fGainFit->SetLineColor(kBlack);
+    fGain->SetMarkerStyle(20);
+    fGain->SetMarkerSize(0.8);
+    fPhase->SetMarkerStyle(20);
+    fPhase->SetMarkerSize(0.8);
+    fPhase->SetLineColor(kRed);
+    fPhase->SetMarkerColor(kRed);
+    fPhaseFit->SetMarkerColor(kRed);
+    fPhaseFit->SetLineStyle(kDashed);
+
+    // made on the first call; later calls clear and draw them again. Only what
+    // the pads draw themselves (the cutoff line copies) is deleted by Clear()
+    if(!fFigure){
+        fFigure.reset(new TCanvas(TString::Format("fFigure_%lu", fId), "", 800, 600));
+        fFigure->cd();
+        fGainPad.reset(new TPad(TString::Format("fGainPad_%lu", fId), "", 0, 0, 1, 1));
+        fPhasePad.reset(new TPad(TString::Format("fPhasePad_%lu", fId), "", 0, 0, 1, 1));
+        fResidualPad.reset(new TPad(TString::Format("fResidualPad_%lu", fId), "", 0, 0, 1, 0.3));
+        fLegend.reset(new TLegend(legendX1, legendY1, legendX2, legendY2));
+        fCutoffLine.reset(new TLine());
+    }
+    fFigure->Clear();
+    fGainPad->Clear();
+    fPhasePad->Clear();
+    fResidualPad->Clear();
+    fLegend->Clear();
+    fPhaseAxis.reset();
+
+    TLine *cutoff_line = fCutoffLine.get();
     cutoff_line->SetLineStyle(kDashed);
 
     fFigure->cd();
 
-    if(plotgain && plotphase) gStyle->SetPadRightMargin(0.16);
-
-    TLatex *text = new TLatex();
-    text->SetTextAngle(90);
-    TLegend *legend = new TLegend(legendX1, legendY1, legendX2, legendY2);
+    TLegend *legend = fLegend.get();
     legend->SetFillColorAlpha(0, 0.75);
     legend->SetTextSize(20);
 
     legend->SetHeader(Form("#bf{Bode visualization} #it{%s}", label));
     
-    fFigure->cd();
-    TPad *fGainPad = new TPad("fGainPad", "", 0, 0, 1, 1);
     fGainPad->SetLogx();
     fGainPad->SetLogy();
 
-    fFigure->cd();
-    TPad *fPhasePad = new TPad("fPhasePad", "", 0, 0, 1, 1);
     fPhasePad->SetLogx();
     fPhasePad->SetFillStyle(4000);
 
+    // room for the phase axis, set on the pads rather than on the global gStyle
+    if(plotgain && plotphase){
+        fGainPad->SetRightMargin(0.16);
+        fPhasePad->SetRightMargin(0.16);
+    }
 
-    fFigure->cd();
+    // the pulls take the bottom 30% of the canvas
+    Double_t ylow = _residualOn? 0.3 : 0;
+    fGainPad->SetPad(0, ylow, 1, 1);
+    fPhasePad->SetPad(0, ylow, 1, 1);
+    fGainPad->SetBottomMargin(_residualOn? 0.03 : gStyle->GetPadBottomMargin());
+    fPhasePad->SetBottomMargin(_residualOn? 0.03 : gStyle->GetPadBottomMargin());
 
-    TGaxis *axis;
+
+    fFigure->cd();
 
     if(plotgain){
 
@@ -90,8 +148,8 @@ void Bode::Plot(const char *filename, bool plotphase, bool plotgain){
         fGainPad->cd();
 
         fGain->Draw("ap");
-        if(_hasfittedgain) { fGainFit->Draw("same"); }
-        legend->AddEntry(fGain, "Gain", "LPE");
+        if(_hasfittedgain && _drawgainfit) { DrawCurve(fGainFit.get(), BodeModel::kGain, true, fGainGOption, fGainCurve); }
+        legend->AddEntry(fGain.get(), "Gain", "LPE");
         // text->DrawLatex(gCutoff, fGainPad->GetUymin(), "cutoff");
         cutoff_line->DrawLine(gCutoff, fGainPad->GetUymin(), gCutoff, 
         fGainPad->GetUymax()-0.5*(fGainPad->GetUymax()-fGainPad->GetUymax())/0.79);
@@ -103,9 +161,8 @@ void Bode::Plot(const char *filename, bool plotphase, bool plotgain){
             Double_t xmin = fGainPad->GetUxmin();
             Double_t xmax = fGainPad->GetUxmax();
             Double_t dx = (xmax - xmin) / 0.68; // 10 percent margins left and right
-            Double_t ymin = TMath::MinElement(fPhase->GetN(), fPhase->GetY());
-            Double_t ymax = TMath::MaxElement(fPhase->GetN(), fPhase->GetY());
-            std::cout << "Phase range: [" << ymin << ", " << ymax << "]" << std::endl;
+            Double_t ymin = fPlotRange.phase[0];
+            Double_t ymax = fPlotRange.phase[1];
             Double_t dy = (ymax - ymin) / 0.79; // 10 percent margins top and bottom
             fPhasePad->Range(xmin-0.16*dx, ymin-0.16*dy, xmax+0.16*dx, ymax+0.05*dy);
 
@@ -114,9 +171,9 @@ void Bode::Plot(const char *filename, bool plotphase, bool plotgain){
             fPhasePad->cd();
 
             fPhase->Draw("p");
-            if(_hasfittedphase) { fPhaseFit->Draw("same"); }
+            if(_hasfittedphase && _drawphasefit) { DrawCurve(fPhaseFit.get(), BodeModel::kPhase, false, fPhaseGOption, fPhaseCurve); }
             fPhase->GetYaxis()->SetRangeUser(ymin-0.16*dy+0.1*dy, ymax+0.05*dy+0.1*dy);
-            legend->AddEntry(fPhase, "Phase", "LPE");
+            legend->AddEntry(fPhase.get(), "Phase", "LPE");
             gPad->Update();
 
             Style_t tfont = fGain->GetHistogram()->GetYaxis()->GetTitleFont();
@@ -124,7 +181,8 @@ void Bode::Plot(const char *filename, bool plotphase, bool plotgain){
             Style_t lfont = fGain->GetHistogram()->GetYaxis()->GetLabelFont();
             Float_t lsize = fGain->GetHistogram()->GetYaxis()->GetLabelSize();
 
-            axis = new TGaxis(std::pow(10, xmax), ymin, std::pow(10, xmax), ymax, ymin, ymax, 510, "+L");
+            fPhaseAxis.reset(new TGaxis(std::pow(10, xmax), ymin, std::pow(10, xmax), ymax, ymin, ymax, 510, "+L"));
+            TGaxis *axis = fPhaseAxis.get();
             axis->SetTitle("Phase [rad]");
             axis->CenterTitle();
             axis->SetTitleOffset(1.5);
@@ -142,21 +200,11 @@ void Bode::Plot(const char *filename, bool plotphase, bool plotgain){
         fPhasePad->cd();
 
         fPhase->Draw("ap");
-        if(_hasfittedphase) { fPhaseFit->Draw("same"); }
-        legend->AddEntry(fPhase, "Phase", "LPE");
+        if(_hasfittedphase && _drawphasefit) { DrawCurve(fPhaseFit.get(), BodeModel::kPhase, false, fPhaseGOption, fPhaseCurve); }
+        legend->AddEntry(fPhase.get(), "Phase", "LPE");
         gPad->Update();
     }
 
-    fGainFit->SetLineColor(kBlack);
-    fGain->SetMarkerStyle(20);
-    fGain->SetMarkerSize(0.8);
-    fPhase->SetMarkerStyle(20);
-    fPhase->SetMarkerSize(0.8);
-    fPhase->SetLineColor(kRed);
-    fPhase->SetMarkerColor(kRed);
-    fPhaseFit->SetMarkerColor(kRed);
-    fPhaseFit->SetLineStyle(kDashed);
-
     fFigure->cd();
     fGainPad->Draw();
     fGainPad->Modified();
@@ -168,8 +216,33 @@ void Bode::Plot(const char *filename, bool plotphase, bool plotgain){
 
     legend->Draw();
 
+    if(_residualOn) DrawPulls(plotgain, plotphase);
+
     fFigure->Draw();
-    fFigure->Print((strcmp(filename, "") == 0)? Form("%s.pdf", fFigure->GetName()):filename);
+    fFigure->Print((strcmp(filename, "") == 0)? "fFigure.pdf":filename);
+}
+
+BodePlot_t Bode::GetPlotData(bool plotphase, bool plotgain) const {
+
+    BodePlot_t plot;
+    plot.sweep = fSweep;
+    plot.filter = fFilter;
+    plot.hasGainFit = _hasfittedgain && _drawgainfit;
+    plot.hasPhaseFit = _hasfittedphase && _drawphasefit;
+    plot.goptGain = fGainGOption.Data();
+    plot.goptPhase = fPhaseGOption.Data();
+    plot.cutoff = gCutoff;
+    plot.label = label;
+    plot.plotGain = plotgain;
+    plot.plotPhase = plotphase;
+    plot.lodBins = fLODBins;
+    plot.lodOutlier = fLODOutlier;
+
+    NPar_t npar = BodeModel::NPar(fFilter);
+    if(fGainFit) std::copy(fGainFit->GetParameters(), fGainFit->GetParameters() + npar, plot.parGain);
+    if(fPhaseFit) std::copy(fPhaseFit->GetParameters(), fPhaseFit->GetParameters() + npar, plot.parPhase);
+
+    return plot;
 }
 
 void Bode::PlotGain(const char *filename){
@@ -180,84 +253,133 @@ void Bode::PlotPhase(const char *filename){
     Plot(filename, true, false);
 }
 
-double get_VRangeErr(double errPercent, int partitions, double range1){return errPercent * partitions *  range1;}
-double get_TRangeErr(double range1, double errPercent = 0.0016, int partition = 10){return range1 * errPercent * partition;}
-double get_HErr(double Vin, double Vout, double eVin, double eVout){ return sqrt(pow(eVout / Vin, 2) + pow(eVin * Vout / pow(Vin, 2), 2));}
-double get_phi(double T, double dt){return 2 * M_PI * dt / T;}
-double get_phiErr(double T, double dt, double eT, double edt){return 2 * M_PI * sqrt(pow(edt/T, 2) + pow(dt * eT/(pow(T, 2)), 2));}
-
-
 Bool_t Bode::ReadInput(const char *filename, Option_t *option){
 
-    std::ifstream data(filename);
-
-    std::vector<double> tmpfreq, tmpfreqerr, tmpgain, tmpgainerr, tmpphase, tmpphaseerr;
-    double Vin, fsVin, Vout, fsVout, T, fsT, dt, fsdt;
+    BodeStats::StageTimer timer(fStats, BodeStats::kReadInput);
 
+    std::string error;
+    if(!ReadSweep(filename, fSweep, &fRaw, &fMalformed, &error)){
+        printf("%s", Logger::error(error.c_str()));
+        return false;
+    }
+    std::size_t n = fSweep.Size();
 
-    for(int i=0; data >> Vin >> fsVin >> Vout >> fsVout >> T >> fsT >> dt >> fsdt ; i++){
-        
-        double eVin, eVout;
-        if(fsVin<=0.01){
-            eVin = get_VRangeErr(0.045, 8, fsVin)/sqrt(3);
-        }else{
-            eVin = get_VRangeErr(0.035, 8, fsVin)/sqrt(3);
-        }
-        if(fsVout<=0.01){
-            eVout = get_VRangeErr(0.045, 8, fsVout)/sqrt(3);
-        }else{
-            eVout = get_VRangeErr(0.035, 8, fsVout)/sqrt(3);
-        }
-        double eT = get_TRangeErr(fsT)/sqrt(3);
-        double edt = get_TRangeErr(fsdt)/sqrt(3);
-
-        tmpfreq.push_back(1/T);
-        tmpfreqerr.push_back(eT/pow(T, 2));
-        tmpgain.push_back(Vout/Vin);
-        tmpgainerr.push_back(get_HErr(Vin, Vout, eVin, eVout));
-        tmpphase.push_back(get_phi(T, dt));
-        tmpphaseerr.push_back(get_phiErr(T, dt, eT, edt));
+    if(fStats.IsEnabled()){
+        fStats.Get(BodeStats::kReadInput).points += n;
+        fStats.Get(BodeStats::kReadInput).rejected += fMalformed.size();
+    }
+    if(!fMalformed.empty()){
+        fprintf(stderr, "%s\n", Logger::warning(Form("%s: skipped %zu malformed line(s), first at line %zu (%s)",
+            filename, fMalformed.size(), fMalformed.front().line, fMalformed.front().reason.c_str())));
     }
 
-    SetFreqVec(tmpfreq, tmpfreqerr);
-    SetPhaseVec(tmpphase, tmpphaseerr);
-    SetGainVec(tmpgain, tmpgainerr);
     SetFunctions();
 
     return true;
 }
 
-Bool_t Bode::SetFreqVec(std::vector<Double_t> Freq, std::vector<Double_t> ErrFreq){
-    fPointFreq = Freq;
-    fPErrFreq = ErrFreq;
+void Bode::Reset(System_t sys){
 
-    // fPointFreq = new TVectorD(Freq.size(), Freq.data());
-    // fPErrFreq = new TVectorD(ErrFreq.size(), ErrFreq.data());
+    if(sys.Length() > 0) SetSystem(sys);
 
-    if (fNpoints == -1111){
-        fNpoints = Freq.size();
-    }else{
-        if(Freq.size() != fNpoints){
-            printf("%s", Logger::error("freq. array size does not match previous array size."));
-            return false;
+    // capacities (sweep, readings) and ROOT objects stay allocated
+    fSweep.Clear();
+    fRaw.clear();
+    fMalformed.clear();
+    fGainResult = ROOT::Fit::FitResult();
+    fPhaseResult = ROOT::Fit::FitResult();
+    fCorrelatedResult = ROOT::Fit::FitResult();
+    fGainGOption = "";
+    fPhaseGOption = "";
+    fGainRange[0] = fGainRange[1] = fPhaseRange[0] = fPhaseRange[1] = 0;
+    fCache = 0;
+    fStats.Reset();
+
+    gGBW = gErrGBW = gCutoff = gErrCutoff = gGain = gErrGain = gQ = gErrQ = -1111;
+    _hasfittedgain = _hasfittedphase = false;
+    _drawgainfit = _drawphasefit = true;
+
+    SetFunctions();
+}
+
+void Bode::DrawPulls(bool plotgain, bool plotphase){
+
+    fFigure->cd();
+    fResidualPad->SetLogx();
+    fResidualPad->SetTopMargin(0.03);
+    fResidualPad->SetBottomMargin(0.35);
+    if(plotgain && plotphase) fResidualPad->SetRightMargin(0.16);
+    fResidualPad->Draw();
+    fResidualPad->cd();
+
+    // on the plotted points, so a reduced (SetLOD) sweep stays cheap here too
+    const Sweep &plot = fPlotSweep;
+    Int_t n = plot.Size();
+    fCurveY.resize(n);
+    bool first = true;
+    struct { bool on; BodeModel::Component_t comp; TF1 *func; std::unique_ptr<TGraph> *graph; Color_t color; } parts[2] = {
+        {plotgain && _hasfittedgain, BodeModel::kGain, fGainFit.get(), &fGainPull, kBlack},
+        {plotphase && _hasfittedphase, BodeModel::kPhase, fPhaseFit.get(), &fPhasePull, kRed}
+    };
+    Double_t range = 3;
+    for(auto &part: parts){
+        if(!part.on || n == 0) continue;
+        ComputePulls(fFilter, part.comp, plot, part.func->GetParameters(), 0, fCurveY.data());
+        std::unique_ptr<TGraph> &graph = *part.graph;
+        if(!graph){
+            graph.reset(new TGraph());
+            graph->SetTitle(";Frequency [Hz];Pull");
+        }
+        graph->Set(n);
+        for(Int_t i = 0; i < n; i++){
+            graph->SetPoint(i, plot.Freq()[i], fCurveY[i]);
+            range = std::max(range, 1.1*std::fabs(fCurveY[i]));
         }
+        graph->SetMarkerStyle(20);
+        graph->SetMarkerSize(0.5);
+        graph->SetMarkerColor(part.color);
     }
-    
 
-    if (Freq.size()!=ErrFreq.size()){
-        printf("%s", Logger::error("array size of Freq and its Error do not match!"));
-        return false;
+    // symmetric, both components on the axis of the first one drawn
+    for(auto &part: parts){
+        if(!part.on || n == 0) continue;
+        TGraph *graph = part.graph->get();
+        graph->Draw(first? "ap" : "p");
+        if(first) graph->GetYaxis()->SetRangeUser(-range, range);
+        first = false;
     }
+    if(first) return;
 
-    return true;
+    gPad->Update();
+    Double_t xmin = std::pow(10, fResidualPad->GetUxmin()), xmax = std::pow(10, fResidualPad->GetUxmax());
+    fCutoffLine->DrawLine(xmin, 0, xmax, 0);
 }
 
-Bool_t Bode::SetFunctions(){
+void Bode::MakeGraphs(){
 
-    fGain = new TGraphErrors(fNpoints, fPointFreq.data(), fPointGain.data(), fPErrFreq.data(), fPErrGain.data());
-    fPhase = new TGraphErrors(fNpoints, fPointFreq.data(), fPointPhase.data(), fPErrFreq.data(), fPErrPhase.data());
-    fGainFit = new TF1("gain_fit", _gainfit);
-    fPhaseFit = new TF1("phase_fit", _phasefit);
+    // allocated once, refilled only when fSweep (or the LOD setting) changed;
+    // SetPoint also drops the cached axis histogram, so the ranges follow
+    if(!fGain){
+        fGain.reset(new TGraphErrors());
+        fPhase.reset(new TGraphErrors());
+        _plotstale = true;
+    }
+    if(!_plotstale) return;
+
+    // the envelope is kept, so the reduced sweep has the extent of the full one
+    DecimateSweep(fSweep, fPlotSweep, fLODBins, fLODOutlier, &fPlotRange);
+    _plotstale = false;
+
+    const Sweep &plot = fPlotSweep;
+    Int_t n = plot.Size();
+    fGain->Set(n);
+    fPhase->Set(n);
+    for(Int_t i = 0; i < n; i++){
+        fGain->SetPoint(i, plot.Freq()[i], plot.Gain()[i]);
+        fGain->SetPointError(i, plot.ErrFreq()[i], plot.ErrGain()[i]);
+        fPhase->SetPoint(i, plot.Freq()[i], plot.Phase()[i]);
+        fPhase->SetPointError(i, plot.ErrFreq()[i], plot.ErrPhase()[i]);
+    }
 
     fGain->SetTitle(";Frequency [Hz];Gain V_{out}/V_{in}");
     fGain->GetXaxis()->CenterTitle();
@@ -265,50 +387,330 @@ Bool_t Bode::SetFunctions(){
     fPhase->SetTitle(";Frequency [Hz];Phase [rad]");
     fPhase->GetXaxis()->CenterTitle();
     fPhase->GetYaxis()->CenterTitle();
+}
 
-    // debugging **************************************************************
-    // for(int j = 0; j < fGain->GetN(); j++){
-    //     std::cout << fGain->GetX()[j] << "\t" << fGain->GetEX()[j] << "\t" 
-    //               << fGain->GetY()[j] << "\t" << fGain->GetEY()[j] << "\t" 
-    //               <<std::endl;
-    // }
-    
-    // for(int j = 0; j < fPhase->GetN(); j++){
-    //     std::cout << fPhase->GetX()[j] << "\t" << fPhase->GetEX()[j] << "\t" 
-    //               << fPhase->GetY()[j] << "\t" << fPhase->GetEY()[j] << "\t" 
-    //               <<std::endl;
-    // }
-    // debugging **************************************************************
+void Bode::DrawCurve(TF1 *func, BodeModel::Component_t comp, bool logy, const TString &goption, std::unique_ptr<TGraph> &curve){
+
+    // refined where the curve bends on the drawn (log) axes, a resonance is not
+    // missed however narrow, while TF1 would take a fixed number of linear steps
+    Double_t xmin, xmax;
+    func->GetRange(xmin, xmax);
+    Int_t n = SampleCurve(fFilter, comp, func->GetParameters(), xmin, xmax, true, logy, fCurveX, fCurveY);
+
+    if(!curve) curve.reset(new TGraph());
+    curve->Set(n);
+    for(Int_t i = 0; i < n; i++) curve->SetPoint(i, fCurveX[i], fCurveY[i]);
+    func->TAttLine::Copy(*curve);
+    func->TAttMarker::Copy(*curve);
+    func->TAttFill::Copy(*curve);
+
+    curve->Draw(CurveOption(goption));
+}
+
+TString Bode::CurveOption(const TString &goption){
+
+    // the TF1 options that mean something for a TGraph drawn over the data;
+    // "A" would draw new axes and "SAME" is implied
+    TString opt(goption);
+    opt.ToUpper();
+    opt.ReplaceAll("SAME", "");
+    TString gopt;
+    for(const char *style: {"L", "C", "P", "*", "F", "B"}) if(opt.Contains(style)) gopt += style;
+    if(gopt.IsNull()) gopt = "L";
+    return gopt;
+}
+
+Bool_t Bode::CheckSize(std::size_t n, const char *what){
+
+    // columns set one by one no longer match any readings
+    fRaw.clear();
+    _plotstale = true;
+
+    if(fSweep.Empty()){
+        fSweep.Resize(n);
+    }else if(n != fSweep.Size()){
+        printf("%s", Logger::error(Form("%s array size does not match previous array size.", what)));
+        return false;
+    }
+
+    return true;
+}
+
+Bool_t Bode::SetFreqVec(const std::vector<Double_t> &Freq, const std::vector<Double_t> &ErrFreq){
+
+    if (Freq.size()!=ErrFreq.size()){
+        printf("%s", Logger::error("array size of Freq and its Error do not match!"));
+        return false;
+    }
+
+    return SetFreqVec(Freq.data(), ErrFreq.data(), Freq.size());
+}
+
+Bool_t Bode::SetFreqVec(const Double_t *Freq, const Double_t *ErrFreq, Int_t n){
+
+    if(!CheckSize(n, "freq.")) return false;
+
+    std::copy(Freq, Freq + n, fSweep.Freq());
+    std::copy(ErrFreq, ErrFreq + n, fSweep.ErrFreq());
 
     return true;
 }
 
-Bool_t Bode::SetGainVec(std::vector<Double_t> Gain, std::vector<Double_t> ErrGain){
-    fPointGain = Gain;
-    fPErrGain = ErrGain;
+Bool_t Bode::AppendPoint(Double_t freq, Double_t efreq, Double_t gain, Double_t egain, Double_t phase, Double_t ephase){
+
+    // one bad point would poison every later fit of the sweep
+    if(!Sweep::IsValid(freq, efreq, gain, egain, phase, ephase)) return false;
+
+    bool first = !fGainFit || fSweep.Empty();
+    fSweep.PushBack(freq, efreq, gain, egain, phase, ephase);
+    fRaw.clear();
+    _plotstale = true;
+
+    // graphs are refilled at the next plot; the functions only need a wider range
+    if(first){
+        SetFunctions();
+        return true;
+    }
+    Double_t xmin = std::min(freq, fGainFit->GetXmin()), xmax = std::max(freq, fGainFit->GetXmax());
+    fGainFit->SetRange(xmin, xmax);
+    fPhaseFit->SetRange(xmin, xmax);
+
+    return true;
+}
+
+Bool_t Bode::SetRawData(std::size_t n, const RawColumns_t &raw){
+
+    fSweep.Resize(n);
+    fMalformed.clear();
+    PropagateColumns(n, raw, fSweep.Freq(), fSweep.ErrFreq(), fSweep.Gain(), fSweep.ErrGain(), fSweep.Phase(), fSweep.ErrPhase());
+
+    // same rule as ReadInput, rows that cannot be propagated are dropped
+    const double *in[8] = {raw.Vin, raw.fsVin, raw.Vout, raw.fsVout, raw.T, raw.fsT, raw.dt, raw.fsdt};
+    fRaw.resize(8*n);
+    std::size_t kept = 0;
+    for(std::size_t i = 0; i < n; i++){
+        if(raw.Vin[i] == 0 || raw.T[i] <= 0) continue;
+        if(kept != i){
+            for(int c = 0; c < Sweep::kNColumns; c++) fSweep.Column(Sweep::Column_t(c))[kept] = fSweep.Column(Sweep::Column_t(c))[i];
+        }
+        for(int c = 0; c < 8; c++) fRaw[c*n + kept] = in[c][i];
+        kept++;
+    }
+    fSweep.Resize(kept);
+    for(int c = 1; c < 8 && kept < n; c++) std::copy(&fRaw[c*n], &fRaw[c*n] + kept, &fRaw[c*kept]);
+    fRaw.resize(8*kept);
+    if(kept < n){
+        fprintf(stderr, "%s\n", Logger::warning(Form("SetRawData: dropped %zu row(s) with V_in == 0 or T <= 0", n - kept)));
+    }
+
+    SetFunctions();
+
+    return kept > 0;
+}
+
+Bool_t Bode::ReadWaveforms(const std::vector<std::string> &files, const WaveformFormat_t &format,
+                           const std::vector<Double_t> &frequencies, unsigned nthreads){
 
-    // fPointGain = new TVectorD(Gain.size(), Gain.data());
-    // fPErrGain = new TVectorD(ErrGain.size(), ErrGain.data());
+    if(!frequencies.empty() && frequencies.size() != files.size()){
+        printf("%s", Logger::error(Form("ReadWaveforms: %zu files but %zu frequencies", files.size(), frequencies.size())));
+        return false;
+    }
 
-    if (fNpoints == -1111){
-        fNpoints = Gain.size();
+    BodeStats::StageTimer timer(fStats, BodeStats::kReadInput);
+
+    // each capture is streamed by its own worker, memory stays one block per thread
+    std::vector<WaveformResult_t> results(files.size());
+    std::vector<std::string> errors(files.size());
+    std::vector<char> ok(files.size(), 0);
+    {
+        ThreadPool pool(nthreads);
+        pool.ParallelFor(files.size(), [&](std::size_t i){
+            ok[i] = AnalyzeWaveform(files[i].c_str(), format, frequencies.empty()? 0 : frequencies[i], results[i], &errors[i]);
+        });
+    }
+
+    std::vector<std::size_t> order;
+    fMalformed.clear();
+    for(std::size_t i = 0; i < files.size(); i++){
+        if(ok[i]){
+            order.push_back(i);
+        }else{
+            fprintf(stderr, "%s\n", Logger::warning(Form("ReadWaveforms: %s skipped, %s", files[i].c_str(), errors[i].c_str())));
+        }
+    }
+    std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b){ return results[a].freq < results[b].freq; });
+
+    fSweep.Resize(order.size());
+    fRaw.clear();
+    for(std::size_t k = 0; k < order.size(); k++){
+        const WaveformResult_t &r = results[order[k]];
+        fSweep.Freq()[k] = r.freq;          fSweep.ErrFreq()[k] = r.efreq;
+        fSweep.Gain()[k] = r.gain;          fSweep.ErrGain()[k] = r.egain;
+        fSweep.Phase()[k] = r.phase;        fSweep.ErrPhase()[k] = r.ephase;
+    }
+
+    if(fStats.IsEnabled()){
+        fStats.Get(BodeStats::kReadInput).points += order.size();
+        fStats.Get(BodeStats::kReadInput).rejected += files.size() - order.size();
+    }
+
+    SetFunctions();
+
+    return !order.empty();
+}
+
+Bool_t Bode::ReadArchive(const BodeArchiveReader &archive, long entry){
+
+    BodeStats::StageTimer timer(fStats, BodeStats::kReadInput);
+
+    ArchiveSweep_t stored;
+    if(entry < 0 || !archive.Read(entry, stored)){
+        printf("%s", Logger::error(Form("cannot read archive entry %ld.", entry)));
+        return false;
+    }
+    if(stored.filter != fFilter){
+        fprintf(stderr, "%s\n", Logger::warning(Form("ReadArchive: '%s' was stored for another system, fits are not restored", stored.name.c_str())));
+        stored.hasfit[0] = stored.hasfit[1] = stored.hasfit[2] = false;
+    }
+
+    fSweep = std::move(stored.sweep);
+    fRaw = std::move(stored.raw);
+    fMalformed.clear();
+    if(fStats.IsEnabled()) fStats.Get(BodeStats::kReadInput).points += fSweep.Size();
+
+    SetFunctions();
+
+    // fits come back as if just done, the summary from the gain fit if there is one
+    if(stored.hasfit[ArchiveSweep_t::kCorrelatedFit]){
+        fCorrelatedResult = stored.fit[ArchiveSweep_t::kCorrelatedFit];
+        SetSummary(fCorrelatedResult);
+    }
+    if(stored.hasfit[ArchiveSweep_t::kGainFit]){
+        fGainResult = stored.fit[ArchiveSweep_t::kGainFit];
+        SetFitResult(fGainFit.get(), fGainResult, 0, 0);
+        SetSummary(fGainResult);
+        _hasfittedgain = true;
+    }else if(stored.hasfit[ArchiveSweep_t::kCorrelatedFit]){
+        SetFitResult(fGainFit.get(), fCorrelatedResult, 0, 0);
+        _hasfittedgain = true;
+    }
+    if(stored.hasfit[ArchiveSweep_t::kPhaseFit]){
+        fPhaseResult = stored.fit[ArchiveSweep_t::kPhaseFit];
+        SetFitResult(fPhaseFit.get(), fPhaseResult, 0, 0);
+        _hasfittedphase = true;
+    }else if(stored.hasfit[ArchiveSweep_t::kCorrelatedFit]){
+        SetFitResult(fPhaseFit.get(), fCorrelatedResult, 0, 0);
+        _hasfittedphase = true;
+    }
+
+    return true;
+}
+
+Bool_t Bode::ReadArchive(const char *filename, const char *name){
+
+    BodeArchiveReader archive(filename);
+    if(!archive.IsOpen()) return false;
+
+    long entry = archive.Find(name);
+    if(entry < 0){
+        printf("%s", Logger::error(Form("no sweep '%s' in archive '%s'.", name, filename)));
+        return false;
+    }
+
+    return ReadArchive(archive, entry);
+}
+
+Bool_t Bode::WriteArchive(BodeArchiveWriter &archive, const char *name) const {
+
+    ArchiveSweep_t stored;
+    stored.name = name;
+    stored.filter = fFilter;
+    stored.sweep = fSweep;
+    if(fRaw.size() == 8*fSweep.Size()) stored.raw = fRaw;
+
+    stored.hasfit[ArchiveSweep_t::kGainFit] = _hasfittedgain && fGainResult.NTotalParameters() > 0;
+    stored.hasfit[ArchiveSweep_t::kPhaseFit] = _hasfittedphase && fPhaseResult.NTotalParameters() > 0;
+    stored.hasfit[ArchiveSweep_t::kCorrelatedFit] = fCorrelatedResult.NTotalParameters() > 0;
+    stored.fit[ArchiveSweep_t::kGainFit] = fGainResult;
+    stored.fit[ArchiveSweep_t::kPhaseFit] = fPhaseResult;
+    stored.fit[ArchiveSweep_t::kCorrelatedFit] = fCorrelatedResult;
+
+    return archive.Write(stored);
+}
+
+void Bode::SetSweep(Sweep &&sweep){
+    fSweep = std::move(sweep);
+    fRaw.clear();
+    _plotstale = true;
+}
+
+Bool_t Bode::SetFunctions(){
+
+    BodeStats::StageTimer timer(fStats, BodeStats::kSetFunctions);
+
+    // every path that replaces the sweep ends here; graphs would only duplicate
+    // fSweep, they are filled when plotting (MakeGraphs)
+    _plotstale = true;
+
+    // per-object names, kept out of gROOT's list of functions, so that several
+    // Bode objects can live (and fit) in different threads at the same time.
+    // Compiled models, no TFormula involved
+    BodeModel::Filter_t filter = fFilter;
+    NPar_t npar = BodeModel::NPar(filter);
+    Int_t n = fSweep.Size();
+    Double_t xmin = n > 0? TMath::MinElement(n, fSweep.Freq()) : 0;
+    Double_t xmax = n > 0? TMath::MaxElement(n, fSweep.Freq()) : 1;
+    // made once per model; afterwards only range, parameters and fit info are reset
+    if(!fGainFit || fFuncFilter != filter){
+        fGainFit.reset(new TF1(TString::Format("gain_fit_%lu", fId),
+            [filter](Double_t *x, Double_t *p){ return BodeModel::Eval(filter, BodeModel::kGain, x[0], p); },
+            xmin, xmax, npar, 1, TF1::EAddToList::kNo));
+        fPhaseFit.reset(new TF1(TString::Format("phase_fit_%lu", fId),
+            [filter](Double_t *x, Double_t *p){ return BodeModel::Eval(filter, BodeModel::kPhase, x[0], p); },
+            xmin, xmax, npar, 1, TF1::EAddToList::kNo));
+        fGainFit->SetParNames("gain", "cutoff", "Q");
+        fPhaseFit->SetParNames("gain", "cutoff", "Q");
+        fFuncFilter = filter;
     }else{
-        if(Gain.size() != fNpoints){
-            printf("%s", Logger::error("gain array size does not match previous array size."));
-            return false;
+        for(TF1 *func: {fGainFit.get(), fPhaseFit.get()}){
+            func->SetRange(xmin, xmax);
+            for(Int_t k = 0; k < npar; k++){
+                func->SetParameter(k, 0);
+                func->SetParError(k, 0);
+            }
+            func->SetChisquare(0);
+            func->SetNDF(0);
         }
     }
+    _hasseedgain = false;
+    _hasseedphase = false;
+
+    return true;
+}
+
+Bool_t Bode::SetGainVec(const std::vector<Double_t> &Gain, const std::vector<Double_t> &ErrGain){
 
     if (Gain.size()!=ErrGain.size()){
         printf("%s", Logger::error("array size of Gain and its Error do not match!"));
         return false;
     }
 
+    return SetGainVec(Gain.data(), ErrGain.data(), Gain.size());
+}
+
+Bool_t Bode::SetGainVec(const Double_t *Gain, const Double_t *ErrGain, Int_t n){
+
+    if(!CheckSize(n, "gain")) return false;
+
+    std::copy(Gain, Gain + n, fSweep.Gain());
+    std::copy(ErrGain, ErrGain + n, fSweep.ErrGain());
+
     return true;
 }
 
 void Bode::SetParGain(Double_t gain, Double_t cutoff, Double_t Q){
 
+    _hasseedgain = true;
     if(_islowhighpass){
         fGainFit->SetParameters(gain, cutoff);
     }else{
@@ -320,36 +722,35 @@ void Bode::SetParGain(Double_t gain, Double_t cutoff, Double_t Q){
 
 void Bode::SetParPhase(Double_t gain, Double_t cutoff, Double_t Q){
 
+    _hasseedphase = true;
+    // phase does not depend on the gain, it is kept fixed at this value in FitPhase
     if(_islowhighpass){
         fPhaseFit->SetParameters(gain, cutoff);
     }else{
+        if(Q < 0) Q = (gQ > 0)? gQ : 1;
         fPhaseFit->SetParameters(gain, cutoff, Q);
     }
 
     return;
 }
 
-Bool_t Bode::SetPhaseVec(std::vector<Double_t> Phase, std::vector<Double_t> ErrPhase){
-    fPointPhase = Phase;
-    fPErrPhase = ErrPhase;
-
-    // fPointPhase = new TVectorD(Phase.size(), Phase.data());
-    // fPErrPhase = new TVectorD(ErrPhase.size(), ErrPhase.data());
-
-    if (fNpoints == -1111){
-        fNpoints = Phase.size();
-    }else{
-        if(Phase.size() != fNpoints){
-            printf("%s", Logger::error("phase array size does not match previous array size."));
-            return false;
-        }
-    }
+Bool_t Bode::SetPhaseVec(const std::vector<Double_t> &Phase, const std::vector<Double_t> &ErrPhase){
 
     if (Phase.size()!=ErrPhase.size()){
         printf("%s", Logger::error("array size of Phase and its Error do not match!"));
         return false;
     }
 
+    return SetPhaseVec(Phase.data(), ErrPhase.data(), Phase.size());
+}
+
+Bool_t Bode::SetPhaseVec(const Double_t *Phase, const Double_t *ErrPhase, Int_t n){
+
+    if(!CheckSize(n, "phase")) return false;
+
+    std::copy(Phase, Phase + n, fSweep.Phase());
+    std::copy(ErrPhase, ErrPhase + n, fSweep.ErrPhase());
+
     return true;
 }
 
@@ -357,42 +758,206 @@ void Bode::SetSystem(System_t sys){
     fSystem = sys;
     switch(fSystem.Hash()){
         case lowpass:
-            _gainfit = "[0]/sqrt(1+pow(x/[1], 2))"; // [0] gain, [1] cutoff
-            _phasefit = "";
+            fFilter = BodeModel::kLowpass;     // [0] gain, [1] cutoff
+            _islowhighpass = true;
             break;
         case highpass:
-            _gainfit = "[0]/sqrt(1+pow([1]/x, 2))"; // [0] gain, [1] cutoff
-            _phasefit = "";
+            fFilter = BodeModel::kHighpass;    // [0] gain, [1] cutoff
+            _islowhighpass = true;
             break;
         case bandpass:
-            _gainfit = "[0]/sqrt(1+pow([2], 2)*pow(x/[1]-[1]/x, 2))"; // [0] gain, [1] cutoff/peak frequency, [2] Q factor
-            _phasefit = "-atan([0]*(x/[1]-[1]/x))";
+            fFilter = BodeModel::kBandpass;    // [0] gain, [1] cutoff/peak frequency, [2] Q factor
             _islowhighpass = false;
             break;
         default:
+            fFilter = BodeModel::kUnknown;
             fprintf(stderr, "%s", Logger::warning(Form("System_t option '%s' not recognised!\n"
             "Available options are: \n\t\"lowpass\"\n\t\"highpass\"\n\t\"bandpass\"\n ", sys.Data())));
     }
 }
 
-Bool_t Bode::FitGain(Option_t *option, Option_t *goption, Axis_t xmin, Axis_t xmax){
+Bool_t Bode::DoFit(bool fitgain, bool fitphase, const Double_t *seed, Option_t *option, Axis_t xmin, Axis_t xmax, ROOT::Fit::FitResult &result, BodeStats::Stage_t stage){
+
+    TString opt(option);
+    opt.ToUpper();
+
+    Chi2Function chi2(fFilter, fSweep.Size(), fSweep.Freq(), fSweep.ErrFreq());
+    if(fitgain) chi2.AddTerm(BodeModel::kGain, fSweep.Gain(), fSweep.ErrGain());
+    if(fitphase) chi2.AddTerm(BodeModel::kPhase, fSweep.Phase(), fSweep.ErrPhase());
+    chi2.SetRange(xmin, xmax);
+
+    std::vector<double> par(seed, seed + chi2.NPar());
+    BodeFitCache::Key_t key;
+    bool ok;
 
-    fGain->Fit("gain_fit");
-    _hasfittedgain = true;
+    // cached results carry parabolic errors only
+    bool minos = opt.Contains("E");
+    if(fCache && !minos){
+        key = BodeFitCache::MakeKey(fSweep, fFilter, fitgain, fitphase, xmin, xmax, seed, _GainPar, _CutoffPar);
+        if(fCache->Load(key, result)){
+            if(fStats.IsEnabled()) fStats.Get(stage).cachehits++;
+            if(!opt.Contains("Q")) result.Print(std::cout);
+            return true;
+        }
+    }
+
+    // phase alone says nothing about the gain
+    BodeStats::StageStats_t &st = fStats.Get(stage);
+    ok = BodeMinimize(chi2, par, !fitgain, opt.Contains("V")? 1 : 0, result, _GainPar, _CutoffPar,
+        fStats.IsEnabled()? &st.fit : 0, minos);
+    if(fCache && !minos && ok) fCache->Store(key, result);
+
+    if(fStats.IsEnabled()){
+        st.status = result.Status();
+        st.valid = result.IsValid();
+        st.chi2 = result.Chi2();
+        st.ndf = result.Ndf();
+    }
+
+    if(!opt.Contains("Q")) result.Print(std::cout);
+
+    return ok;
+}
+
+void Bode::FitRange(TF1 *func, Option_t *option, Axis_t &xmin, Axis_t &xmax) const {
+    TString opt(option);
+    opt.ToUpper();
+    if(opt.Contains("R") && xmin >= xmax){
+        xmin = func->GetXmin();
+        xmax = func->GetXmax();
+    }
+}
+
+void Bode::StoreFit(TF1 *func, const ROOT::Fit::FitResult &result, Option_t *option, Axis_t xmin, Axis_t xmax, bool &hasfitted, bool &drawfit){
+    TString opt(option);
+    opt.ToUpper();
+    // "N": the result is kept (GetXResult, summary) but the curve stays as it was
+    if(opt.Contains("N")) return;
+    SetFitResult(func, result, xmin, xmax);
+    hasfitted = true;
+    drawfit = !opt.Contains("0");
+}
+
+void Bode::GetFitRange(BodeModel::Component_t comp, Axis_t &xmin, Axis_t &xmax) const {
+    const Axis_t *range = (comp == BodeModel::kGain)? fGainRange : fPhaseRange;
+    xmin = range[0];
+    xmax = range[1];
+}
+
+void Bode::SetFitResult(TF1 *func, const ROOT::Fit::FitResult &result, Axis_t xmin, Axis_t xmax){
+    func->SetParameters(result.GetParams());
+    func->SetParErrors(result.GetErrors());
+    func->SetChisquare(result.Chi2());
+    func->SetNDF(result.Ndf());
+    if(xmin < xmax) func->SetRange(xmin, xmax);
+}
+
+void Bode::SetSummary(const ROOT::Fit::FitResult &result){
+
+    // a failed fit has nothing to report, not even what the last good one said
+    gGBW = gErrGBW = gCutoff = gErrCutoff = gGain = gErrGain = gQ = gErrQ = -1111;
+    if(!result.IsValid()) return;
+
+    gCutoff = result.Parameter(_CutoffPar);
+    gErrCutoff = result.ParError(_CutoffPar);
+
+    gGain = result.Parameter(_GainPar);
+    gErrGain = result.ParError(_GainPar);
+
+    if(!_islowhighpass){
+        gQ = result.Parameter(_QPar);
+        gErrQ = result.ParError(_QPar);
+    }
+
+    // gain-bandwidth product, bandwidth being the cutoff for a lowpass and f0/Q for a bandpass
+    switch(fSystem.Hash()){
+        case lowpass: {
+            Double_t cov = result.CovMatrix(_GainPar, _CutoffPar);
+            gGBW = gGain * gCutoff;
+            gErrGBW = sqrt(pow(gCutoff*gErrGain, 2) + pow(gGain*gErrCutoff, 2) + 2*gGain*gCutoff*cov);
+            break;
+        }
+        case bandpass: {
+            // d(GBW)/d(gain, f0, Q)
+            Double_t d[3];
+            NPar_t par[3] = {_GainPar, _CutoffPar, _QPar};
+            d[0] = gCutoff/gQ;
+            d[1] = gGain/gQ;
+            d[2] = -gGain*gCutoff/(gQ*gQ);
+            Double_t var = 0;
+            for(int i = 0; i < 3; i++){
+                for(int j = 0; j < 3; j++) var += d[i]*d[j]*result.CovMatrix(par[i], par[j]);
+            }
+            gGBW = gGain * gCutoff / gQ;
+            gErrGBW = sqrt(var);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+Bool_t Bode::EstimatePar(bool setgain, bool setphase, Axis_t xmin, Axis_t xmax){
+
+    // only the points the fit will see
+    std::size_t n = fSweep.Size();
+    const Double_t *f = fSweep.Freq(), *g = fSweep.Gain(), *eg = fSweep.ErrGain();
+    std::vector<Double_t> wf, wg, weg;
+    if(xmin < xmax){
+        for(std::size_t i = 0; i < n; i++){
+            if(f[i] < xmin || f[i] > xmax) continue;
+            wf.push_back(f[i]);
+            wg.push_back(g[i]);
+            weg.push_back(eg[i]);
+        }
+        n = wf.size();
+        f = wf.data();
+        g = wg.data();
+        eg = weg.data();
+    }
 
-    gCutoff = fGainFit->GetParameter(_CutoffPar);
-    gErrCutoff = fGainFit->GetParError(_CutoffPar);
+    Double_t par[BodeModel::kMaxPar] = {1, 1, 1};
+    if(!BodeModel::Estimate(fFilter, n, f, g, eg, par)){
+        fprintf(stderr, "%s\n", Logger::warning("could not estimate start parameters from the data, use SetParGain/SetParPhase"));
+        return false;
+    }
 
-    gGain = fGainFit->GetParameter(_GainPar);
-    gErrGain = fGainFit->GetParError(_GainPar);
+    if(setgain) SetParGain(par[0], par[1], par[2]);
+    if(setphase) SetParPhase(par[0], par[1], par[2]);
 
     return true;
 }
 
+Bool_t Bode::FitGain(Option_t *option, Option_t *goption, Axis_t xmin, Axis_t xmax){
+
+    BodeStats::StageTimer timer(fStats, BodeStats::kFitGain);
+
+    FitRange(fGainFit.get(), option, xmin, xmax);
+    if(!_hasseedgain) EstimatePar(true, false, xmin, xmax);
+
+    Bool_t status = DoFit(true, false, fGainFit->GetParameters(), option, xmin, xmax, fGainResult, BodeStats::kFitGain);
+    StoreFit(fGainFit.get(), fGainResult, option, xmin, xmax, _hasfittedgain, _drawgainfit);
+    fGainGOption = goption;
+    fGainRange[0] = xmin;
+    fGainRange[1] = xmax;
+
+    SetSummary(fGainResult);
+
+    return status;
+}
+
 Bool_t Bode::FitPhase(Option_t *option, Option_t *goption, Axis_t xmin, Axis_t xmax){
 
-    fPhase->Fit("phase_fit");
-    _hasfittedphase = true;
+    BodeStats::StageTimer timer(fStats, BodeStats::kFitPhase);
+
+    FitRange(fPhaseFit.get(), option, xmin, xmax);
+    if(!_hasseedphase) EstimatePar(false, true, xmin, xmax);
+
+    Bool_t status = DoFit(false, true, fPhaseFit->GetParameters(), option, xmin, xmax, fPhaseResult, BodeStats::kFitPhase);
+    StoreFit(fPhaseFit.get(), fPhaseResult, option, xmin, xmax, _hasfittedphase, _drawphasefit);
+    fPhaseGOption = goption;
+    fPhaseRange[0] = xmin;
+    fPhaseRange[1] = xmax;
 
     // gCutoff = fPhaseFit->GetParameter(_CutoffPar);
     // gErrCutoff = fPhaseFit->GetParError(_CutoffPar);
@@ -400,6 +965,43 @@ Bool_t Bode::FitPhase(Option_t *option, Option_t *goption, Axis_t xmin, Axis_t x
     // gGain = fPhaseFit->GetParameter(_GainPar);
     // gErrGain = fPhaseFit->GetParError(_GainPar);
 
+    return status;
+}
+
+Bool_t Bode::FitCorrelated(Option_t *option, Option_t *goption, Axis_t xmin, Axis_t xmax){
+
+    BodeStats::StageTimer timer(fStats, BodeStats::kFitCorrelated);
+
+    // one fit of the complex H: |H| and arg(H) share gain, cutoff and Q, and
+    // come out with one covariance matrix. Seeds are the gain function's parameters
+    FitRange(fGainFit.get(), option, xmin, xmax);
+    if(!_hasseedgain) EstimatePar(true, false, xmin, xmax);
+    Bool_t status = DoFit(true, true, fGainFit->GetParameters(), option, xmin, xmax, fCorrelatedResult, BodeStats::kFitCorrelated);
+
+    // both curves show the same (joint) parameters
+    StoreFit(fGainFit.get(), fCorrelatedResult, option, xmin, xmax, _hasfittedgain, _drawgainfit);
+    StoreFit(fPhaseFit.get(), fCorrelatedResult, option, xmin, xmax, _hasfittedphase, _drawphasefit);
+    fGainGOption = goption;
+    fPhaseGOption = goption;
+    fGainRange[0] = fPhaseRange[0] = xmin;
+    fGainRange[1] = fPhaseRange[1] = xmax;
+
+    SetSummary(fCorrelatedResult);
+
+    return status;
+}
+
+Bool_t Bode::WriteStats(const char *filename) const {
+
+    FILE *out = fopen(filename, "w");
+    if(!out){
+        printf("%s", Logger::error(Form("cannot open '%s' for writing.", filename)));
+        return false;
+    }
+    fprintf(out, "{\"id\":%lu,\"system\":%s,\"npoints\":%d,\"stages\":%s}\n",
+        fId, BodeStats::JSONString(fSystem.Data()).c_str(), GetNpoints(), fStats.ToJSON().c_str());
+    fclose(out);
+
     return true;
 }
 
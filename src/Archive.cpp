@@ -0,0 +1,329 @@
+/**
+ * @file Archive.cpp
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include<cstring>
+
+#include<fcntl.h>
+#include<sys/stat.h>
+#include<unistd.h>
+
+#ifdef BODE_HAVE_ZLIB
+#include<zlib.h>
+#endif
+
+#include<TString.h>
+
+#include"Bode/Archive.h"
+#include"Bode/FitCache.h"
+#include"Logger.h"
+
+namespace {
+
+    const std::uint32_t kVersion = 1;
+    const std::uint32_t kByteOrder = 0x01020304;   ///> 0 in archives written before it was checked
+    const char          kMagic[8] = {'B', 'O', 'D', 'E', 'A', 'R', 'C', '1'};
+    const char          kIndexMagic[8] = {'B', 'O', 'D', 'E', 'I', 'D', 'X', '1'};
+    const std::size_t   kHeader = 16;
+    const std::size_t   kTrailer = 24;
+
+    template<class T>
+    void put(std::string &buf, const T &value){
+        buf.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    template<class T>
+    bool get(const char *&cur, const char *end, T &value){
+        if(end - cur < static_cast<long>(sizeof(T))) return false;
+        std::memcpy(&value, cur, sizeof(T));
+        cur += sizeof(T);
+        return true;
+    }
+
+    // byte k of double i goes to k*n + i, and back
+    void shuffle(const char *in, char *out, std::size_t n){
+        for(std::size_t i = 0; i < n; i++){
+            for(int k = 0; k < 8; k++) out[k*n + i] = in[8*i + k];
+        }
+    }
+
+    void unshuffle(const char *in, char *out, std::size_t n){
+        for(std::size_t i = 0; i < n; i++){
+            for(int k = 0; k < 8; k++) out[8*i + k] = in[k*n + i];
+        }
+    }
+
+    bool pread_all(int fd, char *buf, std::size_t size, std::uint64_t offset){
+        while(size > 0){
+            ssize_t got = pread(fd, buf, size, offset);
+            if(got <= 0) return false;
+            buf += got;
+            size -= got;
+            offset += got;
+        }
+        return true;
+    }
+
+}
+
+BodeArchiveWriter::BodeArchiveWriter(const char *filename, bool deflate) : fFilename(filename), _deflate(deflate) {
+
+#ifndef BODE_HAVE_ZLIB
+    if(_deflate){
+        fprintf(stderr, "%s\n", Logger::warning("BodeArchiveWriter: built without zlib, chunks are stored uncompressed"));
+        _deflate = false;
+    }
+#endif
+
+    fFile = fopen(filename, "wb");
+    if(!fFile){
+        printf("%s", Logger::error(Form("cannot open '%s' for writing.", filename)));
+        return;
+    }
+
+    std::string header(kMagic, sizeof(kMagic));
+    put(header, kVersion);
+    put(header, kByteOrder);
+    if(fwrite(header.data(), 1, header.size(), fFile) != header.size()){
+        fclose(fFile);
+        fFile = 0;
+        return;
+    }
+    fOffset = kHeader;
+}
+
+BodeArchiveWriter::~BodeArchiveWriter(){
+    Close();
+}
+
+bool BodeArchiveWriter::Write(const ArchiveSweep_t &sweep){
+
+    if(!fFile || _failed) return false;
+
+    std::size_t n = sweep.sweep.Size();
+    bool hasraw = sweep.raw.size() == 8*n && n > 0;
+
+    ArchiveEntry_t entry;
+    entry.name = sweep.name;
+    entry.npoints = n;
+    entry.filter = sweep.filter;
+    entry.flags = hasraw? ArchiveEntry_t::kRaw : 0;
+
+    // columns, then fits
+    std::string chunk;
+    std::size_t ndoubles = (hasraw? 14 : 6)*n;
+    chunk.reserve(ndoubles*sizeof(double) + 1024);
+    for(int c = 0; c < Sweep::kNColumns; c++){
+        chunk.append(reinterpret_cast<const char *>(sweep.sweep.Column(Sweep::Column_t(c))), n*sizeof(double));
+    }
+    if(hasraw) chunk.append(reinterpret_cast<const char *>(sweep.raw.data()), 8*n*sizeof(double));
+
+    for(int k = 0; k < ArchiveSweep_t::kNFits; k++){
+        std::string fit;
+        if(sweep.hasfit[k] && sweep.fit[k].NTotalParameters() > 0){
+            BodeFitCache::Encode(sweep.fit[k], fit);
+            entry.flags |= ArchiveEntry_t::kGainFit << k;
+        }
+        put(chunk, std::uint32_t(fit.size()));
+        chunk += fit;
+    }
+    entry.size = chunk.size();
+
+#ifdef BODE_HAVE_ZLIB
+    if(_deflate){
+        std::string shuffled(chunk);
+        shuffle(chunk.data(), &shuffled[0], ndoubles);
+        uLongf stored = compressBound(chunk.size());
+        std::string packed(stored, '\0');
+        if(compress2(reinterpret_cast<Bytef *>(&packed[0]), &stored,
+                     reinterpret_cast<const Bytef *>(shuffled.data()), shuffled.size(), Z_DEFAULT_COMPRESSION) == Z_OK
+           && stored < chunk.size()){
+            packed.resize(stored);
+            chunk.swap(packed);
+            entry.flags |= ArchiveEntry_t::kDeflated;
+        }
+    }
+#endif
+    entry.stored = chunk.size();
+
+    std::lock_guard<std::mutex> lock(fMutex);
+    // another thread may have failed while this one was compressing
+    if(_failed) return false;
+    if(fwrite(chunk.data(), 1, chunk.size(), fFile) != chunk.size()){
+        _failed = true;
+        printf("%s", Logger::error(Form("BodeArchiveWriter: write to '%s' failed, no more sweeps are written.", fFilename.c_str())));
+        return false;
+    }
+    entry.offset = fOffset;
+    fOffset += chunk.size();
+    fIndex.push_back(std::move(entry));
+
+    return true;
+}
+
+bool BodeArchiveWriter::Close(){
+
+    std::lock_guard<std::mutex> lock(fMutex);
+    if(!fFile) return false;
+
+    // fOffset no longer matches the file: better no index than a wrong one
+    if(_failed){
+        fclose(fFile);
+        fFile = 0;
+        printf("%s", Logger::error(Form("BodeArchiveWriter: '%s' left without index after a failed write.", fFilename.c_str())));
+        return false;
+    }
+
+    std::string index;
+    for(const ArchiveEntry_t &e: fIndex){
+        put(index, e.offset);
+        put(index, e.stored);
+        put(index, e.size);
+        put(index, e.npoints);
+        put(index, e.filter);
+        put(index, e.flags);
+        put(index, std::uint32_t(e.name.size()));
+        index += e.name;
+    }
+    put(index, fOffset);
+    put(index, std::uint64_t(fIndex.size()));
+    index.append(kIndexMagic, sizeof(kIndexMagic));
+
+    bool ok = fwrite(index.data(), 1, index.size(), fFile) == index.size();
+    ok &= (fclose(fFile) == 0);
+    fFile = 0;
+    if(!ok) printf("%s", Logger::error(Form("BodeArchiveWriter: could not finish '%s'.", fFilename.c_str())));
+
+    return ok;
+}
+
+BodeArchiveReader::BodeArchiveReader(const char *filename) : fFilename(filename) {
+
+    fFd = open(filename, O_RDONLY);
+    if(fFd < 0){
+        printf("%s", Logger::error(Form("cannot open archive '%s'.", filename)));
+        return;
+    }
+
+    struct stat st;
+    char header[kHeader], trailer[kTrailer];
+    std::uint64_t indexoffset = 0, nentries = 0;
+    std::uint32_t version = 0, order = 0;
+    bool ok = fstat(fFd, &st) == 0 && static_cast<std::size_t>(st.st_size) >= kHeader + kTrailer
+        && pread_all(fFd, header, kHeader, 0) && std::memcmp(header, kMagic, sizeof(kMagic)) == 0
+        && pread_all(fFd, trailer, kTrailer, st.st_size - kTrailer) && std::memcmp(trailer + 16, kIndexMagic, sizeof(kIndexMagic)) == 0;
+    if(ok){
+        std::memcpy(&version, header + 8, sizeof(version));
+        std::memcpy(&order, header + 12, sizeof(order));
+        std::memcpy(&indexoffset, trailer, sizeof(indexoffset));
+        std::memcpy(&nentries, trailer + 8, sizeof(nentries));
+        // every number in the file would come out byte-swapped
+        if(order != kByteOrder && order != 0){
+            printf("%s", Logger::error(Form("'%s' was written on a host of the other byte order.", filename)));
+            close(fFd);
+            fFd = -1;
+            return;
+        }
+        ok = version == kVersion && indexoffset >= kHeader && indexoffset <= st.st_size - kTrailer;
+    }
+
+    std::vector<char> index;
+    if(ok){
+        index.resize(st.st_size - kTrailer - indexoffset);
+        ok = pread_all(fFd, index.data(), index.size(), indexoffset);
+    }
+
+    const char *cur = index.data(), *end = index.data() + index.size();
+    for(std::uint64_t i = 0; ok && i < nentries; i++){
+        ArchiveEntry_t e;
+        std::uint32_t namelen = 0;
+        ok = get(cur, end, e.offset) && get(cur, end, e.stored) && get(cur, end, e.size) && get(cur, end, e.npoints)
+            && get(cur, end, e.filter) && get(cur, end, e.flags) && get(cur, end, namelen)
+            && static_cast<std::size_t>(end - cur) >= namelen && e.offset + e.stored <= indexoffset;
+        if(!ok) break;
+        e.name.assign(cur, namelen);
+        cur += namelen;
+        fIndex.push_back(std::move(e));
+    }
+
+    if(!ok){
+        printf("%s", Logger::error(Form("'%s' is not a complete Bode archive.", filename)));
+        close(fFd);
+        fFd = -1;
+        fIndex.clear();
+    }
+}
+
+BodeArchiveReader::~BodeArchiveReader(){
+    if(fFd >= 0) close(fFd);
+}
+
+long BodeArchiveReader::Find(const char *name) const {
+    for(std::size_t i = 0; i < fIndex.size(); i++){
+        if(fIndex[i].name == name) return i;
+    }
+    return -1;
+}
+
+bool BodeArchiveReader::Read(std::size_t i, ArchiveSweep_t &sweep) const {
+
+    if(fFd < 0 || i >= fIndex.size()) return false;
+    const ArchiveEntry_t &e = fIndex[i];
+
+    std::string chunk(e.stored, '\0');
+    if(!pread_all(fFd, &chunk[0], e.stored, e.offset)) return false;
+
+    std::size_t n = e.npoints;
+    bool hasraw = e.flags & ArchiveEntry_t::kRaw;
+    std::size_t ndoubles = (hasraw? 14 : 6)*n;
+
+    if(e.flags & ArchiveEntry_t::kDeflated){
+#ifdef BODE_HAVE_ZLIB
+        std::string shuffled(e.size, '\0');
+        uLongf size = e.size;
+        if(uncompress(reinterpret_cast<Bytef *>(&shuffled[0]), &size,
+                      reinterpret_cast<const Bytef *>(chunk.data()), chunk.size()) != Z_OK || size != e.size) return false;
+        if(ndoubles*sizeof(double) > size) return false;
+        chunk = shuffled;
+        unshuffle(shuffled.data(), &chunk[0], ndoubles);
+#else
+        printf("%s", Logger::error("BodeArchiveReader: deflated chunk, but built without zlib."));
+        return false;
+#endif
+    }
+    if(chunk.size() != e.size || ndoubles*sizeof(double) > chunk.size()) return false;
+
+    sweep.name = e.name;
+    sweep.filter = BodeModel::Filter_t(e.filter);
+    sweep.sweep.Resize(n);
+    const char *cur = chunk.data(), *end = chunk.data() + chunk.size();
+    for(int c = 0; c < Sweep::kNColumns; c++){
+        std::memcpy(sweep.sweep.Column(Sweep::Column_t(c)), cur, n*sizeof(double));
+        cur += n*sizeof(double);
+    }
+    sweep.raw.clear();
+    if(hasraw){
+        sweep.raw.resize(8*n);
+        std::memcpy(sweep.raw.data(), cur, 8*n*sizeof(double));
+        cur += 8*n*sizeof(double);
+    }
+
+    for(int k = 0; k < ArchiveSweep_t::kNFits; k++){
+        std::uint32_t len;
+        if(!get(cur, end, len) || static_cast<std::size_t>(end - cur) < len) return false;
+        sweep.hasfit[k] = len > 0;
+        sweep.fit[k] = ROOT::Fit::FitResult();
+        const char *fitend = cur + len;
+        if(len > 0 && (!BodeFitCache::Decode(cur, fitend, sweep.fit[k]) || cur != fitend)) return false;
+        cur = fitend;
+    }
+
+    return cur == end;
+}
@@ -0,0 +1,330 @@
+/**
+ * @file BatchFit.cpp
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include<algorithm>
+#include<cmath>
+#include<numeric>
+
+#include"Bode/BatchFit.h"
+#include"Bode/Estimate.h"
+#include"Bode/ThreadPool.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define BODE_BATCHFIT_X86
+#endif
+
+using namespace BodeModel;
+
+namespace {
+
+    const int W = BodeBatchFit::kLanes;
+    const int M = kMaxPar;
+
+    /// kLanes sweeps, point-major: element i*W + l is point i of lane l
+    struct Block_t {
+        std::size_t         npts    = 0;
+        std::vector<double> x, ex, y, ey, w;
+        long                sweep[W];       ///> index in the input, -1: empty lane
+    };
+
+    typedef void (*Eval_t)(const Block_t &block, const double *par, double *chi2, double *grad, double *hess);
+
+    /**
+     * chi2[l], grad[k*W + l] and hess[(a*M + b)*W + l] = 2 J^T W J of every lane at
+     * par[k*W + l]; the lane loop is innermost and branch-free so that it vectorizes.
+     * Padding and unusable points carry a real frequency, y = 0 and zero weight, so
+     * they add exactly 0 (never 0*NaN).
+     */
+    template<class Model, bool isgain>
+    inline __attribute__((always_inline)) void EvalLanes(const Block_t &block, const double *par, double *chi2, double *grad, double *hess){
+
+        const int npar = Model::NPar;
+        double c[W] = {}, g[M*W] = {}, h[M*M*W] = {};
+
+        for(std::size_t i = 0; i < block.npts; i++){
+            const double *x = &block.x[i*W], *y = &block.y[i*W], *w = &block.w[i*W];
+            for(int l = 0; l < W; l++){
+                double p[M] = {par[l], par[W + l], par[2*W + l]};
+                double d[M];
+                double model = isgain? Model::GainGrad(x[l], p, d) : Model::PhaseGrad(x[l], p, d);
+                double r = y[l] - model;
+                c[l] += w[l]*r*r;
+                for(int a = 0; a < npar; a++){
+                    g[a*W + l] -= 2*w[l]*r*d[a];
+                    for(int b = 0; b < npar; b++) h[(a*M + b)*W + l] += 2*w[l]*d[a]*d[b];
+                }
+            }
+        }
+
+        for(int l = 0; l < W; l++) chi2[l] = c[l];
+        for(int k = 0; k < M*W; k++) grad[k] = g[k];
+        for(int k = 0; k < M*M*W; k++) hess[k] = h[k];
+    }
+
+    template<class Model, bool isgain>
+    void eval_scalar(const Block_t &block, const double *par, double *chi2, double *grad, double *hess){
+        EvalLanes<Model, isgain>(block, par, chi2, grad, hess);
+    }
+
+#ifdef BODE_BATCHFIT_X86
+    template<class Model, bool isgain> __attribute__((target("avx2")))
+    void eval_avx2(const Block_t &block, const double *par, double *chi2, double *grad, double *hess){
+        EvalLanes<Model, isgain>(block, par, chi2, grad, hess);
+    }
+
+    template<class Model, bool isgain> __attribute__((target("avx512f")))
+    void eval_avx512(const Block_t &block, const double *par, double *chi2, double *grad, double *hess){
+        EvalLanes<Model, isgain>(block, par, chi2, grad, hess);
+    }
+#endif
+
+    enum Kernel_t { kScalar, kAVX2, kAVX512 };
+
+    Kernel_t kernel(){
+#ifdef BODE_BATCHFIT_X86
+        static const Kernel_t best = __builtin_cpu_supports("avx512f")? kAVX512
+                                   : __builtin_cpu_supports("avx2")? kAVX2 : kScalar;
+        return best;
+#else
+        return kScalar;
+#endif
+    }
+
+    template<class Model, bool isgain>
+    Eval_t pick(){
+        switch(kernel()){
+#ifdef BODE_BATCHFIT_X86
+            case kAVX512: return eval_avx512<Model, isgain>;
+            case kAVX2:   return eval_avx2<Model, isgain>;
+#endif
+            default:      return eval_scalar<Model, isgain>;
+        }
+    }
+
+    Eval_t pick(Filter_t filter, Component_t comp){
+        bool isgain = (comp == kGain);
+        switch(filter){
+            case kLowpass:  return isgain? pick<Lowpass, true>()  : pick<Lowpass, false>();
+            case kHighpass: return isgain? pick<Highpass, true>() : pick<Highpass, false>();
+            case kBandpass: return isgain? pick<Bandpass, true>() : pick<Bandpass, false>();
+            default:        return 0;
+        }
+    }
+
+    /// effective variance at par, as Chi2Function::UpdateWeights
+    void UpdateWeights(Block_t &block, Filter_t filter, Component_t comp, const double *par){
+        for(int l = 0; l < W; l++){
+            if(block.sweep[l] < 0) continue;
+            double p[M] = {par[l], par[W + l], par[2*W + l]};
+            for(std::size_t i = 0; i < block.npts; i++){
+                std::size_t j = i*W + l;
+                if(block.w[j] == 0) continue;
+                double sx = Slope(filter, comp, block.x[j], p)*block.ex[j];
+                block.w[j] = 1/(block.ey[j]*block.ey[j] + sx*sx);
+            }
+        }
+    }
+
+}
+
+BodeBatchFit::BodeBatchFit(Filter_t filter){
+    fFilter = filter;
+}
+
+BodeBatchFit::BodeBatchFit(const char *filter){
+    fFilter = FilterFromName(filter);
+}
+
+void BodeBatchFit::SetSeed(double gain, double cutoff, double Q){
+    fSeed[0] = gain;
+    fSeed[1] = cutoff;
+    fSeed[2] = Q;
+    _hasseed = true;
+}
+
+const char *BodeBatchFit::Kernel(){
+    switch(kernel()){
+        case kAVX512: return "avx512";
+        case kAVX2:   return "avx2";
+        default:      return "scalar";
+    }
+}
+
+std::size_t BodeBatchFit::Fit(const std::vector<Sweep> &sweeps){
+    std::vector<const Sweep *> ptr(sweeps.size());
+    for(std::size_t i = 0; i < sweeps.size(); i++) ptr[i] = &sweeps[i];
+    return Fit(ptr.data(), ptr.size());
+}
+
+std::size_t BodeBatchFit::Fit(const Sweep *const *sweeps, std::size_t n){
+
+    fResults.assign(n, MinimizeResult_t());
+    Eval_t eval = pick(fFilter, fComp);
+    if(!eval || n == 0) return 0;
+
+    const int npar = NPar(fFilter);
+    bool isfree[M] = {true, true, true};
+    if(fComp == kPhase) isfree[0] = false;     // phase alone says nothing about the gain
+    int nfree = std::count(isfree, isfree + npar, true);
+
+    // similar sizes share a block, little padding
+    std::vector<std::size_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [sweeps](std::size_t a, std::size_t b){ return sweeps[a]->Size() < sweeps[b]->Size(); });
+
+    std::size_t nblocks = (n + W - 1)/W;
+    ThreadPool pool(fNThreads);
+    pool.ParallelFor(nblocks, [&](std::size_t ib){
+
+        Block_t block;
+        double par[M*W], trial[M*W];
+        std::fill(par, par + M*W, 1.);
+
+        for(int l = 0; l < W; l++){
+            std::size_t k = ib*W + l;
+            block.sweep[l] = (k < n && sweeps[order[k]]->Size() > 0)? long(order[k]) : -1;
+            if(block.sweep[l] >= 0) block.npts = std::max(block.npts, sweeps[order[k]]->Size());
+        }
+        block.x.assign(block.npts*W, 1.);
+        block.ex.assign(block.npts*W, 0.);
+        block.y.assign(block.npts*W, 0.);
+        block.ey.assign(block.npts*W, 0.);
+        block.w.assign(block.npts*W, 0.);
+
+        for(int l = 0; l < W; l++){
+            if(block.sweep[l] < 0) continue;
+            const Sweep &s = *sweeps[block.sweep[l]];
+            const double *y = (fComp == kGain)? s.Gain() : s.Phase();
+            const double *ey = (fComp == kGain)? s.ErrGain() : s.ErrPhase();
+            for(std::size_t i = 0; i < block.npts; i++){
+                std::size_t j = i*W + l;
+                std::size_t src = std::min(i, s.Size() - 1);     // padding repeats the last frequency
+                double f = s.Freq()[src];
+                bool goodx = std::isfinite(f) && f > 0;
+                block.x[j] = goodx? f : 1.;
+                if(i >= s.Size()) continue;
+                // the lanes have no branch to skip a point: anything not finite stays out of the block
+                if(!goodx || !(ey[i] > 0) || !std::isfinite(y[i]) || !std::isfinite(s.ErrFreq()[i])) continue;
+                block.ex[j] = s.ErrFreq()[i];
+                block.y[j] = y[i];
+                block.ey[j] = ey[i];
+                block.w[j] = 1/(ey[i]*ey[i]);
+            }
+
+            double seed[M] = {fSeed[0], fSeed[1], fSeed[2]};
+            if(!_hasseed && !Estimate(fFilter, s.Size(), s.Freq(), s.Gain(), s.ErrGain(), seed)){
+                block.sweep[l] = -1;
+                continue;
+            }
+            for(int k = 0; k < M; k++) par[k*W + l] = seed[k];
+        }
+
+        double value[W], grad[M*W], hess[M*M*W];
+        double tvalue[W], tgrad[M*W], thess[M*M*W];
+        double lambda[W];
+        bool ok[W], active[W];
+        int niter[W] = {};
+        for(int l = 0; l < W; l++) ok[l] = block.sweep[l] >= 0;
+
+        // as NativeMinimize: a second pass with the weights at the first minimum,
+        // which cannot move them when no point of the block has a frequency error
+        bool hasxerrors = std::any_of(block.ex.begin(), block.ex.end(), [](double ex){ return ex != 0; });
+        int npass = hasxerrors? 2 : 1;
+        for(int pass = 0; pass < npass; pass++){
+            UpdateWeights(block, fFilter, fComp, par);
+            eval(block, par, value, grad, hess);
+            int nactive = 0;
+            for(int l = 0; l < W; l++){
+                if(ok[l] && !std::isfinite(value[l])) ok[l] = false;
+                active[l] = ok[l];
+                lambda[l] = fOptions.lambda;
+                nactive += active[l];
+            }
+
+            for(int it = 0; it < fOptions.maxiter && nactive > 0; it++){
+
+                for(int l = 0; l < W; l++){
+                    for(int k = 0; k < M; k++) trial[k*W + l] = par[k*W + l];
+                    if(!active[l]) continue;
+                    niter[l]++;
+
+                    double a[M][M];
+                    for(int i = 0; i < npar; i++){
+                        for(int j = 0; j < npar; j++) a[i][j] = (isfree[i] && isfree[j])? 0.5*hess[(i*M + j)*W + l] : 0;
+                        a[i][i] = isfree[i]? a[i][i]*(1 + lambda[l]) : 1;
+                        if(isfree[i] && a[i][i] == 0) a[i][i] = lambda[l];
+                    }
+                    if(!InvertMatrix(a, npar)){
+                        ok[l] = active[l] = false;
+                        continue;
+                    }
+                    for(int i = 0; i < npar; i++){
+                        double step = 0;
+                        for(int j = 0; j < npar; j++) if(isfree[j]) step -= 0.5*a[i][j]*grad[j*W + l];
+                        if(isfree[i]) trial[i*W + l] += step;
+                    }
+                }
+
+                eval(block, trial, tvalue, tgrad, thess);
+
+                nactive = 0;
+                for(int l = 0; l < W; l++){
+                    if(!active[l]) continue;
+                    double tv = trial[W + l] > 0? tvalue[l] : HUGE_VAL;
+                    if(std::isfinite(tv) && tv <= value[l]){
+                        bool small = (value[l] - tv) <= fOptions.tolerance*(1 + value[l]);
+                        for(int k = 0; k < M; k++){ par[k*W + l] = trial[k*W + l]; grad[k*W + l] = tgrad[k*W + l]; }
+                        for(int k = 0; k < M*M; k++) hess[k*W + l] = thess[k*W + l];
+                        value[l] = tv;
+                        lambda[l] = std::max(lambda[l]/10, 1e-12);
+                        if(small) active[l] = false;
+                    }else{
+                        lambda[l] *= 10;
+                        if(lambda[l] > 1e12) active[l] = false;
+                    }
+                    nactive += active[l];
+                }
+            }
+            // still moving after maxiter: not converged
+            for(int l = 0; l < W; l++) if(active[l]) ok[l] = false;
+        }
+
+        for(int l = 0; l < W; l++){
+            if(block.sweep[l] < 0) continue;
+            MinimizeResult_t &result = fResults[block.sweep[l]];
+            result.npar = npar;
+            result.niter = niter[l];
+
+            double cov[M][M];
+            for(int i = 0; i < npar; i++){
+                for(int j = 0; j < npar; j++) cov[i][j] = (isfree[i] && isfree[j])? 0.5*hess[(i*M + j)*W + l] : 0;
+                if(!isfree[i]) cov[i][i] = 1;
+            }
+            bool good = ok[l] && InvertMatrix(cov, npar);
+
+            std::size_t ndata = 0;
+            for(std::size_t i = 0; i < block.npts; i++) ndata += (block.w[i*W + l] > 0);
+            for(int i = 0; i < npar; i++){
+                result.par[i] = par[i*W + l];
+                for(int j = 0; j < npar; j++) result.cov[i][j] = (isfree[i] && isfree[j])? cov[i][j] : 0;
+                result.err[i] = std::sqrt(std::max(result.cov[i][i], 0.));
+            }
+            result.chi2 = value[l];
+            result.ndf = int(ndata) - nfree;
+            result.valid = good && std::isfinite(value[l]);
+        }
+    });
+
+    std::size_t nvalid = 0;
+    for(const MinimizeResult_t &r: fResults) nvalid += r.valid;
+
+    return nvalid;
+}
@@ -0,0 +1,188 @@
+/**
+ * @file BodeBatch.cpp
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include<algorithm>
+#include<cstdio>
+#include<memory>
+
+#include<glob.h>
+
+#include<Math/MinimizerOptions.h>
+#include<TROOT.h>
+
+#include"Bode/BodeBatch.h"
+#include"Bode/FitCache.h"
+#include"Bode/Pool.h"
+#include"Bode/ThreadPool.h"
+#include"Bode/WindowScan.h"
+#include"Logger.h"
+
+BodeBatch::BodeBatch(System_t sys){
+    fSystem = sys;
+}
+
+void BodeBatch::AddFile(const char *filename){
+    fFiles.push_back(filename);
+}
+
+Int_t BodeBatch::AddGlob(const char *pattern){
+
+    glob_t matches;
+    int status = glob(pattern, 0, 0, &matches);
+    if(status != 0){
+        if(status != GLOB_NOMATCH){
+            fprintf(stderr, "%s\n", Logger::warning(Form("glob failed for pattern '%s'", pattern)));
+        }
+        globfree(&matches);
+        return 0;
+    }
+
+    // glob() already returns the paths sorted, keep that order in the table
+    for(size_t i = 0; i < matches.gl_pathc; i++) fFiles.push_back(matches.gl_pathv[i]);
+    Int_t added = matches.gl_pathc;
+    globfree(&matches);
+
+    return added;
+}
+
+void BodeBatch::SetParGain(Double_t gain, Double_t cutoff, Double_t Q){
+    _hasseedgain = true;
+    fParGain[0] = gain;
+    fParGain[1] = cutoff;
+    fParGain[2] = Q;
+}
+
+void BodeBatch::SetParPhase(Double_t gain, Double_t cutoff, Double_t Q){
+    _hasseedphase = true;
+    fParPhase[0] = gain;
+    fParPhase[1] = cutoff;
+    fParPhase[2] = Q;
+}
+
+void BodeBatch::SetWindowScan(Int_t nlow, Int_t nhigh, Double_t threshold){
+    fScanTrim[0] = nlow;
+    fScanTrim[1] = nhigh;
+    fScanThreshold = threshold;
+}
+
+BodeResult_t BodeBatch::Process(const std::string &filename, BodePlot_t *plot, BodeFitCache *cache, BodePool &pool) const {
+
+    // everything ROOT touches for this file lives in this task only
+    BodeResult_t result;
+    result.filename = filename;
+
+    // taken from the pool: buffers, graphs and functions of an earlier file are reused
+    BodePool::Handle_t bode = pool.Acquire(fSystem);
+    if(!bode->ReadInput(filename.c_str())) return result;
+
+    result.npoints = bode->GetNpoints();
+    result.malformed = bode->GetMalformedLines().size();
+    if(result.npoints == 0) return result;
+
+    bode->SetFitCache(cache);
+    if(_hasseedgain) bode->SetParGain(fParGain[0], fParGain[1], fParGain[2]);
+    result.status = bode->FitGain("Q");
+
+    if(_fitphase){
+        if(_hasseedphase) bode->SetParPhase(fParPhase[0], fParPhase[1], fParPhase[2]);
+        result.status &= bode->FitPhase("Q");
+    }
+
+    result.gain = bode->GetGain();
+    result.errGain = bode->GetErrGain();
+    result.cutoff = bode->GetCutoff();
+    result.errCutoff = bode->GetErrCutoff();
+    result.Q = bode->GetQ();
+    result.errQ = bode->GetErrQ();
+    result.GBW = bode->GetGBW();
+    result.errGBW = bode->GetErrGBW();
+
+    // windows run one after the other here, the pool is already busy with files
+    if(result.status && fScanTrim[0] + fScanTrim[1] > 0){
+        BodeWindowScan scan(*bode);
+        scan.SetTrim(fScanTrim[0], fScanTrim[1]);
+        scan.SetThreshold(fScanThreshold);
+        scan.SetNThreads(1);
+        scan.Run();
+        result.stable = scan.IsStable();
+        result.maxPull = scan.GetMaxPull(1);
+        if(bode->GetFilter() == BodeModel::kBandpass) result.maxPull = std::max(result.maxPull, scan.GetMaxPull(2));
+    }
+
+    if(plot){
+        *plot = bode->GetPlotData(_fitphase);
+        plot->label = filename;
+    }
+
+    return result;
+}
+
+Bool_t BodeBatch::Run(){
+
+    // ROOT global state has to be made thread aware before the first worker starts;
+    // TMinuit keeps a static instance, Minuit2 does not
+    ROOT::EnableThreadSafety();
+    ROOT::Math::MinimizerOptions::SetDefaultMinimizer("Minuit2");
+
+    fResults.assign(fFiles.size(), BodeResult_t());
+
+    // kept by index, so that the pages follow the files and not the order fits end in
+    std::vector<BodePlot_t> plots(fPlotOutput.empty()? 0 : fFiles.size());
+
+    // one cache for all tasks, entries are separate files
+    std::unique_ptr<BodeFitCache> cache;
+    if(!fCacheDir.empty()) cache.reset(new BodeFitCache(fCacheDir.c_str()));
+
+    // at most one Bode per worker is ever made, whatever the number of files
+    BodePool bodes;
+    ThreadPool pool(fNThreads);
+    pool.ParallelFor(fFiles.size(), [this, &plots, &cache, &bodes](std::size_t i){
+        fResults[i] = Process(fFiles[i], plots.empty()? 0 : &plots[i], cache.get(), bodes);
+    });
+
+    if(!plots.empty()){
+        BodeRenderer renderer(fPlotOutput.c_str());
+        for(BodePlot_t &plot: plots){
+            if(!plot.sweep.Empty()) renderer.Push(std::move(plot));
+        }
+        renderer.Close();
+    }
+
+    Int_t failed = std::count_if(fResults.begin(), fResults.end(), [](const BodeResult_t &r){ return !r.status; });
+    if(failed > 0){
+        fprintf(stderr, "%s\n", Logger::warning(Form("%d of %zu sweeps could not be read or fitted", failed, fFiles.size())));
+    }
+    Int_t rejected = std::count_if(fResults.begin(), fResults.end(), [](const BodeResult_t &r){ return r.stable == 0; });
+    if(rejected > 0){
+        fprintf(stderr, "%s\n", Logger::warning(Form("%d of %zu sweeps rejected by the window scan", rejected, fFiles.size())));
+    }
+
+    return failed == 0 && rejected == 0;
+}
+
+Bool_t BodeBatch::WriteResults(const char *filename) const {
+
+    FILE *out = fopen(filename, "w");
+    if(!out){
+        printf("%s", Logger::error(Form("cannot open '%s' for writing.", filename)));
+        return false;
+    }
+
+    fprintf(out, "# file\tstatus\tnpoints\tmalformed\tgain\terr_gain\tcutoff\terr_cutoff\tQ\terr_Q\tGBW\terr_GBW\tstable\tmax_pull\n");
+    for(const BodeResult_t &r: fResults){
+        fprintf(out, "%s\t%d\t%d\t%d\t%.10g\t%.10g\t%.10g\t%.10g\t%.10g\t%.10g\t%.10g\t%.10g\t%d\t%.4g\n",
+            r.filename.c_str(), r.status, r.npoints, r.malformed,
+            r.gain, r.errGain, r.cutoff, r.errCutoff, r.Q, r.errQ, r.GBW, r.errGBW, r.stable, r.maxPull);
+    }
+    fclose(out);
+
+    return true;
+}
@@ -0,0 +1,205 @@
+/**
+ * @file Chi2.cpp
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include<cmath>
+#include<limits>
+
+#include"Bode/Chi2.h"
+
+using namespace BodeModel;
+
+Chi2Function::Chi2Function(Filter_t filter, std::size_t n, const double *x, const double *ex){
+    fFilter = filter;
+    fN = n;
+    fX = x;
+    fEX = ex;
+    fXmin = -std::numeric_limits<double>::infinity();
+    fXmax = std::numeric_limits<double>::infinity();
+}
+
+void Chi2Function::AddTerm(Component_t comp, const double *y, const double *ey){
+    Term_t term;
+    term.comp = comp;
+    term.y = y;
+    term.ey = ey;
+    ResetWeights(term);
+    if(comp == kGain) fGainTerm = fTerms.size();
+    else fPhaseTerm = fTerms.size();
+    fTerms.push_back(term);
+}
+
+void Chi2Function::ResetWeights(Term_t &term) const {
+    term.w.resize(fN);
+    for(std::size_t i = 0; i < fN; i++){
+        bool inrange = fX[i] >= fXmin && fX[i] <= fXmax;
+        bool finite = std::isfinite(fX[i]) && std::isfinite(term.y[i]) && (!fEX || std::isfinite(fEX[i]));
+        term.w[i] = (inrange && finite && term.ey[i] > 0)? 1/(term.ey[i]*term.ey[i]) : 0;
+    }
+}
+
+void Chi2Function::SetRange(double xmin, double xmax){
+    if(xmin < xmax){
+        fXmin = xmin;
+        fXmax = xmax;
+    }else{
+        fXmin = -std::numeric_limits<double>::infinity();
+        fXmax = std::numeric_limits<double>::infinity();
+    }
+    for(Term_t &term: fTerms) ResetWeights(term);
+}
+
+void Chi2Function::UpdateWeights(const double *p){
+    if(!fEX) return;
+    for(Term_t &term: fTerms){
+        for(std::size_t i = 0; i < fN; i++){
+            if(term.w[i] == 0) continue;
+            double sx = Slope(fFilter, term.comp, fX[i], p)*fEX[i];
+            term.w[i] = 1/(term.ey[i]*term.ey[i] + sx*sx);
+        }
+    }
+}
+
+std::size_t Chi2Function::NData() const {
+    std::size_t n = 0;
+    for(const Term_t &term: fTerms){
+        for(std::size_t i = 0; i < fN; i++) n += (term.w[i] > 0);
+    }
+    return n;
+}
+
+template<class Model>
+double Chi2Function::DoEval(const double *p, double *grad) const {
+
+    const int npar = Model::NPar;
+    double chi2 = 0;
+    double g[kMaxPar];
+
+    if(grad){
+        for(int k = 0; k < npar; k++) grad[k] = 0;
+    }
+
+    for(const Term_t &term: fTerms){
+        const bool isgain = (term.comp == kGain);
+        const double *w = term.w.data();
+
+        for(std::size_t i = 0; i < fN; i++){
+            if(w[i] == 0) continue;
+            double model;
+            if(grad){
+                model = isgain? Model::GainGrad(fX[i], p, g) : Model::PhaseGrad(fX[i], p, g);
+            }else{
+                model = isgain? Model::Gain(fX[i], p) : Model::Phase(fX[i], p);
+            }
+            double r = term.y[i] - model;
+            chi2 += w[i]*r*r;
+            if(grad){
+                for(int k = 0; k < npar; k++) grad[k] -= 2*w[i]*r*g[k];
+            }
+        }
+    }
+
+    return chi2;
+}
+
+template<class Model>
+double Chi2Function::DoEvalJoint(const double *p, double *grad) const {
+
+    const int npar = Model::NPar;
+    const double *yg = fTerms[fGainTerm].y;
+    const double *yp = fTerms[fPhaseTerm].y;
+    const double *wg = fTerms[fGainTerm].w.data();
+    const double *wp = fTerms[fPhaseTerm].w.data();
+
+    double chi2 = 0;
+    double acc[kMaxPar] = {0};
+    double gg[kMaxPar], gp[kMaxPar];
+    double gain, phase;
+
+    // zero weight points are skipped, not multiplied by 0: their y may be NaN
+    for(std::size_t i = 0; i < fN; i++){
+        if(wg[i] == 0 && wp[i] == 0) continue;
+        Model::ResponseGrad(fX[i], p, gain, gg, phase, gp);
+        if(wg[i] != 0){
+            double rg = yg[i] - gain;
+            chi2 += wg[i]*rg*rg;
+            for(int k = 0; k < npar; k++) acc[k] -= 2*wg[i]*rg*gg[k];
+        }
+        if(wp[i] != 0){
+            double rp = yp[i] - phase;
+            chi2 += wp[i]*rp*rp;
+            for(int k = 0; k < npar; k++) acc[k] -= 2*wp[i]*rp*gp[k];
+        }
+    }
+
+    if(grad){
+        for(int k = 0; k < npar; k++) grad[k] = acc[k];
+    }
+
+    return chi2;
+}
+
+template<class Model>
+double Chi2Function::DoEvalNormal(const double *p, double *grad, double *hess) const {
+
+    const int npar = Model::NPar;
+    double chi2 = 0;
+    double g[kMaxPar];
+
+    for(int k = 0; k < npar; k++) grad[k] = 0;
+    for(int k = 0; k < npar*npar; k++) hess[k] = 0;
+
+    for(const Term_t &term: fTerms){
+        const bool isgain = (term.comp == kGain);
+        const double *w = term.w.data();
+
+        for(std::size_t i = 0; i < fN; i++){
+            if(w[i] == 0) continue;
+            double model = isgain? Model::GainGrad(fX[i], p, g) : Model::PhaseGrad(fX[i], p, g);
+            double r = term.y[i] - model;
+            chi2 += w[i]*r*r;
+            for(int a = 0; a < npar; a++){
+                grad[a] -= 2*w[i]*r*g[a];
+                for(int b = 0; b <= a; b++) hess[a*npar + b] += 2*w[i]*g[a]*g[b];
+            }
+        }
+    }
+    for(int a = 0; a < npar; a++){
+        for(int b = 0; b < a; b++) hess[b*npar + a] = hess[a*npar + b];
+    }
+
+    return chi2;
+}
+
+double Chi2Function::EvalNormal(const double *p, double *grad, double *hess) const {
+    switch(fFilter){
+        case kLowpass:  return DoEvalNormal<Lowpass>(p, grad, hess);
+        case kHighpass: return DoEvalNormal<Highpass>(p, grad, hess);
+        case kBandpass: return DoEvalNormal<Bandpass>(p, grad, hess);
+        default:        return 0;
+    }
+}
+
+double Chi2Function::EvalGrad(const double *p, double *grad) const {
+    if(IsJoint()){
+        switch(fFilter){
+            case kLowpass:  return DoEvalJoint<Lowpass>(p, grad);
+            case kHighpass: return DoEvalJoint<Highpass>(p, grad);
+            case kBandpass: return DoEvalJoint<Bandpass>(p, grad);
+            default:        return 0;
+        }
+    }
+    switch(fFilter){
+        case kLowpass:  return DoEval<Lowpass>(p, grad);
+        case kHighpass: return DoEval<Highpass>(p, grad);
+        case kBandpass: return DoEval<Bandpass>(p, grad);
+        default:        return 0;
+    }
+}
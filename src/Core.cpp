@@ -0,0 +1,156 @@
+/**
+ * @file Core.cpp
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include<algorithm>
+
+#include"Bode/Core.h"
+#include"Bode/Estimate.h"
+#include"Bode/Propagate.h"
+
+namespace {
+    /// the 8 reading columns of a block holding them one after the other, stride apart
+    RawColumns_t MakeRawColumns(const double *block, std::size_t stride){
+        RawColumns_t raw;
+        raw.Vin = block;
+        raw.fsVin = block + stride;
+        raw.Vout = block + 2*stride;
+        raw.fsVout = block + 3*stride;
+        raw.T = block + 4*stride;
+        raw.fsT = block + 5*stride;
+        raw.dt = block + 6*stride;
+        raw.fsdt = block + 7*stride;
+        return raw;
+    }
+}
+
+bool ReadSweep(const char *filename, Sweep &sweep, std::vector<double> *raw,
+               std::vector<MalformedLine_t> *malformed, std::string *error){
+
+    InputReader data(filename);
+    if(!data.IsOpen()){
+        if(error) *error = std::string("cannot open input file '") + filename + "'.";
+        return false;
+    }
+
+    // readings are parsed a block at a time into a small buffer that stays in
+    // cache, and each block is propagated straight into the sweep columns; the
+    // line count sizes the sweep (and raw) once, trimmed to the rows kept at the end
+    const std::size_t kBlock = 512;
+    std::size_t rows = data.CountRows();
+    sweep.Resize(rows);
+    if(raw) raw->assign(8*rows, 0.);
+
+    std::vector<double> block(8*kBlock);
+    double row[8];
+    std::size_t n = 0, nblock = 0;
+
+    auto flush = [&](){
+        PropagateColumns(nblock, MakeRawColumns(block.data(), kBlock), sweep.Freq() + n, sweep.ErrFreq() + n,
+            sweep.Gain() + n, sweep.ErrGain() + n, sweep.Phase() + n, sweep.ErrPhase() + n);
+        if(raw){
+            for(int c = 0; c < 8; c++) std::copy(&block[c*kBlock], &block[c*kBlock] + nblock, raw->data() + c*rows + n);
+        }
+        n += nblock;
+        nblock = 0;
+    };
+
+    while(data.NextRow(row, 8)){
+        // row: V_in, V_in(fs), V_out, V_out(fs), T, T(fs), dt, dt(fs)
+        if(row[0] == 0 || row[4] <= 0){
+            data.Reject("V_in must be non-zero and T positive");
+            continue;
+        }
+        for(int c = 0; c < 8; c++) block[c*kBlock + nblock] = row[c];
+        if(++nblock == kBlock) flush();
+    }
+    flush();
+    sweep.Resize(n);
+
+    if(raw){
+        // columns packed to the rows kept
+        for(int c = 1; c < 8 && n < rows; c++) std::copy(raw->data() + c*rows, raw->data() + c*rows + n, raw->data() + c*n);
+        raw->resize(8*n);
+    }
+    if(malformed) *malformed = data.GetMalformed();
+
+    return true;
+}
+
+BodeCore::BodeCore(BodeModel::Filter_t filter){
+    fFilter = filter;
+}
+
+BodeCore::BodeCore(const char *filter){
+    fFilter = BodeModel::FilterFromName(filter);
+}
+
+bool BodeCore::ReadInput(const char *filename, std::string *error){
+    _hasseed = false;
+    return ReadSweep(filename, fSweep, 0, &fMalformed, error);
+}
+
+void BodeCore::SetPar(double gain, double cutoff, double Q){
+    fPar[0] = gain;
+    fPar[1] = cutoff;
+    fPar[2] = Q;
+    _hasseed = true;
+}
+
+bool BodeCore::EstimatePar(double xmin, double xmax){
+
+    // only the points the fit will see
+    std::vector<double> f, g, eg;
+    for(std::size_t i = 0; i < fSweep.Size(); i++){
+        if(xmin < xmax && (fSweep.Freq()[i] < xmin || fSweep.Freq()[i] > xmax)) continue;
+        f.push_back(fSweep.Freq()[i]);
+        g.push_back(fSweep.Gain()[i]);
+        eg.push_back(fSweep.ErrGain()[i]);
+    }
+
+    double par[BodeModel::kMaxPar] = {1, 1, 1};
+    if(!BodeModel::Estimate(fFilter, f.size(), f.data(), g.data(), eg.data(), par)) return false;
+    SetPar(par[0], par[1], par[2]);
+
+    return true;
+}
+
+bool BodeCore::DoFit(bool fitgain, bool fitphase, double xmin, double xmax, MinimizeResult_t &result){
+
+    if(fFilter == BodeModel::kUnknown || fSweep.Empty()) return false;
+    if(!_hasseed) EstimatePar(xmin, xmax);
+
+    Chi2Function chi2(fFilter, fSweep.Size(), fSweep.Freq(), fSweep.ErrFreq());
+    if(fitgain) chi2.AddTerm(BodeModel::kGain, fSweep.Gain(), fSweep.ErrGain());
+    if(fitphase) chi2.AddTerm(BodeModel::kPhase, fSweep.Phase(), fSweep.ErrPhase());
+    chi2.SetRange(xmin, xmax);
+
+    // phase alone says nothing about the gain
+    double par[BodeModel::kMaxPar];
+    std::copy(fPar, fPar + BodeModel::kMaxPar, par);
+    bool ok = NativeMinimize(chi2, par, !fitgain, result, 0, 1, &fCounters, fOptions);
+
+    // the next fit starts from here
+    if(ok) std::copy(par, par + chi2.NPar(), fPar);
+
+    return ok;
+}
+
+bool BodeCore::FitGain(double xmin, double xmax){
+    return DoFit(true, false, xmin, xmax, fGainResult);
+}
+
+bool BodeCore::FitPhase(double xmin, double xmax){
+    return DoFit(false, true, xmin, xmax, fPhaseResult);
+}
+
+bool BodeCore::FitCorrelated(double xmin, double xmax){
+    return DoFit(true, true, xmin, xmax, fCorrelatedResult);
+}
@@ -0,0 +1,220 @@
+/**
+ * @file Decimate.cpp
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include<algorithm>
+#include<cmath>
+#include<limits>
+
+#include"Bode/Decimate.h"
+
+namespace {
+
+    const double kInf = std::numeric_limits<double>::infinity();
+
+    /// per bin and per component (0 gain, 1 phase); sums are taken from the first value, it keeps var accurate
+    typedef struct {
+        double              ref[2];
+        double              sw[2];
+        double              swy[2];
+        double              swyy[2];
+        std::size_t         lo[2];
+        std::size_t         hi[2];
+        std::size_t         typical[2];
+        double              dtypical[2];
+        double              mean[2];
+        double              rms[2];
+        std::size_t         n;
+    } Bin_t;
+
+    /// curve sampling state, in axis coordinates (log10 where the axis is log)
+    typedef struct {
+        BodeModel::Filter_t filter;
+        BodeModel::Component_t comp;
+        const double       *par;
+        bool                logx;
+        bool                logy;
+        double              tolerance;     ///> absolute, in y axis units
+        int                 maxdepth;
+        std::vector<double> *x;
+        std::vector<double> *y;
+    } Curve_t;
+
+    inline double AxisY(const Curve_t &c, double v){
+        if(!c.logy) return v;
+        return v > 0? std::log10(v) : kInf;
+    }
+
+    inline double Eval(const Curve_t &c, double u){
+        return BodeModel::Eval(c.filter, c.comp, c.logx? std::pow(10, u) : u, c.par);
+    }
+
+    /// appends the points strictly inside (u0, u1)
+    void Refine(const Curve_t &c, double u0, double a0, double u1, double a1, int depth){
+        if(depth >= c.maxdepth) return;
+        double um = 0.5*(u0 + u1);
+        double v = Eval(c, um);
+        double am = AxisY(c, v);
+        bool finite = std::isfinite(a0) && std::isfinite(a1) && std::isfinite(am);
+        if(finite && std::fabs(am - 0.5*(a0 + a1)) <= c.tolerance) return;
+
+        Refine(c, u0, a0, um, am, depth + 1);
+        c.x->push_back(c.logx? std::pow(10, um) : um);
+        c.y->push_back(v);
+        Refine(c, um, am, u1, a1, depth + 1);
+    }
+
+}
+
+std::size_t DecimateSweep(const Sweep &in, Sweep &out, int nbins, double outlier, SweepRange_t *range){
+
+    std::size_t n = in.Size();
+    const double *f = in.Freq();
+    const double *y[2] = {in.Gain(), in.Phase()};
+    const double *ey[2] = {in.ErrGain(), in.ErrPhase()};
+
+    SweepRange_t r = {{kInf, -kInf}, {kInf, -kInf}, {kInf, -kInf}};
+    std::size_t npos = 0;
+    for(std::size_t i = 0; i < n; i++){
+        if(!(f[i] > 0)) continue;
+        npos++;
+        r.freq[0] = std::min(r.freq[0], f[i]);
+        r.freq[1] = std::max(r.freq[1], f[i]);
+        if(y[0][i] > 0){
+            r.gain[0] = std::min(r.gain[0], y[0][i]);
+            r.gain[1] = std::max(r.gain[1], y[0][i]);
+        }
+        r.phase[0] = std::min(r.phase[0], y[1][i]);
+        r.phase[1] = std::max(r.phase[1], y[1][i]);
+    }
+    if(range) *range = r;
+
+    std::vector<char> keep(n, 0);
+
+    if(nbins <= 0 || npos <= 4*std::size_t(nbins)){
+        for(std::size_t i = 0; i < n; i++) keep[i] = (f[i] > 0);
+    }else{
+        double lmin = std::log(r.freq[0]);
+        double scale = (r.freq[1] > r.freq[0])? nbins/(std::log(r.freq[1]) - lmin) : 0;
+
+        std::vector<int> bin(n, -1);
+        std::vector<Bin_t> bins(nbins);
+        for(Bin_t &b: bins) b.n = 0;
+
+        for(std::size_t i = 0; i < n; i++){
+            if(!(f[i] > 0)) continue;
+            int k = std::min(int((std::log(f[i]) - lmin)*scale), nbins - 1);
+            bin[i] = k;
+            Bin_t &b = bins[k];
+            for(int c = 0; c < 2; c++){
+                double w = ey[c][i] > 0? 1/(ey[c][i]*ey[c][i]) : 1;
+                if(b.n == 0){
+                    b.ref[c] = y[c][i];
+                    b.sw[c] = b.swy[c] = b.swyy[c] = 0;
+                    b.lo[c] = b.hi[c] = b.typical[c] = i;
+                    b.dtypical[c] = kInf;
+                }
+                double d = y[c][i] - b.ref[c];
+                b.sw[c] += w;
+                b.swy[c] += w*d;
+                b.swyy[c] += w*d*d;
+                if(y[c][i] < y[c][b.lo[c]]) b.lo[c] = i;
+                if(y[c][i] > y[c][b.hi[c]]) b.hi[c] = i;
+            }
+            b.n++;
+        }
+
+        for(Bin_t &b: bins){
+            if(b.n == 0) continue;
+            for(int c = 0; c < 2; c++){
+                double m = b.swy[c]/b.sw[c];
+                b.mean[c] = b.ref[c] + m;
+                b.rms[c] = std::sqrt(std::max(b.swyy[c]/b.sw[c] - m*m, 0.));
+            }
+        }
+
+        // typical points and outliers need the bin means
+        for(std::size_t i = 0; i < n; i++){
+            if(bin[i] < 0) continue;
+            Bin_t &b = bins[bin[i]];
+            for(int c = 0; c < 2; c++){
+                double d = std::fabs(y[c][i] - b.mean[c]);
+                if(d < b.dtypical[c]){
+                    b.dtypical[c] = d;
+                    b.typical[c] = i;
+                }
+                if(outlier > 0 && b.rms[c] > 0 && d > outlier*b.rms[c]) keep[i] = 1;
+            }
+        }
+
+        for(const Bin_t &b: bins){
+            if(b.n == 0) continue;
+            for(int c = 0; c < 2; c++){
+                keep[b.lo[c]] = 1;
+                keep[b.hi[c]] = 1;
+                keep[b.typical[c]] = 1;
+            }
+        }
+    }
+
+    std::size_t nkept = std::count(keep.begin(), keep.end(), 1);
+    out.Resize(nkept);
+    std::size_t k = 0;
+    for(std::size_t i = 0; i < n; i++){
+        if(!keep[i]) continue;
+        for(int c = 0; c < Sweep::kNColumns; c++) out.Column(Sweep::Column_t(c))[k] = in.Column(Sweep::Column_t(c))[i];
+        k++;
+    }
+
+    return nkept;
+}
+
+std::size_t SampleCurve(BodeModel::Filter_t filter, BodeModel::Component_t comp, const double *par,
+                        double xmin, double xmax, bool logx, bool logy,
+                        std::vector<double> &x, std::vector<double> &y, double tolerance, int maxdepth){
+
+    x.clear();
+    y.clear();
+    if(!(xmax > xmin) || (logx && !(xmin > 0))) return 0;
+
+    Curve_t c = {filter, comp, par, logx, logy, 0, maxdepth, &x, &y};
+    double u0 = logx? std::log10(xmin) : xmin;
+    double u1 = logx? std::log10(xmax) : xmax;
+
+    // coarse grid, plus the cutoff (peak) itself: a narrow resonance could fall
+    // between grid points and never be seen by the refinement
+    const int ncoarse = 64;
+    std::vector<double> u(ncoarse + 1);
+    for(int i = 0; i <= ncoarse; i++) u[i] = u0 + (u1 - u0)*i/ncoarse;
+    if(par[1] > xmin && par[1] < xmax){
+        u.push_back(logx? std::log10(par[1]) : par[1]);
+        std::sort(u.begin(), u.end());
+    }
+
+    std::vector<double> v(u.size()), a(u.size());
+    double amin = kInf, amax = -kInf;
+    for(std::size_t i = 0; i < u.size(); i++){
+        v[i] = Eval(c, u[i]);
+        a[i] = AxisY(c, v[i]);
+        if(std::isfinite(a[i])){
+            amin = std::min(amin, a[i]);
+            amax = std::max(amax, a[i]);
+        }
+    }
+    c.tolerance = tolerance*((amax > amin)? amax - amin : 1);
+
+    for(std::size_t i = 0; i < u.size(); i++){
+        if(i > 0) Refine(c, u[i - 1], a[i - 1], u[i], a[i], 0);
+        x.push_back(logx? std::pow(10, u[i]) : u[i]);
+        y.push_back(v[i]);
+    }
+
+    return x.size();
+}
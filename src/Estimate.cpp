@@ -0,0 +1,219 @@
+/**
+ * @file Estimate.cpp
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include<algorithm>
+#include<cmath>
+#include<numeric>
+#include<vector>
+
+#include"Bode/Estimate.h"
+
+namespace {
+
+    /// solves a x = b in place (k <= 3), partial pivoting; false if singular
+    bool solve(int k, double a[3][3], double *b){
+        for(int c = 0; c < k; c++){
+            int pivot = c;
+            for(int r = c + 1; r < k; r++){
+                if(std::fabs(a[r][c]) > std::fabs(a[pivot][c])) pivot = r;
+            }
+            if(a[pivot][c] == 0 || !std::isfinite(a[pivot][c])) return false;
+            std::swap(a[c], a[pivot]);
+            std::swap(b[c], b[pivot]);
+            for(int r = c + 1; r < k; r++){
+                double m = a[r][c]/a[c][c];
+                for(int j = c; j < k; j++) a[r][j] -= m*a[c][j];
+                b[r] -= m*b[c];
+            }
+        }
+        for(int c = k - 1; c >= 0; c--){
+            for(int j = c + 1; j < k; j++) b[c] -= a[c][j]*b[j];
+            b[c] /= a[c][c];
+        }
+        return true;
+    }
+
+    /// log f where the gain crosses level between points i and j, interpolated in log-log
+    double crossing(const double *f, const double *g, std::size_t i, std::size_t j, double level){
+        double li = std::log(g[i]), lj = std::log(g[j]), ll = std::log(level);
+        double t = (li == lj)? 0.5 : (li - ll)/(li - lj);
+        return std::exp(std::log(f[i]) + t*(std::log(f[j]) - std::log(f[i])));
+    }
+
+    bool physical(BodeModel::Filter_t filter, const double *par, double fmin, double fmax){
+        // a cutoff more than a decade outside the sweep is an extrapolation, not an estimate
+        bool ok = std::isfinite(par[0]) && par[0] > 0 && std::isfinite(par[1]) && par[1] > fmin/10 && par[1] < fmax*10;
+        if(filter == BodeModel::kBandpass) ok = ok && std::isfinite(par[2]) && par[2] > 0;
+        return ok;
+    }
+
+}
+
+namespace BodeModel {
+
+    bool EstimateLinear(Filter_t filter, std::size_t n, const double *f, const double *gain, const double *egain, double *par){
+
+        if(filter == kUnknown || n < std::size_t(NPar(filter))) return false;
+
+        // frequencies relative to their geometric mean keep f^2 and 1/f^2 of order one
+        double lref = 0;
+        std::size_t m = 0;
+        for(std::size_t i = 0; i < n; i++){
+            if(f[i] > 0 && gain[i] > 0){ lref += std::log(f[i]); m++; }
+        }
+        if(m < std::size_t(NPar(filter))) return false;
+        double fref = std::exp(lref/m);
+
+        // y = 1/H^2 = sum_k c_k b_k(u), sigma_y = 2 eH/H^3; without errors H is taken to scale with H
+        int k = (filter == kBandpass)? 3 : 2;
+        double a[3][3] = {{0}}, b[3] = {0};
+        for(std::size_t i = 0; i < n; i++){
+            if(f[i] <= 0 || gain[i] <= 0) continue;
+            double u2 = (f[i]/fref)*(f[i]/fref);
+            double h = gain[i];
+            double y = 1/(h*h);
+            double w = (egain && egain[i] > 0)? std::pow(h, 6)/(4*egain[i]*egain[i]) : std::pow(h, 4);
+
+            double basis[3] = {1, 0, 0};
+            if(filter == kLowpass) basis[1] = u2;
+            else if(filter == kHighpass) basis[1] = 1/u2;
+            else{ basis[1] = u2; basis[2] = 1/u2; }
+
+            for(int r = 0; r < k; r++){
+                b[r] += w*basis[r]*y;
+                for(int c = 0; c < k; c++) a[r][c] += w*basis[r]*basis[c];
+            }
+        }
+        if(!solve(k, a, b)) return false;
+
+        double est[kMaxPar] = {0, 0, 0};
+        switch(filter){
+            case kLowpass:
+                if(b[0] <= 0 || b[1] <= 0) return false;
+                est[0] = 1/std::sqrt(b[0]);
+                est[1] = fref*std::sqrt(b[0]/b[1]);
+                break;
+            case kHighpass:
+                if(b[0] <= 0 || b[1] <= 0) return false;
+                est[0] = 1/std::sqrt(b[0]);
+                est[1] = fref*std::sqrt(b[1]/b[0]);
+                break;
+            case kBandpass: {
+                if(b[1] <= 0 || b[2] <= 0) return false;
+                double q2g2 = std::sqrt(b[1]*b[2]);     // Q^2/G^2
+                double ig2 = b[0] + 2*q2g2;             // 1/G^2
+                if(ig2 <= 0) return false;
+                est[0] = 1/std::sqrt(ig2);
+                est[1] = fref*std::pow(b[2]/b[1], 0.25);
+                est[2] = std::sqrt(q2g2)*est[0];
+                break;
+            }
+            default:
+                return false;
+        }
+
+        double fmin = *std::min_element(f, f + n), fmax = *std::max_element(f, f + n);
+        if(!physical(filter, est, fmin, fmax)) return false;
+
+        std::copy(est, est + NPar(filter), par);
+        return true;
+    }
+
+    bool EstimateCrossing(Filter_t filter, std::size_t n, const double *f, const double *gain, double *par){
+
+        if(filter == kUnknown || n < 2) return false;
+
+        // sorted copy, positive points only
+        std::vector<std::size_t> idx(n);
+        std::iota(idx.begin(), idx.end(), 0);
+        idx.erase(std::remove_if(idx.begin(), idx.end(), [&](std::size_t i){ return !(f[i] > 0 && gain[i] > 0); }), idx.end());
+        std::sort(idx.begin(), idx.end(), [&](std::size_t i, std::size_t j){ return f[i] < f[j]; });
+        std::size_t m = idx.size();
+        if(m < 2) return false;
+
+        std::vector<double> fs(m), gs(m);
+        for(std::size_t i = 0; i < m; i++){ fs[i] = f[idx[i]]; gs[i] = gain[idx[i]]; }
+
+        double est[kMaxPar] = {0, 0, 1};
+
+        if(filter == kLowpass || filter == kHighpass){
+            // plateau: median of the tenth of the points on the pass side
+            std::size_t k = std::max<std::size_t>(1, m/10);
+            std::vector<double> plateau;
+            if(filter == kLowpass) plateau.assign(gs.begin(), gs.begin() + k);
+            else plateau.assign(gs.end() - k, gs.end());
+            std::nth_element(plateau.begin(), plateau.begin() + k/2, plateau.end());
+            est[0] = plateau[k/2];
+
+            double level = est[0]/std::sqrt(2);
+            std::size_t closest = 0;
+            est[1] = 0;
+            for(std::size_t i = 0; i + 1 < m; i++){
+                bool down = gs[i] >= level && gs[i+1] < level;
+                bool up = gs[i] < level && gs[i+1] >= level;
+                if((filter == kLowpass && down) || (filter == kHighpass && up)){
+                    est[1] = crossing(fs.data(), gs.data(), i, i + 1, level);
+                    break;
+                }
+                if(std::fabs(gs[i] - level) < std::fabs(gs[closest] - level)) closest = i;
+            }
+            // no crossing inside the sweep: the point closest to -3 dB is the best guess
+            if(est[1] == 0) est[1] = fs[closest];
+        }else{
+            std::size_t peak = std::max_element(gs.begin(), gs.end()) - gs.begin();
+            est[0] = gs[peak];
+            est[1] = fs[peak];
+            double level = est[0]/std::sqrt(2);
+
+            double flo = 0, fhi = 0;
+            for(std::size_t i = peak; i > 0; i--){
+                if(gs[i-1] < level){ flo = crossing(fs.data(), gs.data(), i, i - 1, level); break; }
+            }
+            for(std::size_t i = peak; i + 1 < m; i++){
+                if(gs[i+1] < level){ fhi = crossing(fs.data(), gs.data(), i, i + 1, level); break; }
+            }
+
+            // f0 = sqrt(flo fhi) and Q = f0/(fhi - flo); with one side only, |f/f0 - f0/f| = 1/Q there
+            if(flo > 0 && fhi > 0){
+                est[1] = std::sqrt(flo*fhi);
+                est[2] = est[1]/(fhi - flo);
+            }else if(flo > 0 || fhi > 0){
+                double fx = (flo > 0)? flo : fhi;
+                est[2] = 1/std::fabs(fx/est[1] - est[1]/fx);
+            }
+        }
+
+        if(!physical(filter, est, fs.front(), fs.back())) return false;
+
+        std::copy(est, est + NPar(filter), par);
+        return true;
+    }
+
+    bool Estimate(Filter_t filter, std::size_t n, const double *f, const double *gain, const double *egain, double *par){
+
+        double lin[kMaxPar], cross[kMaxPar];
+        bool haslin = EstimateLinear(filter, n, f, gain, egain, lin);
+        bool hascross = EstimateCrossing(filter, n, f, gain, cross);
+
+        // the linear solution uses every point; it loses to the crossing only when
+        // the two disagree by more than a factor 3 on the cutoff
+        if(haslin && (!hascross || std::fabs(std::log(lin[1]/cross[1])) < std::log(3.))){
+            std::copy(lin, lin + NPar(filter), par);
+            return true;
+        }
+        if(hascross){
+            std::copy(cross, cross + NPar(filter), par);
+            return true;
+        }
+        return false;
+    }
+
+}
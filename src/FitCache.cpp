@@ -0,0 +1,261 @@
+/**
+ * @file FitCache.cpp
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include<cerrno>
+#include<cstdio>
+#include<cstring>
+#include<functional>
+#include<thread>
+#include<vector>
+
+#include<sys/stat.h>
+#include<unistd.h>
+
+#include<TString.h>
+
+#include"Bode/FitCache.h"
+#include"Logger.h"
+
+namespace {
+
+    // bump whenever the models, the chi2 or the minimization change what a fit returns
+    const std::uint64_t kFormat = 2;
+    const char          kMagic[8] = {'B', 'O', 'D', 'E', 'F', 'I', 'T', '1'};
+
+    inline std::uint64_t mix(std::uint64_t x){
+        x ^= x >> 30; x *= 0xBF58476D1CE4E5B9ULL;
+        x ^= x >> 27; x *= 0x94D049BB133111EBULL;
+        x ^= x >> 31;
+        return x;
+    }
+
+    /// two independent 64-bit lanes, one word at a time, order dependent
+    struct Hasher_t {
+        std::uint64_t a = 0x243F6A8885A308D3ULL;
+        std::uint64_t b = 0x13198A2E03707344ULL;
+
+        void Add(std::uint64_t w){
+            a = (a ^ mix(w)) * 0x9E3779B97F4A7C15ULL;
+            b = (b ^ mix(w ^ 0xA4093822299F31D0ULL)) * 0xC2B2AE3D27D4EB4FULL;
+            b = (b << 29) | (b >> 35);
+        }
+        void Add(double x){
+            std::uint64_t w;
+            std::memcpy(&w, &x, sizeof(w));
+            Add(w);
+        }
+        void Add(const double *v, std::size_t n){
+            for(std::size_t i = 0; i < n; i++) Add(v[i]);
+        }
+    };
+
+    /// gives the cached numbers back to the ROOT result type, whose fields are protected
+    class CachedResult : public ROOT::Fit::FitResult {
+    public:
+        CachedResult(int npar, bool valid, int status, int covstatus, unsigned ndf, unsigned nfree, unsigned ncalls,
+                     std::uint32_t fixed, double chi2, double minfcn, double edm,
+                     const double *par, const double *err, const double *cov){
+            fValid = valid;
+            fStatus = status;
+            fCovStatus = covstatus;
+            fNdf = ndf;
+            fNFree = nfree;
+            fNCalls = ncalls;
+            fChi2 = chi2;
+            fVal = minfcn;
+            fEdm = edm;
+            fMinimType = "Minuit2 (cached)";
+            fParams.assign(par, par + npar);
+            fErrors.assign(err, err + npar);
+            fCovMatrix.assign(cov, cov + npar*(npar + 1)/2);
+            for(int i = 0; i < npar; i++){
+                if(fixed & (1u << i)) fFixedParams[i] = true;
+            }
+        }
+    };
+
+    template<class T>
+    void put(std::string &buf, const T &value){
+        buf.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    template<class T>
+    bool get(const char *&cur, const char *end, T &value){
+        if(end - cur < static_cast<long>(sizeof(T))) return false;
+        std::memcpy(&value, cur, sizeof(T));
+        cur += sizeof(T);
+        return true;
+    }
+
+    bool makedirs(const std::string &dir){
+        for(std::size_t pos = 1; pos <= dir.size(); pos++){
+            if(pos < dir.size() && dir[pos] != '/') continue;
+            std::string sub = dir.substr(0, pos);
+            if(mkdir(sub.c_str(), 0755) != 0 && errno != EEXIST) return false;
+        }
+        return true;
+    }
+
+}
+
+BodeFitCache::BodeFitCache(const char *dir) : fDir(dir), fHits(0), fMisses(0) {
+    if(fDir.empty()) fDir = ".";
+    if(!makedirs(fDir)){
+        fprintf(stderr, "%s\n", Logger::warning(Form("BodeFitCache: cannot create '%s', results will not be kept", fDir.c_str())));
+    }
+}
+
+BodeFitCache::Key_t BodeFitCache::MakeKey(const Sweep &sweep, BodeModel::Filter_t filter, bool fitgain, bool fitphase,
+                                          double xmin, double xmax, const double *seed, int gainpar, int cutoffpar){
+
+    Hasher_t hash;
+    hash.Add(kFormat);
+    hash.Add(static_cast<std::uint64_t>(filter));
+    hash.Add(static_cast<std::uint64_t>(fitgain) | static_cast<std::uint64_t>(fitphase) << 1);
+    // an empty range means the whole sweep, whatever the two numbers
+    hash.Add(xmin < xmax? xmin : 0.);
+    hash.Add(xmin < xmax? xmax : 0.);
+    hash.Add(seed, BodeModel::NPar(filter));
+    // the minimizer treats these two differently (fixed gain, positive cutoff)
+    hash.Add(static_cast<std::uint64_t>(gainpar));
+    hash.Add(static_cast<std::uint64_t>(cutoffpar));
+
+    std::size_t n = sweep.Size();
+    hash.Add(static_cast<std::uint64_t>(n));
+    hash.Add(sweep.Freq(), n);
+    hash.Add(sweep.ErrFreq(), n);
+    if(fitgain){
+        hash.Add(sweep.Gain(), n);
+        hash.Add(sweep.ErrGain(), n);
+    }
+    if(fitphase){
+        hash.Add(sweep.Phase(), n);
+        hash.Add(sweep.ErrPhase(), n);
+    }
+
+    Key_t key = {{mix(hash.a), mix(hash.b)}};
+    return key;
+}
+
+std::string BodeFitCache::ToHex(const Key_t &key){
+    char hex[33];
+    snprintf(hex, sizeof(hex), "%016llx%016llx", static_cast<unsigned long long>(key.h[0]), static_cast<unsigned long long>(key.h[1]));
+    return hex;
+}
+
+std::string BodeFitCache::Path(const Key_t &key) const {
+    return fDir + "/" + ToHex(key) + ".fit";
+}
+
+void BodeFitCache::Encode(const ROOT::Fit::FitResult &result, std::string &buf){
+
+    std::int32_t npar = result.NTotalParameters();
+    std::uint32_t fixed = 0;
+    for(int i = 0; i < npar; i++){
+        if(result.IsParameterFixed(i)) fixed |= 1u << i;
+    }
+
+    put(buf, npar);
+    put(buf, static_cast<std::int32_t>(result.IsValid()));
+    put(buf, static_cast<std::int32_t>(result.Status()));
+    put(buf, static_cast<std::int32_t>(result.CovMatrixStatus()));
+    put(buf, static_cast<std::uint32_t>(result.Ndf()));
+    put(buf, static_cast<std::uint32_t>(result.NFreeParameters()));
+    put(buf, static_cast<std::uint32_t>(result.NCalls()));
+    put(buf, fixed);
+    put(buf, result.Chi2());
+    put(buf, result.MinFcnValue());
+    put(buf, result.Edm());
+    for(int i = 0; i < npar; i++) put(buf, result.GetParams()[i]);
+    for(int i = 0; i < npar; i++) put(buf, result.GetErrors()[i]);
+    for(int i = 0; i < npar; i++){
+        for(int j = 0; j <= i; j++) put(buf, result.CovMatrix(i, j));
+    }
+}
+
+bool BodeFitCache::Decode(const char *&cur, const char *end, ROOT::Fit::FitResult &result){
+
+    std::int32_t npar, valid, status, covstatus;
+    std::uint32_t ndf, nfree, ncalls, fixed;
+    double chi2, minfcn, edm;
+
+    bool ok = get(cur, end, npar) && npar > 0 && npar <= 32
+        && get(cur, end, valid) && get(cur, end, status) && get(cur, end, covstatus)
+        && get(cur, end, ndf) && get(cur, end, nfree) && get(cur, end, ncalls) && get(cur, end, fixed)
+        && get(cur, end, chi2) && get(cur, end, minfcn) && get(cur, end, edm);
+
+    std::size_t nvalues = ok? 2*npar + npar*(npar + 1)/2 : 0;
+    if(!ok || static_cast<std::size_t>(end - cur) < nvalues*sizeof(double)) return false;
+
+    std::vector<double> values(nvalues);
+    std::memcpy(values.data(), cur, nvalues*sizeof(double));
+    cur += nvalues*sizeof(double);
+    const double *par = values.data(), *err = par + npar, *cov = err + npar;
+
+    result = CachedResult(npar, valid, status, covstatus, ndf, nfree, ncalls, fixed, chi2, minfcn, edm, par, err, cov);
+    return true;
+}
+
+bool BodeFitCache::Store(const Key_t &key, const ROOT::Fit::FitResult &result) const {
+
+    std::int32_t npar = result.NTotalParameters();
+    if(!result.IsValid() || npar <= 0 || npar > 32) return false;
+
+    std::string buf;
+    buf.append(kMagic, sizeof(kMagic));
+    put(buf, key);
+    Encode(result, buf);
+
+    // readers never see a partial entry: write aside, then rename over
+    std::string path = Path(key);
+    std::string tmp = path + Form(".%d.%zu.tmp", getpid(), std::hash<std::thread::id>()(std::this_thread::get_id()));
+    FILE *out = fopen(tmp.c_str(), "wb");
+    if(!out) return false;
+    bool ok = fwrite(buf.data(), 1, buf.size(), out) == buf.size();
+    ok &= (fclose(out) == 0);
+    ok = ok && rename(tmp.c_str(), path.c_str()) == 0;
+    if(!ok) remove(tmp.c_str());
+
+    return ok;
+}
+
+bool BodeFitCache::Load(const Key_t &key, ROOT::Fit::FitResult &result){
+
+    FILE *in = fopen(Path(key).c_str(), "rb");
+    if(!in){
+        fMisses++;
+        return false;
+    }
+    std::vector<char> buf(4096);
+    std::size_t size = fread(buf.data(), 1, buf.size(), in);
+    fclose(in);
+
+    const char *cur = buf.data(), *end = buf.data() + size;
+    char magic[sizeof(kMagic)];
+    Key_t stored;
+
+    bool ok = get(cur, end, magic) && std::memcmp(magic, kMagic, sizeof(kMagic)) == 0
+        && get(cur, end, stored) && stored.h[0] == key.h[0] && stored.h[1] == key.h[1]
+        && Decode(cur, end, result) && cur == end;
+    if(!ok){
+        fprintf(stderr, "%s\n", Logger::warning(Form("BodeFitCache: ignoring unreadable entry %s", Path(key).c_str())));
+        fMisses++;
+        return false;
+    }
+    // written by a version that kept failed fits too
+    if(!result.IsValid()){
+        fMisses++;
+        return false;
+    }
+    fHits++;
+
+    return true;
+}
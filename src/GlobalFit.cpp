@@ -0,0 +1,279 @@
+/**
+ * @file GlobalFit.cpp
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include<algorithm>
+#include<atomic>
+#include<cmath>
+
+#include"Bode/Estimate.h"
+#include"Bode/GlobalFit.h"
+#include"Bode/ThreadPool.h"
+
+using namespace BodeModel;
+
+namespace {
+    const int M = kMaxPar;
+}
+
+BodeGlobalFit::BodeGlobalFit(Filter_t filter){
+    fFilter = filter;
+}
+
+BodeGlobalFit::BodeGlobalFit(const char *filter){
+    fFilter = FilterFromName(filter);
+}
+
+int BodeGlobalFit::Slot(int par) const {
+    int slot = 0;
+    for(int k = 0; k < par; k++) slot += (fRole[k] == fRole[par]);
+    return slot;
+}
+
+bool BodeGlobalFit::Step(ThreadPool &pool, const std::vector<double> &grad, const std::vector<double> &hess, double lambda, std::vector<double> &trial){
+
+    const std::size_t n = fSweeps.size();
+    const int ns = fNShared, nl = fNLocal;
+    int sidx[M], lidx[M];
+    for(int k = 0, is = 0, il = 0; k < NPar(fFilter); k++){
+        if(fRole[k] == kShared) sidx[is++] = k;
+        if(fRole[k] == kLocal) lidx[il++] = k;
+    }
+
+    // normal equations are J^T W J dp = -grad/2, hess being 2 J^T W J
+    double A[M][M] = {}, schur[M][M] = {}, rs[M] = {};
+    std::vector<double> u(n*nl);
+    fCInv.assign(n*nl*nl, 0);
+    fCB.assign(n*nl*ns, 0);
+
+    // each board's share of A, of the Schur complement and of r_s, summed below in
+    // board order: the step does not depend on the number of threads
+    const int np = 2*ns*ns + ns;
+    std::vector<double> part(n*np);
+    std::atomic<bool> singular(false);
+
+    pool.ParallelFor(n, [&](std::size_t j){
+        const double *H = &hess[j*M*M], *g = &grad[j*M];
+        double *Aj = &part[j*np], *Sj = Aj + ns*ns, *rj = Sj + ns*ns;
+
+        double C[M][M], B[M][M], rl[M];
+        for(int a = 0; a < nl; a++){
+            for(int b = 0; b < nl; b++) C[a][b] = 0.5*H[lidx[a]*M + lidx[b]];
+            C[a][a] = (C[a][a] > 0)? C[a][a]*(1 + lambda) : lambda;
+            rl[a] = -0.5*g[lidx[a]];
+        }
+        for(int a = 0; a < ns; a++){
+            for(int b = 0; b < nl; b++) B[a][b] = 0.5*H[sidx[a]*M + lidx[b]];
+            for(int b = 0; b < ns; b++) Aj[a*ns + b] = 0.5*H[sidx[a]*M + sidx[b]];
+            rj[a] = -0.5*g[sidx[a]];
+        }
+        if(nl > 0 && !InvertMatrix(C, nl)){
+            singular = true;
+            return;
+        }
+
+        // C^-1 r_l and C^-1 B^T, then their share of the Schur complement
+        double *cinv = &fCInv[j*nl*nl], *cb = &fCB[j*nl*ns], *uj = &u[j*nl];
+        for(int a = 0; a < nl; a++){
+            uj[a] = 0;
+            for(int b = 0; b < nl; b++){
+                cinv[a*nl + b] = C[a][b];
+                uj[a] += C[a][b]*rl[b];
+            }
+            for(int s = 0; s < ns; s++){
+                cb[a*ns + s] = 0;
+                for(int b = 0; b < nl; b++) cb[a*ns + s] += C[a][b]*B[s][b];
+            }
+        }
+        for(int a = 0; a < ns; a++){
+            for(int b = 0; b < ns; b++){
+                Sj[a*ns + b] = 0;
+                for(int k = 0; k < nl; k++) Sj[a*ns + b] += B[a][k]*cb[k*ns + b];
+            }
+            for(int k = 0; k < nl; k++) rj[a] -= B[a][k]*uj[k];
+        }
+    }, 64);
+    if(singular) return false;
+
+    for(std::size_t j = 0; j < n; j++){
+        const double *Aj = &part[j*np], *Sj = Aj + ns*ns, *rj = Sj + ns*ns;
+        for(int a = 0; a < ns; a++){
+            for(int b = 0; b < ns; b++){
+                A[a][b] += Aj[a*ns + b];
+                schur[a][b] += Sj[a*ns + b];
+            }
+            rs[a] += rj[a];
+        }
+    }
+
+    double S[M][M], ds[M] = {};
+    for(int a = 0; a < ns; a++){
+        for(int b = 0; b < ns; b++) S[a][b] = A[a][b] - schur[a][b];
+        S[a][a] += (A[a][a] > 0)? lambda*A[a][a] : lambda;
+    }
+    if(ns > 0 && !InvertMatrix(S, ns)) return false;
+    fCovShared.assign(ns*ns, 0);
+    for(int a = 0; a < ns; a++){
+        for(int b = 0; b < ns; b++){
+            fCovShared[a*ns + b] = S[a][b];
+            ds[a] += S[a][b]*rs[b];
+        }
+    }
+
+    trial = fPar;
+    for(std::size_t j = 0; j < n; j++){
+        double *p = &trial[j*M];
+        const double *cb = &fCB[j*nl*ns], *uj = &u[j*nl];
+        for(int a = 0; a < ns; a++) p[sidx[a]] += ds[a];
+        for(int a = 0; a < nl; a++){
+            double dl = uj[a];
+            for(int s = 0; s < ns; s++) dl -= cb[a*ns + s]*ds[s];
+            p[lidx[a]] += dl;
+        }
+    }
+
+    return true;
+}
+
+bool BodeGlobalFit::Fit(){
+
+    _valid = false;
+    fNIter = 0;
+    const std::size_t n = fSweeps.size();
+    const int npar = NPar(fFilter);
+    if(n == 0 || fFilter == kUnknown || (!_fitgain && !_fitphase)) return false;
+
+    fNShared = fNLocal = 0;
+    for(int k = 0; k < M; k++){
+        fRole[k] = (k >= npar || (k == 0 && !_fitgain))? kFixed : fShared[k]? kShared : kLocal;
+        if(fRole[k] == kShared) fNShared++;
+        if(fRole[k] == kLocal) fNLocal++;
+    }
+
+    // start: each board estimated alone, shared parameters at the median
+    fPar.assign(n*M, 1);
+    for(std::size_t j = 0; j < n; j++){
+        const Sweep &s = *fSweeps[j];
+        if(!Estimate(fFilter, s.Size(), s.Freq(), s.Gain(), s.ErrGain(), &fPar[j*M])) return false;
+    }
+    for(int k = 0; k < npar; k++){
+        if(fRole[k] != kShared) continue;
+        std::vector<double> v(n);
+        for(std::size_t j = 0; j < n; j++) v[j] = fPar[j*M + k];
+        std::nth_element(v.begin(), v.begin() + n/2, v.end());
+        for(std::size_t j = 0; j < n; j++) fPar[j*M + k] = v[n/2];
+    }
+
+    std::vector<Chi2Function> chi2;
+    chi2.reserve(n);
+    for(std::size_t j = 0; j < n; j++){
+        const Sweep &s = *fSweeps[j];
+        chi2.emplace_back(fFilter, s.Size(), s.Freq(), s.ErrFreq());
+        if(_fitgain) chi2.back().AddTerm(kGain, s.Gain(), s.ErrGain());
+        if(_fitphase) chi2.back().AddTerm(kPhase, s.Phase(), s.ErrPhase());
+    }
+
+    // boards are independent given the parameters: evaluated, and reduced in Step, in parallel
+    ThreadPool pool(fNThreads);
+    std::vector<double> value(n);
+    auto evaluate = [&](const std::vector<double> &par, std::vector<double> &grad, std::vector<double> &hess){
+        grad.resize(n*M);
+        hess.resize(n*M*M);
+        pool.ParallelFor(n, [&](std::size_t j){
+            value[j] = (par[j*M + 1] > 0)? chi2[j].EvalNormal(&par[j*M], &grad[j*M], &hess[j*M*M]) : HUGE_VAL;
+        }, 64);
+        double total = 0;
+        for(double v: value) total += v;
+        return total;
+    };
+
+    std::vector<double> grad, hess, tgrad, thess, trial;
+    double total = 0;
+    bool ok = true;
+    for(int pass = 0; pass < 2 && ok; pass++){
+        for(std::size_t j = 0; j < n; j++) chi2[j].UpdateWeights(&fPar[j*M]);
+        total = evaluate(fPar, grad, hess);
+        if(!std::isfinite(total)) return false;
+
+        double lambda = fOptions.lambda;
+        bool converged = false;
+        for(int it = 0; it < fOptions.maxiter && !converged; it++){
+            fNIter++;
+            if(!Step(pool, grad, hess, lambda, trial)){
+                ok = false;
+                break;
+            }
+            double tvalue = evaluate(trial, tgrad, thess);
+            if(std::isfinite(tvalue) && tvalue <= total){
+                converged = (total - tvalue) <= fOptions.tolerance*(1 + total);
+                fPar.swap(trial);
+                grad.swap(tgrad);
+                hess.swap(thess);
+                total = tvalue;
+                lambda = std::max(lambda/10, 1e-12);
+            }else{
+                lambda *= 10;
+                converged = lambda > 1e12;
+            }
+        }
+        ok &= converged;
+    }
+
+    // undamped, at the minimum: the covariance
+    ok = ok && Step(pool, grad, hess, 0, trial);
+
+    std::size_t ndata = 0;
+    for(const Chi2Function &c: chi2) ndata += c.NData();
+    fChi2 = total;
+    fNdf = int(ndata) - fNShared - int(n)*fNLocal;
+    _valid = ok;
+
+    return _valid;
+}
+
+double BodeGlobalFit::GetPar(std::size_t board, int par) const {
+    if(!_valid || board >= fSweeps.size() || par < 0 || par >= NPar(fFilter)) return -1111;
+    return fPar[board*M + par];
+}
+
+double BodeGlobalFit::GetErr(std::size_t board, int par) const {
+    if(GetPar(board, par) == -1111) return -1111;
+    return std::sqrt(std::max(GetCovariance(board, par, board, par), 0.));
+}
+
+double BodeGlobalFit::GetCovariance(std::size_t board1, int par1, std::size_t board2, int par2) const {
+
+    if(GetPar(board1, par1) == -1111 || GetPar(board2, par2) == -1111) return 0;
+    if(fRole[par1] == kFixed || fRole[par2] == kFixed) return 0;
+
+    const int ns = fNShared, nl = fNLocal;
+    // local-shared order only
+    if(fRole[par1] == kShared && fRole[par2] == kLocal) return GetCovariance(board2, par2, board1, par1);
+
+    int a = Slot(par1), b = Slot(par2);
+    if(fRole[par1] == kShared) return fCovShared[a*ns + b];
+
+    // cov(l_j, s) = -C_j^-1 B_j^T S^-1
+    const double *cb1 = &fCB[board1*nl*ns];
+    if(fRole[par2] == kShared){
+        double c = 0;
+        for(int s = 0; s < ns; s++) c -= cb1[a*ns + s]*fCovShared[s*ns + b];
+        return c;
+    }
+
+    // cov(l_j, l_k) = delta_jk C_j^-1 + C_j^-1 B_j^T S^-1 B_k C_k^-1
+    const double *cb2 = &fCB[board2*nl*ns];
+    double c = (board1 == board2)? fCInv[board1*nl*nl + a*nl + b] : 0;
+    for(int s = 0; s < ns; s++){
+        for(int t = 0; t < ns; t++) c += cb1[a*ns + s]*fCovShared[s*ns + t]*cb2[b*ns + t];
+    }
+
+    return c;
+}
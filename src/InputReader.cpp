@@ -0,0 +1,224 @@
+/**
+ * @file InputReader.cpp
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include<cmath>
+#include<cstdint>
+#include<cstring>
+#include<fstream>
+#include<locale>
+#include<sstream>
+#if __has_include(<charconv>)
+#include<charconv>
+#endif
+
+#include<fcntl.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<unistd.h>
+
+#include"Bode/InputReader.h"
+
+namespace {
+
+    // powers of ten exactly representable as double
+    const double kExactPow10[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    inline bool is_digit(char c){ return c >= '0' && c <= '9'; }
+    inline bool is_blank(char c){ return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f'; }
+
+    // correctly rounded conversion for the (rare) tokens the fast path can't handle
+    bool slow_parse(const char *begin, const char *end, double &value){
+#if defined(__cpp_lib_to_chars)
+        const char *first = (*begin == '+')? begin + 1 : begin;
+        std::from_chars_result res = std::from_chars(first, end, value);
+        return res.ec == std::errc() && res.ptr == end;
+#else
+        std::istringstream in(std::string(begin, end));
+        in.imbue(std::locale::classic());
+        return static_cast<bool>(in >> value);
+#endif
+    }
+
+}
+
+bool ParseDouble(const char *&cur, const char *end, double &value){
+
+    const char *p = cur;
+    bool negative = false;
+
+    if(p < end && (*p == '+' || *p == '-')){
+        negative = (*p == '-');
+        p++;
+    }
+
+    std::uint64_t mantissa = 0;
+    int ndigits = 0;        // significant digits stored in mantissa
+    int exp10 = 0;
+    bool seendigit = false;
+    bool truncated = false; // more than 19 significant digits
+
+    for(; p < end && is_digit(*p); p++){
+        seendigit = true;
+        if(mantissa == 0 && *p == '0') continue;
+        if(ndigits < 19){
+            mantissa = mantissa * 10 + (*p - '0');
+            ndigits++;
+        }else{
+            exp10++;
+            truncated |= (*p != '0');
+        }
+    }
+    if(p < end && *p == '.'){
+        p++;
+        for(; p < end && is_digit(*p); p++){
+            seendigit = true;
+            if(mantissa == 0 && *p == '0'){ exp10--; continue; }
+            if(ndigits < 19){
+                mantissa = mantissa * 10 + (*p - '0');
+                ndigits++;
+                exp10--;
+            }else{
+                truncated |= (*p != '0');
+            }
+        }
+    }
+    if(!seendigit) return false;
+
+    if(p < end && (*p == 'e' || *p == 'E')){
+        const char *q = p + 1;
+        bool expneg = false;
+        if(q < end && (*q == '+' || *q == '-')){
+            expneg = (*q == '-');
+            q++;
+        }
+        if(q == end || !is_digit(*q)) return false;
+        int e = 0;
+        for(; q < end && is_digit(*q); q++){
+            if(e < 100000) e = e * 10 + (*q - '0');
+        }
+        exp10 += expneg? -e : e;
+        p = q;
+    }
+
+    if(mantissa == 0){
+        value = negative? -0.0 : 0.0;
+    }else if(!truncated && mantissa <= (std::uint64_t(1) << 53) && exp10 >= -22 && exp10 <= 22){
+        // Clinger fast path: both operands exact, so a single rounding
+        double m = static_cast<double>(mantissa);
+        value = (exp10 < 0)? m / kExactPow10[-exp10] : m * kExactPow10[exp10];
+        if(negative) value = -value;
+    }else{
+        if(!slow_parse(cur, p, value)) return false;
+    }
+
+    cur = p;
+    return true;
+}
+
+InputReader::InputReader(const char *filename){
+
+    int fd = open(filename, O_RDONLY);
+    if(fd < 0) return;
+
+    struct stat st;
+    if(fstat(fd, &st) != 0){
+        close(fd);
+        return;
+    }
+
+    fMapSize = static_cast<std::size_t>(st.st_size);
+    if(fMapSize > 0){
+        void *map = mmap(0, fMapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(map != MAP_FAILED){
+            madvise(map, fMapSize, MADV_SEQUENTIAL);
+            fMap = map;
+            fBegin = static_cast<const char *>(map);
+        }
+    }
+    close(fd);
+
+    if(fMapSize > 0 && !fMap){
+        // not mappable (pipe, special fs...): read it in one go
+        std::ifstream in(filename, std::ios::binary);
+        fBuffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        fBegin = fBuffer.data();
+        fMapSize = fBuffer.size();
+    }
+
+    fEnd = fBegin + fMapSize;
+    fCursor = fBegin;
+    _isopen = true;
+}
+
+InputReader::~InputReader(){
+    if(fMap) munmap(fMap, fMapSize);
+}
+
+std::size_t InputReader::CountRows() const {
+
+    std::size_t nlines = 0;
+    for(const char *p = fBegin; p < fEnd; ){
+        const void *nl = memchr(p, '\n', fEnd - p);
+        if(!nl) break;
+        p = static_cast<const char *>(nl) + 1;
+        nlines++;
+    }
+    if(fEnd > fBegin && fEnd[-1] != '\n') nlines++;
+
+    return nlines;
+}
+
+bool InputReader::NextRow(double *row, int ncols){
+
+    while(fCursor < fEnd){
+        const char *eol = static_cast<const char *>(memchr(fCursor, '\n', fEnd - fCursor));
+        if(!eol) eol = fEnd;
+
+        const char *p = fCursor;
+        fCursor = (eol < fEnd)? eol + 1 : fEnd;
+        fLine++;
+
+        while(p < eol && is_blank(*p)) p++;
+        if(p == eol || *p == '#') continue;     // blank or comment line
+
+        std::string reason;
+        for(int k = 0; k < ncols; k++){
+            while(p < eol && is_blank(*p)) p++;
+            if(p == eol){
+                reason = "expected " + std::to_string(ncols) + " columns, found " + std::to_string(k);
+                break;
+            }
+            if(!ParseDouble(p, eol, row[k]) || (p < eol && !is_blank(*p))){
+                reason = "column " + std::to_string(k + 1) + " is not a number";
+                break;
+            }
+        }
+        if(reason.empty()){
+            while(p < eol && is_blank(*p)) p++;
+            if(p != eol) reason = "more than " + std::to_string(ncols) + " columns";
+        }
+
+        if(!reason.empty()){
+            fMalformed.push_back({fLine, reason});
+            continue;
+        }
+        return true;
+    }
+
+    return false;
+}
+
+void InputReader::Reject(const char *reason){
+    fMalformed.push_back({fLine, reason});
+}
@@ -0,0 +1,141 @@
+/**
+ * @file Live.cpp
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include<chrono>
+#include<cstdio>
+
+#include<TROOT.h>
+
+#include"Bode/Analysis.h"
+#include"Bode/ErrorModel.h"
+#include"Bode/Live.h"
+#include"Logger.h"
+
+BodeLive::BodeLive(Bode &bode, std::size_t capacity) : fBode(bode), fCapacity(capacity) {}
+
+BodeLive::~BodeLive(){
+    Finish();
+}
+
+BodeLive::Queue_t *BodeLive::AddProducer(){
+
+    std::lock_guard<std::mutex> lock(fAddMutex);
+    int n = fNQueues.load(std::memory_order_relaxed);
+    if(n >= kMaxProducers){
+        fprintf(stderr, "%s\n", Logger::warning(Form("BodeLive: at most %d producers", int(kMaxProducers))));
+        return 0;
+    }
+    // the queue is complete before the analysis thread can see it
+    fQueues[n].reset(new Queue_t(fCapacity));
+    fNQueues.store(n + 1, std::memory_order_release);
+
+    return fQueues[n].get();
+}
+
+LivePoint_t BodeLive::FromReading(const Double_t *row){
+    LivePoint_t p;
+    // same rule as ReadInput
+    if(row[0] == 0 || row[4] <= 0) return p;
+    Double_t out[6];
+    PropagateRow(row, out);
+    if(!Sweep::IsValid(out[0], out[1], out[2], out[3], out[4], out[5])) return p;
+    p.freq = out[0];  p.efreq = out[1];
+    p.gain = out[2];  p.egain = out[3];
+    p.phase = out[4]; p.ephase = out[5];
+    return p;
+}
+
+void BodeLive::Start(){
+    if(fThread.joinable()) return;
+    ROOT::EnableThreadSafety();
+    _closed = false;
+    fThread = std::thread(&BodeLive::Loop, this);
+}
+
+void BodeLive::Finish(){
+    if(!fThread.joinable()) return;
+    _closed.store(true, std::memory_order_release);
+    fThread.join();
+}
+
+LiveState_t BodeLive::GetState() const {
+    std::lock_guard<std::mutex> lock(fStateMutex);
+    return fState;
+}
+
+std::size_t BodeLive::Drain(){
+
+    std::size_t n = 0, rejected = 0;
+    int nqueues = fNQueues.load(std::memory_order_acquire);
+    LivePoint_t p;
+    for(int q = 0; q < nqueues; q++){
+        while(fQueues[q]->TryPop(p)){
+            if(fBode.AppendPoint(p.freq, p.efreq, p.gain, p.egain, p.phase, p.ephase)) n++;
+            else rejected++;
+        }
+    }
+    if(rejected > 0){
+        std::lock_guard<std::mutex> lock(fStateMutex);
+        fState.nrejected += rejected;
+    }
+
+    return n;
+}
+
+void BodeLive::Loop(){
+
+    std::size_t pending = 0;
+    for(;;){
+        // read before draining: whatever was pushed before Finish() is drained below
+        bool closed = _closed.load(std::memory_order_acquire);
+        std::size_t got = Drain();
+        pending += got;
+
+        if(pending >= std::size_t(fRefitEvery) || (closed && pending > 0)){
+            Refit();
+            pending = 0;
+        }
+        if(closed) break;
+        if(got == 0) std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+void BodeLive::Refit(){
+
+    LiveState_t state = GetState();
+    state.npoints = fBode.GetNpoints();
+
+    if(Int_t(state.npoints) >= BodeModel::NPar(fBode.GetFilter()) + 2){
+        // warm start from the previous result; estimated again until a fit converges
+        if(state.valid){
+            fBode.SetParGain(state.par[0], state.par[1], state.par[2]);
+            fBode.SetParPhase(state.par[0], state.par[1], state.par[2]);
+        }else{
+            fBode.EstimatePar();
+        }
+        bool ok = fBode.FitGain("Q");
+        if(_fitphase) ok &= fBode.FitPhase("Q");
+
+        state.nfits++;
+        state.valid = ok;
+        state.par[0] = fBode.GetGain();     state.err[0] = fBode.GetErrGain();
+        state.par[1] = fBode.GetCutoff();   state.err[1] = fBode.GetErrCutoff();
+        state.par[2] = fBode.GetQ();        state.err[2] = fBode.GetErrQ();
+        state.chi2 = fBode.GetGainResult().Chi2();
+        state.ndf = fBode.GetGainResult().Ndf();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(fStateMutex);
+        fState = state;
+    }
+    if(fCallback) fCallback(state);
+}
@@ -0,0 +1,145 @@
+/**
+ * @file Minimize.cpp
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include<algorithm>
+#include<cmath>
+
+#include"Bode/Minimize.h"
+
+using namespace BodeModel;
+
+bool InvertMatrix(double a[][kMaxPar], int n){
+
+    double inv[kMaxPar][kMaxPar] = {};
+    for(int i = 0; i < n; i++) inv[i][i] = 1;
+
+    for(int c = 0; c < n; c++){
+        int p = c;
+        for(int r = c + 1; r < n; r++) if(std::fabs(a[r][c]) > std::fabs(a[p][c])) p = r;
+        if(a[p][c] == 0 || !std::isfinite(a[p][c])) return false;
+        std::swap(a[p], a[c]);
+        std::swap(inv[p], inv[c]);
+        double d = a[c][c];
+        for(int k = 0; k < n; k++){ a[c][k] /= d; inv[c][k] /= d; }
+        for(int r = 0; r < n; r++){
+            if(r == c) continue;
+            double m = a[r][c];
+            for(int k = 0; k < n; k++){ a[r][k] -= m*a[c][k]; inv[r][k] -= m*inv[c][k]; }
+        }
+    }
+    for(int i = 0; i < n; i++) for(int j = 0; j < n; j++) a[i][j] = inv[i][j];
+
+    return true;
+}
+
+namespace {
+
+    /// one pass at fixed weights; false if it did not converge
+    bool Descend(const Chi2Function &chi2, double *par, const bool *isfree, int cutoffpar,
+            const MinimizeOptions_t &options, int &niter, FitCounters_t *counters){
+
+        const int npar = chi2.NPar();
+        double grad[kMaxPar], hess[kMaxPar*kMaxPar];
+        double a[kMaxPar][kMaxPar], trial[kMaxPar];
+        double lambda = options.lambda;
+
+        double value = chi2.EvalNormal(par, grad, hess);
+        if(counters){ counters->nfcn++; counters->ngrad++; }
+        if(!std::isfinite(value)) return false;
+
+        for(int it = 0; it < options.maxiter; it++){
+            niter++;
+            if(counters) counters->niter++;
+
+            // damped normal equations, fixed parameters kept out by an identity row
+            for(int i = 0; i < npar; i++){
+                for(int j = 0; j < npar; j++) a[i][j] = (isfree[i] && isfree[j])? 0.5*hess[i*npar + j] : 0;
+                a[i][i] = isfree[i]? a[i][i]*(1 + lambda) : 1;
+                if(isfree[i] && a[i][i] == 0) a[i][i] = lambda;
+            }
+            if(!InvertMatrix(a, npar)) return false;
+
+            for(int i = 0; i < npar; i++){
+                double step = 0;
+                for(int j = 0; j < npar; j++) if(isfree[j]) step -= 0.5*a[i][j]*grad[j];
+                trial[i] = par[i] + (isfree[i]? step : 0);
+            }
+
+            double tgrad[kMaxPar], thess[kMaxPar*kMaxPar];
+            double tvalue = trial[cutoffpar] > 0? chi2.EvalNormal(trial, tgrad, thess) : HUGE_VAL;
+            if(counters){ counters->nfcn++; counters->ngrad++; }
+
+            if(std::isfinite(tvalue) && tvalue <= value){
+                bool small = (value - tvalue) <= options.tolerance*(1 + value);
+                std::copy(trial, trial + npar, par);
+                std::copy(tgrad, tgrad + npar, grad);
+                std::copy(thess, thess + npar*npar, hess);
+                value = tvalue;
+                lambda = std::max(lambda/10, 1e-12);
+                if(small) return true;
+            }else{
+                lambda *= 10;
+                // no step lowers chi2 any more: at the minimum up to rounding
+                if(lambda > 1e12) return true;
+            }
+        }
+
+        return false;
+    }
+
+}
+
+bool NativeMinimize(Chi2Function &chi2, double *par, bool fixgain, MinimizeResult_t &result,
+        int gainpar, int cutoffpar, FitCounters_t *counters, const MinimizeOptions_t &options){
+
+    bool isfree[kMaxPar] = {true, true, true};
+    if(fixgain) isfree[gainpar] = false;
+
+    return NativeMinimize(chi2, par, isfree, result, cutoffpar, counters, options);
+}
+
+bool NativeMinimize(Chi2Function &chi2, double *par, const bool *isfree, MinimizeResult_t &result,
+        int cutoffpar, FitCounters_t *counters, const MinimizeOptions_t &options){
+
+    const int npar = chi2.NPar();
+
+    result = MinimizeResult_t();
+    result.npar = npar;
+
+    bool ok = true;
+    int npass = chi2.HasXErrors()? 2 : 1;
+    for(int pass = 0; pass < npass && ok; pass++){
+        chi2.UpdateWeights(par);
+        ok = Descend(chi2, par, isfree, cutoffpar, options, result.niter, counters);
+        if(counters) counters->npass++;
+    }
+
+    double grad[kMaxPar], hess[kMaxPar*kMaxPar];
+    double cov[kMaxPar][kMaxPar];
+    result.chi2 = chi2.EvalNormal(par, grad, hess);
+    for(int i = 0; i < npar; i++){
+        for(int j = 0; j < npar; j++) cov[i][j] = (isfree[i] && isfree[j])? 0.5*hess[i*npar + j] : 0;
+        if(!isfree[i]) cov[i][i] = 1;
+    }
+    ok &= InvertMatrix(cov, npar);
+
+    int nfree = 0;
+    for(int i = 0; i < npar; i++){
+        nfree += isfree[i];
+        result.par[i] = par[i];
+        for(int j = 0; j < npar; j++) result.cov[i][j] = (isfree[i] && isfree[j])? cov[i][j] : 0;
+        result.err[i] = std::sqrt(std::max(result.cov[i][i], 0.));
+    }
+    result.ndf = int(chi2.NData()) - nfree;
+    result.valid = ok && std::isfinite(result.chi2);
+
+    return result.valid;
+}
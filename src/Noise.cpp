@@ -0,0 +1,83 @@
+/**
+ * @file Noise.cpp
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include<algorithm>
+#include<cmath>
+#include<vector>
+
+#include"Bode/Noise.h"
+#include"Bode/Philox.h"
+
+void FFT(std::complex<double> *data, std::size_t n, bool inverse){
+
+    // bit reversal
+    for(std::size_t i = 1, j = 0; i < n; i++){
+        std::size_t bit = n >> 1;
+        for(; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if(i < j) std::swap(data[i], data[j]);
+    }
+
+    const double sign = inverse? 1 : -1;
+    for(std::size_t len = 2; len <= n; len <<= 1){
+        double angle = sign*2*M_PI/len;
+        std::complex<double> step(std::cos(angle), std::sin(angle));
+        for(std::size_t i = 0; i < n; i += len){
+            std::complex<double> w(1, 0);
+            for(std::size_t k = 0; k < len/2; k++){
+                std::complex<double> a = data[i + k];
+                std::complex<double> b = data[i + k + len/2]*w;
+                data[i + k] = a + b;
+                data[i + k + len/2] = a - b;
+                // exact twiddles now and then, the recurrence drifts on long transforms
+                w = ((k + 1) % 64 == 0)? std::polar(1.0, angle*(k + 1)) : w*step;
+            }
+        }
+    }
+}
+
+void ColoredNoise(std::size_t n, double alpha, std::uint64_t seed, std::uint64_t counter, std::uint32_t stream,
+                  double *x, double *y){
+
+    if(n == 0) return;
+
+    std::size_t size = 2;
+    while(size < 2*n) size <<= 1;
+
+    // per thread, reused: sweeps of one length allocate once
+    thread_local std::vector<std::complex<double>> spectrum;
+    spectrum.assign(size, std::complex<double>(0, 0));
+
+    const std::uint32_t clo = static_cast<std::uint32_t>(counter);
+    const std::uint32_t chi = static_cast<std::uint32_t>(counter >> 32);
+
+    // bin k is frequency min(k, size - k); no DC, so no offset. Real and imaginary
+    // parts are the two Box-Muller normals of one pair of uniforms
+    double power = 0;
+    for(std::size_t k = 1; k < size; k++){
+        double f = double(std::min(k, size - k));
+        double amp = (alpha == 0)? 1 : (alpha == 1)? 1/std::sqrt(f) : (alpha == 2)? 1/f : std::pow(f, -0.5*alpha);
+        Philox::Block_t u = Philox::Generate(static_cast<std::uint32_t>(k), clo, chi, stream, seed);
+        double r = amp*std::sqrt(-2*std::log(Philox::ToUniform(u.v[0])));
+        double phi = 2*M_PI*Philox::ToUniform(u.v[1]);
+        spectrum[k] = std::complex<double>(r*std::cos(phi), r*std::sin(phi));
+        power += amp*amp;
+    }
+
+    FFT(spectrum.data(), size, true);
+
+    // each part has variance sum S_k, scaled to 1
+    double norm = 1/std::sqrt(power);
+    for(std::size_t i = 0; i < n; i++){
+        if(x) x[i] = norm*spectrum[i].real();
+        if(y) y[i] = norm*spectrum[i].imag();
+    }
+}
@@ -0,0 +1,262 @@
+/**
+ * @file Planner.cpp
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include<algorithm>
+#include<cmath>
+#include<numeric>
+
+#include"Bode/Analysis.h"
+#include"Bode/Planner.h"
+
+namespace {
+
+    const int kMax = BodeModel::kMaxPar;
+
+    // in place, n <= kMax, partial pivoting; false if singular
+    bool invert(Double_t a[][kMax], int n){
+        Double_t inv[kMax][kMax] = {};
+        for(int i = 0; i < n; i++) inv[i][i] = 1;
+        for(int c = 0; c < n; c++){
+            int p = c;
+            for(int r = c + 1; r < n; r++) if(std::fabs(a[r][c]) > std::fabs(a[p][c])) p = r;
+            if(a[p][c] == 0) return false;
+            std::swap(a[p], a[c]);
+            std::swap(inv[p], inv[c]);
+            Double_t d = a[c][c];
+            for(int k = 0; k < n; k++){ a[c][k] /= d; inv[c][k] /= d; }
+            for(int r = 0; r < n; r++){
+                if(r == c) continue;
+                Double_t m = a[r][c];
+                for(int k = 0; k < n; k++){ a[r][k] -= m*a[c][k]; inv[r][k] -= m*inv[c][k]; }
+            }
+        }
+        for(int i = 0; i < n; i++) for(int j = 0; j < n; j++) a[i][j] = inv[i][j];
+        return true;
+    }
+
+}
+
+BodePlanner::BodePlanner(const Bode &bode) : fSweep(bode.GetSweep()) {
+    fFilter = bode.GetFilter();
+    fPar[0] = bode.GetGain();
+    fPar[1] = bode.GetCutoff();
+    fPar[2] = bode.GetQ();
+    Init();
+}
+
+BodePlanner::BodePlanner(const Sweep &sweep, BodeModel::Filter_t filter, const Double_t *par) : fSweep(sweep) {
+    fFilter = filter;
+    std::copy(par, par + BodeModel::NPar(filter), fPar);
+    Init();
+}
+
+void BodePlanner::Update(const Bode &bode){
+    fSweep = bode.GetSweep();
+    fFilter = bode.GetFilter();
+    fPar[0] = bode.GetGain();
+    fPar[1] = bode.GetCutoff();
+    fPar[2] = bode.GetQ();
+    Init();
+}
+
+void BodePlanner::Init(){
+
+    int npar = BodeModel::NPar(fFilter);
+    std::size_t n = fSweep.Size();
+    const Double_t *f = fSweep.Freq();
+
+    // measured relative errors, ordered by frequency
+    std::vector<std::size_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [f](std::size_t a, std::size_t b){ return f[a] < f[b]; });
+    fLogF.clear();
+    for(int k = 0; k < 3; k++) fRelErr[k].clear();
+    for(std::size_t i: order){
+        if(f[i] <= 0 || fSweep.Gain()[i] == 0) continue;
+        fLogF.push_back(std::log(f[i]));
+        fRelErr[0].push_back(fSweep.ErrFreq()[i]/f[i]);
+        fRelErr[1].push_back(fSweep.ErrGain()[i]/std::fabs(fSweep.Gain()[i]));
+        fRelErr[2].push_back(fSweep.ErrPhase()[i]);
+    }
+
+    // Fisher information of the points so far, plus a weak prior (1000 times the
+    // value) so that a short sweep still gives a finite covariance
+    Double_t info[kMax][kMax] = {};
+    for(std::size_t i = 0; i < n; i++){
+        Double_t err[3] = {fSweep.ErrFreq()[i], fSweep.ErrGain()[i], fSweep.ErrPhase()[i]};
+        for(int comp = 0; comp < 2; comp++){
+            if((comp == 0 && !_fitgain) || (comp == 1 && !_fitphase)) continue;
+            BodeModel::Component_t c = comp == 0? BodeModel::kGain : BodeModel::kPhase;
+            Double_t grad[kMax] = {};
+            BodeModel::EvalGrad(fFilter, c, f[i], fPar, grad);
+            Double_t sx = BodeModel::Slope(fFilter, c, f[i], fPar)*err[0];
+            Double_t s2 = err[1 + comp]*err[1 + comp] + sx*sx;
+            if(!(s2 > 0)) continue;
+            for(int a = 0; a < npar; a++) for(int b = 0; b < npar; b++) info[a][b] += grad[a]*grad[b]/s2;
+        }
+    }
+    for(int k = 0; k < npar; k++){
+        Double_t scale = 1e3*(fPar[k] != 0? std::fabs(fPar[k]) : 1);
+        info[k][k] += 1/(scale*scale);
+    }
+    // phase alone says nothing about the gain: it stays where it is
+    if(!_fitgain){
+        for(int k = 0; k < npar; k++) info[0][k] = info[k][0] = 0;
+        info[0][0] = 1;
+    }
+
+    for(int a = 0; a < kMax; a++) for(int b = 0; b < kMax; b++) fCov[a][b] = 0;
+    if(invert(info, npar)){
+        for(int a = 0; a < npar; a++) for(int b = 0; b < npar; b++) fCov[a][b] = info[a][b];
+    }
+    if(!_fitgain) for(int k = 0; k < npar; k++) fCov[0][k] = fCov[k][0] = 0;
+}
+
+void BodePlanner::Errors(Double_t f, Double_t *err) const {
+
+    if(fErrors){
+        fErrors(f, err);
+        return;
+    }
+
+    // linear in log f between measured points, flat beyond them
+    Double_t rel[3] = {0, 0, 0};
+    if(!fLogF.empty()){
+        Double_t lf = std::log(f);
+        std::size_t hi = std::lower_bound(fLogF.begin(), fLogF.end(), lf) - fLogF.begin();
+        if(hi == 0 || hi == fLogF.size()){
+            std::size_t i = (hi == 0)? 0 : fLogF.size() - 1;
+            for(int k = 0; k < 3; k++) rel[k] = fRelErr[k][i];
+        }else{
+            Double_t w = (fLogF[hi] > fLogF[hi - 1])? (lf - fLogF[hi - 1])/(fLogF[hi] - fLogF[hi - 1]) : 0;
+            for(int k = 0; k < 3; k++) rel[k] = (1 - w)*fRelErr[k][hi - 1] + w*fRelErr[k][hi];
+        }
+    }
+
+    err[0] = rel[0]*f;
+    err[1] = rel[1]*std::fabs(BodeModel::Eval(fFilter, BodeModel::kGain, f, fPar));
+    err[2] = rel[2];
+}
+
+void BodePlanner::AddPoint(Double_t cov[][kMax], Double_t f, const Double_t *err) const {
+
+    int npar = BodeModel::NPar(fFilter);
+    for(int comp = 0; comp < 2; comp++){
+        if((comp == 0 && !_fitgain) || (comp == 1 && !_fitphase)) continue;
+        BodeModel::Component_t c = comp == 0? BodeModel::kGain : BodeModel::kPhase;
+        Double_t grad[kMax] = {};
+        BodeModel::EvalGrad(fFilter, c, f, fPar, grad);
+        if(!_fitgain) grad[0] = 0;
+        Double_t sx = BodeModel::Slope(fFilter, c, f, fPar)*err[0];
+        Double_t s2 = err[1 + comp]*err[1 + comp] + sx*sx;
+        if(!(s2 > 0)) continue;
+
+        // Sherman-Morrison
+        Double_t u[kMax] = {};
+        Double_t d = s2;
+        for(int a = 0; a < npar; a++){
+            for(int b = 0; b < npar; b++) u[a] += cov[a][b]*grad[b];
+            d += grad[a]*u[a];
+        }
+        for(int a = 0; a < npar; a++) for(int b = 0; b < npar; b++) cov[a][b] -= u[a]*u[b]/d;
+    }
+}
+
+Double_t BodePlanner::Score(const Double_t cov[][kMax]) const {
+
+    // variances relative to their targets, so the goal furthest away counts most
+    Double_t score = 0;
+    for(int k = 0; k < BodeModel::NPar(fFilter); k++){
+        if(fTarget[k] <= 0 || (k == 0 && !_fitgain) || fPar[k] == 0) continue;
+        score += cov[k][k]/(fPar[k]*fPar[k]*fTarget[k]*fTarget[k]);
+    }
+    return score;
+}
+
+Double_t BodePlanner::GetRelError(Int_t par) const {
+    if(par < 0 || par >= BodeModel::NPar(fFilter) || fPar[par] == 0) return -1111;
+    if(par == 0 && !_fitgain) return -1111;
+    return std::sqrt(std::max(fCov[par][par], 0.))/std::fabs(fPar[par]);
+}
+
+Bool_t BodePlanner::IsDone() const {
+    for(int k = 0; k < BodeModel::NPar(fFilter); k++){
+        if(fTarget[k] <= 0 || (k == 0 && !_fitgain)) continue;
+        if(GetRelError(k) > fTarget[k]) return false;
+    }
+    return true;
+}
+
+Double_t BodePlanner::Predict(const std::vector<Double_t> &freqs, Int_t par) const {
+
+    if(par < 0 || par >= BodeModel::NPar(fFilter) || fPar[par] == 0) return -1111;
+
+    Double_t cov[kMax][kMax];
+    std::copy(&fCov[0][0], &fCov[0][0] + kMax*kMax, &cov[0][0]);
+    Double_t err[3];
+    for(Double_t f: freqs){
+        Errors(f, err);
+        AddPoint(cov, f, err);
+    }
+
+    return std::sqrt(std::max(cov[par][par], 0.))/std::fabs(fPar[par]);
+}
+
+std::vector<Double_t> BodePlanner::Next(Int_t n) const {
+
+    std::vector<Double_t> next;
+    if(IsDone() || fSweep.Empty() || fPar[1] <= 0) return next;
+
+    Double_t fmin = fFmin, fmax = fFmax;
+    if(fmin <= 0) fmin = 0.5*(*std::min_element(fSweep.Freq(), fSweep.Freq() + fSweep.Size()));
+    if(fmax <= 0) fmax = 2*(*std::max_element(fSweep.Freq(), fSweep.Freq() + fSweep.Size()));
+    if(!(fmin > 0) || fmax <= fmin) return next;
+
+    // candidate grid and the errors expected there, once
+    std::vector<Double_t> cand(fNCandidates), err(3*fNCandidates);
+    Double_t lmin = std::log(fmin), step = (std::log(fmax) - lmin)/(fNCandidates - 1);
+    for(Int_t j = 0; j < fNCandidates; j++){
+        cand[j] = std::exp(lmin + j*step);
+        Errors(cand[j], &err[3*j]);
+    }
+
+    Double_t cov[kMax][kMax], trial[kMax][kMax];
+    std::copy(&fCov[0][0], &fCov[0][0] + kMax*kMax, &cov[0][0]);
+
+    // greedy: each pick assumes the previous ones are measured; stop early once
+    // the targets are expected to be met
+    for(Int_t i = 0; i < n; i++){
+        Int_t best = -1;
+        Double_t bestscore = Score(cov);
+        for(Int_t j = 0; j < fNCandidates; j++){
+            std::copy(&cov[0][0], &cov[0][0] + kMax*kMax, &trial[0][0]);
+            AddPoint(trial, cand[j], &err[3*j]);
+            Double_t s = Score(trial);
+            if(s < bestscore){
+                bestscore = s;
+                best = j;
+            }
+        }
+        if(best < 0) break;
+
+        AddPoint(cov, cand[best], &err[3*best]);
+        next.push_back(cand[best]);
+
+        bool done = true;
+        for(int k = 0; k < BodeModel::NPar(fFilter); k++){
+            if(fTarget[k] <= 0 || (k == 0 && !_fitgain) || fPar[k] == 0) continue;
+            if(std::sqrt(std::max(cov[k][k], 0.))/std::fabs(fPar[k]) > fTarget[k]) done = false;
+        }
+        if(done) break;
+    }
+
+    return next;
+}
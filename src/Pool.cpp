@@ -0,0 +1,66 @@
+/**
+ * @file Pool.cpp
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include"Bode/Pool.h"
+
+void BodePool::Releaser_t::operator()(Bode *bode) const {
+    if(fPool) fPool->Release(fKey, bode);
+    else delete bode;
+}
+
+BodePool::Handle_t BodePool::Acquire(System_t sys){
+
+    std::string key(sys.Data());
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        std::vector<std::unique_ptr<Bode>> &idle = fIdle[key];
+        if(!idle.empty()){
+            Bode *bode = idle.back().release();
+            idle.pop_back();
+            return Handle_t(bode, Releaser_t(this, key));
+        }
+        fNCreated++;
+    }
+
+    // constructed outside the lock, it is the slow path
+    return Handle_t(new Bode(sys), Releaser_t(this, key));
+}
+
+void BodePool::Release(const std::string &key, Bode *bode){
+
+    // emptied by the thread giving it back, not by the next one taking it
+    std::unique_ptr<Bode> owned(bode);
+    owned->Reset();
+
+    std::lock_guard<std::mutex> lock(fMutex);
+    std::vector<std::unique_ptr<Bode>> &idle = fIdle[key];
+    if(idle.size() < fMaxIdle) idle.push_back(std::move(owned));
+}
+
+std::size_t BodePool::GetNCreated(){
+    std::lock_guard<std::mutex> lock(fMutex);
+    return fNCreated;
+}
+
+std::size_t BodePool::GetNIdle(){
+    std::lock_guard<std::mutex> lock(fMutex);
+    std::size_t n = 0;
+    for(const auto &idle: fIdle) n += idle.second.size();
+    return n;
+}
+
+void BodePool::SetMaxIdle(std::size_t n){
+    std::lock_guard<std::mutex> lock(fMutex);
+    fMaxIdle = n;
+    for(auto &idle: fIdle){
+        if(idle.second.size() > n) idle.second.resize(n);
+    }
+}
@@ -0,0 +1,247 @@
+/**
+ * @file Profile.cpp
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include<algorithm>
+#include<cmath>
+#include<cstdio>
+
+#include"Bode/Chi2.h"
+#include"Bode/Profile.h"
+#include"Bode/ThreadPool.h"
+
+using namespace BodeModel;
+
+void ComputePulls(Filter_t filter, Component_t comp, const Sweep &sweep, const double *par, double *residual, double *pull){
+
+    const double *f = sweep.Freq(), *ef = sweep.ErrFreq();
+    const double *y = (comp == kGain)? sweep.Gain() : sweep.Phase();
+    const double *ey = (comp == kGain)? sweep.ErrGain() : sweep.ErrPhase();
+
+    for(std::size_t i = 0; i < sweep.Size(); i++){
+        double r = y[i] - Eval(filter, comp, f[i], par);
+        double sx = Slope(filter, comp, f[i], par)*ef[i];
+        double s = std::sqrt(ey[i]*ey[i] + sx*sx);
+        if(residual) residual[i] = r;
+        if(pull) pull[i] = s > 0? r/s : 0;
+    }
+}
+
+BodeProfile::BodeProfile(const Sweep &sweep, Filter_t filter, const double *par) : fSweep(sweep) {
+    fFilter = filter;
+    std::copy(par, par + NPar(filter), fStart);
+}
+
+void BodeProfile::AddTerms(Chi2Function &chi2) const {
+    if(_fitgain) chi2.AddTerm(kGain, fSweep.Gain(), fSweep.ErrGain());
+    if(_fitphase) chi2.AddTerm(kPhase, fSweep.Phase(), fSweep.ErrPhase());
+    chi2.SetRange(fXmin, fXmax);
+}
+
+bool BodeProfile::DoPoint(ProfilePoint_t &point, const double *start) const {
+
+    Chi2Function chi2(fFilter, fSweep.Size(), fSweep.Freq(), fSweep.ErrFreq());
+    AddTerms(chi2);
+
+    // phase alone says nothing about the gain, it stays where it starts
+    bool isfree[kMaxPar] = {_fitgain && !fFixed[0], !fFixed[1], !fFixed[2]};
+    double par[kMaxPar];
+    std::copy(start, start + kMaxPar, par);
+    for(int a = 0; a < 2; a++){
+        if(fScanPar[a] < 0) continue;
+        isfree[fScanPar[a]] = false;
+        par[fScanPar[a]] = point.value[a];
+    }
+
+    MinimizeResult_t result;
+    point.status = NativeMinimize(chi2, par, isfree, result, 1, 0, fOptions);
+    std::copy(par, par + kMaxPar, point.par);
+    point.chi2 = result.chi2;
+
+    return point.status;
+}
+
+bool BodeProfile::FitBest(){
+
+    if(_hasbest) return fBest.valid;
+
+    Chi2Function chi2(fFilter, fSweep.Size(), fSweep.Freq(), fSweep.ErrFreq());
+    AddTerms(chi2);
+
+    bool isfree[kMaxPar] = {_fitgain && !fFixed[0], !fFixed[1], !fFixed[2]};
+    double par[kMaxPar];
+    std::copy(fStart, fStart + kMaxPar, par);
+    NativeMinimize(chi2, par, isfree, fBest, 1, 0, fOptions);
+    _hasbest = true;
+
+    for(int c = 0; c < 2; c++){
+        fResidual[c].resize(fSweep.Size());
+        fPull[c].resize(fSweep.Size());
+        ComputePulls(fFilter, c == 0? kGain : kPhase, fSweep, fBest.par, fResidual[c].data(), fPull[c].data());
+    }
+
+    return fBest.valid;
+}
+
+std::vector<double> BodeProfile::MakeGrid(int par, int n, double nsigma) const {
+
+    double best = fBest.par[par];
+    double err = fBest.err[par];
+    if(!(err > 0) || !std::isfinite(err)) err = 0.1*std::fabs(best);
+
+    // every parameter of the models is positive: the grid stops at 1% of the best value
+    double lo = std::max(best - nsigma*err, 0.01*best);
+    double hi = best + nsigma*err;
+
+    n = std::max(n, 3);
+    std::vector<double> grid(n);
+    for(int i = 0; i < n; i++) grid[i] = lo + (hi - lo)*i/(n - 1);
+
+    // the best fit itself is a node, so the curve has its minimum exactly
+    std::size_t near = std::min_element(grid.begin(), grid.end(),
+        [best](double a, double b){ return std::fabs(a - best) < std::fabs(b - best); }) - grid.begin();
+    grid[near] = best;
+
+    return grid;
+}
+
+void BodeProfile::RunChain(std::size_t first, std::size_t n, std::ptrdiff_t stride){
+
+    const double *start = fBest.par;
+    for(std::size_t k = 0; k < n; k++){
+        ProfilePoint_t &point = fPoints[first + k*stride];
+        // a failed node does not spoil the start of the next one
+        if(DoPoint(point, start)) start = point.par;
+    }
+}
+
+bool BodeProfile::Scan(int par, int n, double nsigma){
+    return Scan2D(par, -1, n, 1, nsigma);
+}
+
+bool BodeProfile::Scan2D(int par1, int par2, int n1, int n2, double nsigma){
+
+    int npar = NPar(fFilter);
+    // the gain cannot be scanned when only the phase is fitted
+    if(!_fitgain && !_fitphase) _fitgain = true;
+    if(fSweep.Empty() || fFilter == kUnknown || par1 < 0 || par1 >= npar || par2 >= npar || par1 == par2) return false;
+    if((par1 == 0 || par2 == 0) && !_fitgain) return false;
+    if(fFixed[par1] || (par2 >= 0 && fFixed[par2])) return false;
+    if(!FitBest()) return false;
+
+    fScanPar[0] = par1;
+    fScanPar[1] = par2;
+    fGrid[0] = MakeGrid(par1, n1, nsigma);
+    fGrid[1] = (par2 >= 0)? MakeGrid(par2, n2, nsigma) : std::vector<double>(1, -1111);
+    n1 = fGrid[0].size();
+    n2 = fGrid[1].size();
+
+    fPoints.assign(std::size_t(n1)*n2, ProfilePoint_t());
+    for(int j = 0; j < n2; j++){
+        for(int i = 0; i < n1; i++){
+            fPoints[std::size_t(j)*n1 + i].value[0] = fGrid[0][i];
+            fPoints[std::size_t(j)*n1 + i].value[1] = fGrid[1][j];
+        }
+    }
+
+    // two chains per row, outwards from the best value along par1, so every node
+    // starts from its neighbour; rows are independent and run in parallel
+    int center = std::find(fGrid[0].begin(), fGrid[0].end(), fBest.par[par1]) - fGrid[0].begin();
+
+    typedef struct { std::size_t first, n; std::ptrdiff_t stride; } Chain_t;
+    std::vector<Chain_t> chains;
+    for(int j = 0; j < n2; j++){
+        std::size_t row = std::size_t(j)*n1;
+        if(center < n1) chains.push_back({row + center, std::size_t(n1 - center), 1});
+        if(center > 0) chains.push_back({row + center - 1, std::size_t(center), -1});
+    }
+
+    ThreadPool pool(fNThreads);
+    pool.ParallelFor(chains.size(), [this, &chains](std::size_t c){
+        RunChain(chains[c].first, chains[c].n, chains[c].stride);
+    });
+
+    return GetNFailed() < fPoints.size();
+}
+
+bool BodeProfile::GetInterval(int par, double &lo, double &hi, double up) const {
+
+    lo = hi = -1111;
+    if(par != fScanPar[0] || fScanPar[1] >= 0 || fPoints.empty()) return false;
+
+    // minimum of the curve, the free fit can be a hair above it
+    std::size_t n = fPoints.size(), imin = n;
+    double chi2min = fBest.chi2;
+    for(std::size_t i = 0; i < n; i++){
+        if(!fPoints[i].status) continue;
+        if(imin == n || fPoints[i].chi2 < fPoints[imin].chi2) imin = i;
+    }
+    if(imin == n) return false;
+    chi2min = std::min(chi2min, fPoints[imin].chi2);
+
+    // first crossing of chi2min + up on each side, linear between nodes
+    for(int dir = -1; dir <= 1; dir += 2){
+        std::size_t prev = imin;
+        for(std::ptrdiff_t i = std::ptrdiff_t(imin) + dir; i >= 0 && i < std::ptrdiff_t(n); i += dir){
+            if(!fPoints[i].status) continue;
+            double d0 = fPoints[prev].chi2 - chi2min, d1 = fPoints[i].chi2 - chi2min;
+            if(d1 >= up){
+                double x0 = fPoints[prev].value[0], x1 = fPoints[i].value[0];
+                double x = (d1 > d0)? x0 + (up - d0)/(d1 - d0)*(x1 - x0) : x1;
+                (dir < 0? lo : hi) = x;
+                break;
+            }
+            prev = i;
+        }
+    }
+
+    return lo != -1111 && hi != -1111;
+}
+
+double BodeProfile::GetErrLow(int par, double up) const {
+    double lo, hi;
+    GetInterval(par, lo, hi, up);
+    return lo == -1111? -1111 : fBest.par[par] - lo;
+}
+
+double BodeProfile::GetErrHigh(int par, double up) const {
+    double lo, hi;
+    GetInterval(par, lo, hi, up);
+    return hi == -1111? -1111 : hi - fBest.par[par];
+}
+
+std::size_t BodeProfile::GetNFailed() const {
+    return std::count_if(fPoints.begin(), fPoints.end(), [](const ProfilePoint_t &p){ return !p.status; });
+}
+
+const std::vector<double> &BodeProfile::GetPulls(Component_t comp){
+    FitBest();
+    return fPull[comp == kGain? 0 : 1];
+}
+
+const std::vector<double> &BodeProfile::GetResiduals(Component_t comp){
+    FitBest();
+    return fResidual[comp == kGain? 0 : 1];
+}
+
+bool BodeProfile::WriteResults(const char *filename) const {
+
+    FILE *out = fopen(filename, "w");
+    if(!out) return false;
+
+    fprintf(out, "# value1\tvalue2\tgain\tcutoff\tQ\tchi2\tdelta_chi2\tstatus\n");
+    for(const ProfilePoint_t &p: fPoints){
+        fprintf(out, "%.10g\t%.10g\t%.10g\t%.10g\t%.10g\t%.10g\t%.6g\t%d\n",
+            p.value[0], p.value[1], p.par[0], p.par[1], p.par[2], p.chi2, p.chi2 - fBest.chi2, p.status);
+    }
+    fclose(out);
+
+    return true;
+}
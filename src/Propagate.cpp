@@ -0,0 +1,178 @@
+/**
+ * @file Propagate.cpp
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * Built with -ffp-contract=off (see CMakeLists.txt): a fused a*b+c rounds once
+ * instead of twice and would break the bit-identity with PropagateRow.
+ */
+
+#include<cmath>
+
+#include"Bode/ErrorModel.h"
+#include"Bode/Propagate.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include<immintrin.h>
+#define BODE_PROPAGATE_X86
+#endif
+
+namespace {
+
+    const double kSqrt3 = std::sqrt(3.);
+    const double k2Pi   = 2*M_PI;
+
+    void propagate_scalar(std::size_t begin, std::size_t n, const RawColumns_t &raw,
+                          double *freq, double *efreq, double *gain, double *egain, double *phase, double *ephase){
+        double row[8], out[6];
+        for(std::size_t i = begin; i < n; i++){
+            row[0] = raw.Vin[i];  row[1] = raw.fsVin[i];
+            row[2] = raw.Vout[i]; row[3] = raw.fsVout[i];
+            row[4] = raw.T[i];    row[5] = raw.fsT[i];
+            row[6] = raw.dt[i];   row[7] = raw.fsdt[i];
+            PropagateRow(row, out);
+            freq[i] = out[0];  efreq[i] = out[1];
+            gain[i] = out[2];  egain[i] = out[3];
+            phase[i] = out[4]; ephase[i] = out[5];
+        }
+    }
+
+#ifdef BODE_PROPAGATE_X86
+
+    // each line mirrors the expression it replaces in Bode/ErrorModel.h, same order of operations
+
+    __attribute__((target("avx2")))
+    std::size_t propagate_avx2(std::size_t n, const RawColumns_t &raw,
+                               double *freq, double *efreq, double *gain, double *egain, double *phase, double *ephase){
+
+        const __m256d one = _mm256_set1_pd(1), sqrt3 = _mm256_set1_pd(kSqrt3), twopi = _mm256_set1_pd(k2Pi);
+        const __m256d threshold = _mm256_set1_pd(0.01), plow = _mm256_set1_pd(0.045*8), phigh = _mm256_set1_pd(0.035*8);
+        const __m256d tscale = _mm256_set1_pd(0.0016), tpart = _mm256_set1_pd(10);
+
+        std::size_t i = 0;
+        for(; i + 4 <= n; i += 4){
+            __m256d Vin = _mm256_loadu_pd(raw.Vin + i), fsVin = _mm256_loadu_pd(raw.fsVin + i);
+            __m256d Vout = _mm256_loadu_pd(raw.Vout + i), fsVout = _mm256_loadu_pd(raw.fsVout + i);
+            __m256d T = _mm256_loadu_pd(raw.T + i), fsT = _mm256_loadu_pd(raw.fsT + i);
+            __m256d dt = _mm256_loadu_pd(raw.dt + i), fsdt = _mm256_loadu_pd(raw.fsdt + i);
+
+            // get_VRange: ((fs<=0.01)? 0.045 : 0.035) * 8 * fs, then / sqrt(3)
+            __m256d pin = _mm256_blendv_pd(phigh, plow, _mm256_cmp_pd(fsVin, threshold, _CMP_LE_OQ));
+            __m256d pout = _mm256_blendv_pd(phigh, plow, _mm256_cmp_pd(fsVout, threshold, _CMP_LE_OQ));
+            __m256d eVin = _mm256_div_pd(_mm256_mul_pd(pin, fsVin), sqrt3);
+            __m256d eVout = _mm256_div_pd(_mm256_mul_pd(pout, fsVout), sqrt3);
+            // get_TRangeErr: fs * 0.0016 * 10, then / sqrt(3)
+            __m256d eT = _mm256_div_pd(_mm256_mul_pd(_mm256_mul_pd(fsT, tscale), tpart), sqrt3);
+            __m256d edt = _mm256_div_pd(_mm256_mul_pd(_mm256_mul_pd(fsdt, tscale), tpart), sqrt3);
+
+            __m256d T2 = _mm256_mul_pd(T, T);
+            __m256d Vin2 = _mm256_mul_pd(Vin, Vin);
+
+            // get_HErr: sqrt((eVout/Vin)^2 + (eVin*Vout/Vin^2)^2)
+            __m256d a = _mm256_div_pd(eVout, Vin);
+            __m256d b = _mm256_div_pd(_mm256_mul_pd(eVin, Vout), Vin2);
+            __m256d eH = _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(a, a), _mm256_mul_pd(b, b)));
+
+            // get_phiErr: 2 pi sqrt((edt/T)^2 + (dt*eT/T^2)^2)
+            __m256d c = _mm256_div_pd(edt, T);
+            __m256d d = _mm256_div_pd(_mm256_mul_pd(dt, eT), T2);
+            __m256d ephi = _mm256_mul_pd(twopi, _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(c, c), _mm256_mul_pd(d, d))));
+
+            _mm256_storeu_pd(freq + i, _mm256_div_pd(one, T));
+            _mm256_storeu_pd(efreq + i, _mm256_div_pd(eT, T2));
+            _mm256_storeu_pd(gain + i, _mm256_div_pd(Vout, Vin));
+            _mm256_storeu_pd(egain + i, eH);
+            _mm256_storeu_pd(phase + i, _mm256_div_pd(_mm256_mul_pd(twopi, dt), T));
+            _mm256_storeu_pd(ephase + i, ephi);
+        }
+        return i;
+    }
+
+    __attribute__((target("avx512f")))
+    std::size_t propagate_avx512(std::size_t n, const RawColumns_t &raw,
+                                 double *freq, double *efreq, double *gain, double *egain, double *phase, double *ephase){
+
+        const __m512d one = _mm512_set1_pd(1), sqrt3 = _mm512_set1_pd(kSqrt3), twopi = _mm512_set1_pd(k2Pi);
+        const __m512d threshold = _mm512_set1_pd(0.01), plow = _mm512_set1_pd(0.045*8), phigh = _mm512_set1_pd(0.035*8);
+        const __m512d tscale = _mm512_set1_pd(0.0016), tpart = _mm512_set1_pd(10);
+        // all lanes are written; the masked form only spares the unmasked one's undefined pass-through
+        const __m512d zero = _mm512_setzero_pd();
+        const __mmask8 kAll = 0xFF;
+
+        std::size_t i = 0;
+        for(; i + 8 <= n; i += 8){
+            __m512d Vin = _mm512_loadu_pd(raw.Vin + i), fsVin = _mm512_loadu_pd(raw.fsVin + i);
+            __m512d Vout = _mm512_loadu_pd(raw.Vout + i), fsVout = _mm512_loadu_pd(raw.fsVout + i);
+            __m512d T = _mm512_loadu_pd(raw.T + i), fsT = _mm512_loadu_pd(raw.fsT + i);
+            __m512d dt = _mm512_loadu_pd(raw.dt + i), fsdt = _mm512_loadu_pd(raw.fsdt + i);
+
+            __m512d pin = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(fsVin, threshold, _CMP_LE_OQ), phigh, plow);
+            __m512d pout = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(fsVout, threshold, _CMP_LE_OQ), phigh, plow);
+            __m512d eVin = _mm512_div_pd(_mm512_mul_pd(pin, fsVin), sqrt3);
+            __m512d eVout = _mm512_div_pd(_mm512_mul_pd(pout, fsVout), sqrt3);
+            __m512d eT = _mm512_div_pd(_mm512_mul_pd(_mm512_mul_pd(fsT, tscale), tpart), sqrt3);
+            __m512d edt = _mm512_div_pd(_mm512_mul_pd(_mm512_mul_pd(fsdt, tscale), tpart), sqrt3);
+
+            __m512d T2 = _mm512_mul_pd(T, T);
+            __m512d Vin2 = _mm512_mul_pd(Vin, Vin);
+
+            __m512d a = _mm512_div_pd(eVout, Vin);
+            __m512d b = _mm512_div_pd(_mm512_mul_pd(eVin, Vout), Vin2);
+            __m512d eH = _mm512_mask_sqrt_pd(zero, kAll, _mm512_add_pd(_mm512_mul_pd(a, a), _mm512_mul_pd(b, b)));
+
+            __m512d c = _mm512_div_pd(edt, T);
+            __m512d d = _mm512_div_pd(_mm512_mul_pd(dt, eT), T2);
+            __m512d ephi = _mm512_mul_pd(twopi, _mm512_mask_sqrt_pd(zero, kAll, _mm512_add_pd(_mm512_mul_pd(c, c), _mm512_mul_pd(d, d))));
+
+            _mm512_storeu_pd(freq + i, _mm512_div_pd(one, T));
+            _mm512_storeu_pd(efreq + i, _mm512_div_pd(eT, T2));
+            _mm512_storeu_pd(gain + i, _mm512_div_pd(Vout, Vin));
+            _mm512_storeu_pd(egain + i, eH);
+            _mm512_storeu_pd(phase + i, _mm512_div_pd(_mm512_mul_pd(twopi, dt), T));
+            _mm512_storeu_pd(ephase + i, ephi);
+        }
+        return i;
+    }
+
+#endif
+
+    enum Kernel_t { kScalar, kAVX2, kAVX512 };
+
+    Kernel_t kernel(){
+#ifdef BODE_PROPAGATE_X86
+        static const Kernel_t best = __builtin_cpu_supports("avx512f")? kAVX512
+                                   : __builtin_cpu_supports("avx2")? kAVX2 : kScalar;
+        return best;
+#else
+        return kScalar;
+#endif
+    }
+
+}
+
+void PropagateColumns(std::size_t n, const RawColumns_t &raw,
+                      double *freq, double *efreq, double *gain, double *egain, double *phase, double *ephase){
+
+    std::size_t done = 0;
+#ifdef BODE_PROPAGATE_X86
+    switch(kernel()){
+        case kAVX512: done = propagate_avx512(n, raw, freq, efreq, gain, egain, phase, ephase); break;
+        case kAVX2:   done = propagate_avx2(n, raw, freq, efreq, gain, egain, phase, ephase); break;
+        default:      break;
+    }
+#endif
+    // tail (and everything, without vector units)
+    propagate_scalar(done, n, raw, freq, efreq, gain, egain, phase, ephase);
+}
+
+const char *PropagateKernel(){
+    switch(kernel()){
+        case kAVX512: return "avx512";
+        case kAVX2:   return "avx2";
+        default:      return "scalar";
+    }
+}
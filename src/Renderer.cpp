@@ -0,0 +1,331 @@
+/**
+ * @file Renderer.cpp
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include<algorithm>
+#include<atomic>
+#include<cmath>
+#include<cstring>
+
+#include<TCanvas.h>
+#include<TGraph.h>
+#include<TGraphErrors.h>
+#include<TH1F.h>
+#include<TLegend.h>
+#include<TLine.h>
+#include<TPad.h>
+#include<TROOT.h>
+
+#include"Bode/Analysis.h"
+#include"Bode/Decimate.h"
+#include"Bode/Renderer.h"
+#include"Logger.h"
+
+namespace {
+    std::atomic<ULong_t> gRendererCounter(0);
+    const std::size_t    kMaxQueue = 64;    // pages waiting for the drawing thread, Push blocks beyond
+
+    /// log-scale range of the positive values, widened by margin decades fraction on each side
+    void LogRange(std::size_t n, const double *v, double margin, double &lo, double &hi){
+        lo = 0;
+        hi = 0;
+        for(std::size_t i = 0; i < n; i++){
+            if(v[i] <= 0) continue;
+            if(lo == 0 || v[i] < lo) lo = v[i];
+            if(v[i] > hi) hi = v[i];
+        }
+        if(lo == 0){ lo = 0.1; hi = 10; }
+        if(hi <= lo) { lo /= 2; hi *= 2; }
+        double w = std::pow(hi/lo, margin);
+        lo /= w;
+        hi *= w;
+    }
+
+    /// linear range of v +- ev, widened by margin of its width on each side
+    void LinRange(std::size_t n, const double *v, const double *ev, double margin, double &lo, double &hi){
+        lo = n? v[0] - ev[0] : -1;
+        hi = n? v[0] + ev[0] : 1;
+        for(std::size_t i = 1; i < n; i++){
+            lo = std::min(lo, v[i] - ev[i]);
+            hi = std::max(hi, v[i] + ev[i]);
+        }
+        if(hi <= lo) { lo -= 1; hi += 1; }
+        double w = hi - lo;
+        lo -= margin*w;
+        hi += margin*w;
+    }
+
+    void Fill(TGraphErrors *graph, const Sweep &sweep, const double *y, const double *ey){
+        Int_t n = sweep.Size();
+        graph->Set(n);
+        if(n == 0) return;
+        std::memcpy(graph->GetX(), sweep.Freq(), n*sizeof(double));
+        std::memcpy(graph->GetY(), y, n*sizeof(double));
+        std::memcpy(graph->GetEX(), sweep.ErrFreq(), n*sizeof(double));
+        std::memcpy(graph->GetEY(), ey, n*sizeof(double));
+    }
+
+    void FillCurve(TGraph *curve, const std::vector<Double_t> &x, const std::vector<Double_t> &y){
+        Int_t n = x.size();
+        curve->Set(n);
+        for(Int_t i = 0; i < n; i++) curve->SetPoint(i, x[i], y[i]);
+    }
+}
+
+BodeRenderer::BodeRenderer(const char *output){
+    fOutput = output;
+    fId = gRendererCounter++;
+    _multipage = (strchr(output, '%') == 0);
+    gROOT->SetBatch(true);
+    Bode::SetStyle();
+}
+
+BodeRenderer::~BodeRenderer(){
+    Close();
+}
+
+void BodeRenderer::Init(){
+
+    if(fCanvas) return;
+
+    fCanvas = new TCanvas(TString::Format("fRender_%lu", fId), "", 800, 600);
+
+    fGainPad = new TPad(TString::Format("fRenderGainPad_%lu", fId), "", 0, 0, 1, 1);
+    fGainPad->SetLogx();
+    fGainPad->SetLogy();
+    fPhasePad = new TPad(TString::Format("fRenderPhasePad_%lu", fId), "", 0, 0, 1, 1);
+    fPhasePad->SetLogx();
+    fPhasePad->SetFillStyle(4000);
+    fRightMargin = fGainPad->GetRightMargin();
+
+    // empty frames carry the axes, graphs and curves are drawn over them
+    fGainFrame = new TH1F(TString::Format("fRenderGainFrame_%lu", fId), ";Frequency [Hz];Gain V_{out}/V_{in}", 1, 0.1, 10);
+    fPhaseFrame = new TH1F(TString::Format("fRenderPhaseFrame_%lu", fId), ";Frequency [Hz];Phase [rad]", 1, 0.1, 10);
+    for(TH1F *frame: {fGainFrame, fPhaseFrame}){
+        frame->SetDirectory(0);
+        frame->SetStats(0);
+        frame->GetXaxis()->CenterTitle();
+        frame->GetYaxis()->CenterTitle();
+    }
+    fLabelSize = fPhaseFrame->GetXaxis()->GetLabelSize();
+
+    fGain = new TGraphErrors();
+    fGain->SetMarkerStyle(20);
+    fGain->SetMarkerSize(0.8);
+    fPhase = new TGraphErrors();
+    fPhase->SetMarkerStyle(20);
+    fPhase->SetMarkerSize(0.8);
+    fPhase->SetLineColor(kRed);
+    fPhase->SetMarkerColor(kRed);
+
+    fGainCurve = new TGraph();
+    fGainCurve->SetLineColor(kBlack);
+    fPhaseCurve = new TGraph();
+    fPhaseCurve->SetLineColor(kRed);
+    fPhaseCurve->SetLineStyle(kDashed);
+
+    fLegend = new TLegend(0.2, 0.2, 0.5, 0.35);
+    fLegend->SetFillColorAlpha(0, 0.75);
+    fLegend->SetTextSize(20);
+
+    fCutoffLine = new TLine();
+    fCutoffLine->SetLineStyle(kDashed);
+}
+
+void BodeRenderer::Draw(const BodePlot_t &plot){
+
+    if(plot.sweep.Empty() || (!plot.plotGain && !plot.plotPhase)) return;
+
+    Init();
+
+    // the decimated sweep keeps the extent of the full one, the axes do not change
+    DecimateSweep(plot.sweep, fPlotSweep, plot.lodBins, plot.lodOutlier);
+    const Sweep &sweep = fPlotSweep;
+    std::size_t n = sweep.Size();
+    if(n == 0) return;
+    bool both = plot.plotGain && plot.plotPhase;
+
+    double xmin, xmax, ymin, ymax;
+    LogRange(n, sweep.Freq(), 0.05, xmin, xmax);
+
+    // pads and primitives are only taken off the lists here, never deleted
+    fCanvas->Clear();
+    fGainPad->Clear();
+    fPhasePad->Clear();
+    fLegend->Clear();
+    fLegend->SetHeader(Form("#bf{Bode visualization} #it{%s}", plot.label.c_str()));
+
+    fGainPad->SetRightMargin(both? 0.16 : fRightMargin);
+    fPhasePad->SetRightMargin(both? 0.16 : fRightMargin);
+
+    if(plot.plotGain){
+        Fill(fGain, sweep, sweep.Gain(), sweep.ErrGain());
+        LogRange(n, sweep.Gain(), 0.1, ymin, ymax);
+        fGainFrame->GetXaxis()->SetLimits(xmin, xmax);
+        fGainFrame->SetMinimum(ymin);
+        fGainFrame->SetMaximum(ymax);
+
+        fCanvas->cd();
+        fGainPad->Draw();
+        fGainPad->cd();
+        fGainFrame->Draw("axis");
+        fGain->Draw("p");
+        if(plot.hasGainFit){
+            SampleCurve(plot.filter, BodeModel::kGain, plot.parGain, xmin, xmax, true, true, fCurveX, fCurveY);
+            FillCurve(fGainCurve, fCurveX, fCurveY);
+            fGainCurve->Draw(Bode::CurveOption(plot.goptGain.c_str()));
+        }
+        if(plot.cutoff > 0){
+            fCutoffLine->SetX1(plot.cutoff);
+            fCutoffLine->SetX2(plot.cutoff);
+            fCutoffLine->SetY1(ymin);
+            fCutoffLine->SetY2(ymax);
+            fCutoffLine->Draw();
+        }
+        fLegend->AddEntry(fGain, "Gain", "LPE");
+    }
+
+    if(plot.plotPhase){
+        Fill(fPhase, sweep, sweep.Phase(), sweep.ErrPhase());
+        LinRange(n, sweep.Phase(), sweep.ErrPhase(), 0.1, ymin, ymax);
+        fPhaseFrame->GetXaxis()->SetLimits(xmin, xmax);
+        fPhaseFrame->SetMinimum(ymin);
+        fPhaseFrame->SetMaximum(ymax);
+        // over the gain pad only the phase y axis (on the right) is wanted
+        fPhaseFrame->GetXaxis()->SetLabelSize(both? 0 : fLabelSize);
+        fPhaseFrame->GetXaxis()->SetTitle(both? "" : "Frequency [Hz]");
+
+        fCanvas->cd();
+        fPhasePad->Draw();
+        fPhasePad->cd();
+        fPhaseFrame->Draw(both? "axis y+" : "axis");
+        fPhase->Draw("p");
+        if(plot.hasPhaseFit){
+            SampleCurve(plot.filter, BodeModel::kPhase, plot.parPhase, xmin, xmax, true, false, fCurveX, fCurveY);
+            FillCurve(fPhaseCurve, fCurveX, fCurveY);
+            fPhaseCurve->Draw(Bode::CurveOption(plot.goptPhase.c_str()));
+        }
+        if(!plot.plotGain && plot.cutoff > 0){
+            fCutoffLine->SetX1(plot.cutoff);
+            fCutoffLine->SetX2(plot.cutoff);
+            fCutoffLine->SetY1(ymin);
+            fCutoffLine->SetY2(ymax);
+            fCutoffLine->Draw();
+        }
+        fLegend->AddEntry(fPhase, "Phase", "LPE");
+    }
+
+    fCanvas->cd();
+    fLegend->Draw();
+    fCanvas->Modified();
+    fCanvas->Update();
+
+    if(_multipage){
+        if(!_isopen){
+            fCanvas->Print((fOutput + "[").c_str());
+            _isopen = true;
+        }
+        fCanvas->Print(fOutput.c_str());
+    }else{
+        fCanvas->Print(Form(fOutput.c_str(), fPages));
+    }
+    fPages++;
+}
+
+void BodeRenderer::Push(BodePlot_t &&plot){
+
+    std::unique_lock<std::mutex> lock(fMutex);
+    if(fThread.joinable()){
+        fCond.wait(lock, [this](){ return fQueue.size() < kMaxQueue; });
+    }
+    fQueue.push_back(std::move(plot));
+    lock.unlock();
+    fCond.notify_all();
+}
+
+void BodeRenderer::Start(){
+
+    if(fThread.joinable()) return;
+
+    std::lock_guard<std::mutex> lock(fMutex);
+    _stop = false;
+    fThread = std::thread([this](){ Loop(); });
+}
+
+void BodeRenderer::Loop(){
+
+    // every ROOT object of this renderer is made, used and deleted on this thread
+    while(true){
+        std::unique_lock<std::mutex> lock(fMutex);
+        fCond.wait(lock, [this](){ return _stop || !fQueue.empty(); });
+        if(fQueue.empty()) break;
+
+        BodePlot_t plot = std::move(fQueue.front());
+        fQueue.pop_front();
+        lock.unlock();
+        fCond.notify_all();
+
+        Draw(plot);
+    }
+
+    Finish();
+}
+
+void BodeRenderer::Close(){
+
+    if(fThread.joinable()){
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            _stop = true;
+        }
+        fCond.notify_all();
+        fThread.join();
+        return;
+    }
+
+    while(!fQueue.empty()){
+        Draw(fQueue.front());
+        fQueue.pop_front();
+    }
+    Finish();
+}
+
+void BodeRenderer::Finish(){
+
+    if(_isopen){
+        fCanvas->Print((fOutput + "]").c_str());
+        _isopen = false;
+    }
+    if(!fCanvas) return;
+
+    fCanvas->Clear();
+    delete fGainPad;
+    delete fPhasePad;
+    delete fCanvas;
+    delete fGainFrame;
+    delete fPhaseFrame;
+    delete fGain;
+    delete fPhase;
+    delete fGainCurve;
+    delete fPhaseCurve;
+    delete fLegend;
+    delete fCutoffLine;
+    fCanvas = 0;
+    fGainPad = 0;
+    fPhasePad = 0;
+    fGainFrame = 0;
+    fPhaseFrame = 0;
+    fGain = 0;
+    fPhase = 0;
+    fGainCurve = 0;
+    fPhaseCurve = 0;
+    fLegend = 0;
+    fCutoffLine = 0;
+}
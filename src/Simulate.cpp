@@ -9,31 +9,328 @@
  * 
  */
 
-#include<TFormula.h>
-#include<TRandom.h>
+#include<algorithm>
+#include<chrono>
+#include<cmath>
+#include<cstdio>
+#include<thread>
+
 #include<TMath.h>
 
 #include"BodeDataSim/SimEngine.h"
+#include"Bode/Archive.h"
+#include"Bode/ErrorModel.h"
+#include"Bode/Noise.h"
+#include"Bode/Philox.h"
+#include"Bode/Propagate.h"
+#include"Bode/ThreadPool.h"
+
+namespace {
+
+    // smallest 1-2-5 scope setting >= x
+    double fullscale(double x){
+        double decade = std::pow(10, std::floor(std::log10(x)));
+        double m = x/decade;
+        if(m <= 1) return decade;
+        if(m <= 2) return 2*decade;
+        if(m <= 5) return 5*decade;
+        return 10*decade;
+    }
+
+    bool write_rows(const char *filename, const std::vector<Double_t> &rows){
+        FILE *out = fopen(filename, "w");
+        if(!out) return false;
+        fprintf(out, "# V_in V_in(fs) V_out V_out(fs) T T(fs) dt dt(fs)\n");
+        for(std::size_t i = 0; i + 8 <= rows.size(); i += 8){
+            fprintf(out, "%.9g %.9g %.9g %.9g %.9g %.9g %.9g %.9g\n",
+                rows[i], rows[i+1], rows[i+2], rows[i+3], rows[i+4], rows[i+5], rows[i+6], rows[i+7]);
+        }
+        return fclose(out) == 0;
+    }
+
+}
+
+SimEngine::SimEngine(){}
+
+SimEngine::~SimEngine(){
+    fprintf(stderr, "%s\n", Logger::warning("Deleted obj. SimEngine"));
+}
+
+void SimEngine::SetFrequencyRange(Double_t fmin, Double_t fmax, Int_t npoints){
+    fFmin = fmin;
+    fFmax = fmax;
+    fNpoints = npoints;
+}
+
+void SimEngine::GenLowNoise(){
+    fNoiseScale = 0.25;
+}
+
+void SimEngine::GenHighNoise(){
+    fNoiseScale = 1;
+}
+
+template<class Model>
+void SimEngine::DoPoint(Double_t f, ULong64_t point, ULong64_t sweep, Double_t *row, const Double_t *drift) const {
+
+    const Double_t par[3] = {gGain, gCutoff, gQ};
+
+    // true values and the scope settings an operator would pick for them
+    Double_t T = 1/f;
+    Double_t Vout = Model::Gain(f, par)*fVin;
+    Double_t dt = Model::Phase(f, par)*T/(2*M_PI);
+
+    row[0] = fVin;
+    row[1] = fullscale(fVin/6);
+    row[2] = Vout;
+    row[3] = fullscale(Vout/6);
+    row[4] = T;
+    row[5] = fullscale(T/8);
+    row[6] = dt;
+    row[7] = fullscale(std::max(std::fabs(dt), T/100)/4);
+
+    // reading noise: uniform over the full-scale error bound, as assumed by ReadInput.
+    // One Philox block per (point, sweep) gives the four readings of a row
+    const std::uint32_t slo = static_cast<std::uint32_t>(sweep);
+    const std::uint32_t shi = static_cast<std::uint32_t>(sweep >> 32);
+    Philox::Block_t u = Philox::Generate(point, slo, shi, 0, seed);
+    row[0] += fNoiseScale*get_VRange(row[1])*(2*Philox::ToUniform(u.v[0]) - 1);
+    row[2] += fNoiseScale*get_VRange(row[3])*(2*Philox::ToUniform(u.v[1]) - 1);
+    row[4] += fNoiseScale*get_TRange(row[5])*(2*Philox::ToUniform(u.v[2]) - 1);
+    row[6] += fNoiseScale*get_TRange(row[7])*(2*Philox::ToUniform(u.v[3]) - 1);
+
+    // slow drift moves the true values; the scope settings were picked before it
+    if(drift){
+        row[0] *= 1 + drift[0];
+        row[2] *= 1 + drift[1];
+        row[6] += drift[2]*T;
+    }
+
+    // ADC: 2^bits levels over the 8 vertical divisions
+    if(fADCBits > 0){
+        for(int c = 0; c < 4; c += 2){
+            Double_t lsb = 8*row[c + 1]/std::ldexp(1., fADCBits);
+            row[c] = lsb*std::round(row[c]/lsb);
+        }
+    }
+}
+
+template<class Model>
+void SimEngine::DoGenerate(ULong64_t sweep, Double_t *rows) const {
+
+    const Double_t lfmin = std::log(fFmin);
+    const Double_t step = (fNpoints > 1)? (std::log(fFmax) - lfmin)/(fNpoints - 1) : 0;
+
+    if(fDrift == 0 && fTimeDrift == 0){
+        for(Int_t i = 0; i < fNpoints; i++) DoPoint<Model>(std::exp(lfmin + i*step), i, sweep, rows + 8*i);
+        return;
+    }
+
+    // the whole sweep's drift at once: one transform for the two amplitude series,
+    // one for dt; V_out takes the common part of V_in with weight rho
+    thread_local std::vector<Double_t> noise;
+    noise.resize(3*fNpoints);
+    Double_t *a = noise.data(), *b = a + fNpoints, *t = b + fNpoints;
+    ColoredNoise(fNpoints, fDriftAlpha, seed, sweep, 1, a, b);
+    if(fTimeDrift != 0) ColoredNoise(fNpoints, fDriftAlpha, seed, sweep, 2, t, 0);
+    else std::fill(t, t + fNpoints, 0.);
+
+    const Double_t rho = std::max(-1., std::min(1., fDriftCorrelation));
+    const Double_t rest = std::sqrt(1 - rho*rho);
+    for(Int_t i = 0; i < fNpoints; i++){
+        Double_t drift[3];
+        drift[0] = fDrift*a[i];
+        drift[1] = fDrift*(rho*a[i] + rest*b[i]);
+        drift[2] = fTimeDrift*t[i];
+        DoPoint<Model>(std::exp(lfmin + i*step), i, sweep, rows + 8*i, drift);
+    }
+}
+
+Bool_t SimEngine::Measure(Double_t freq, ULong64_t point, Double_t *row, ULong64_t sweep) const {
+
+    bool ok = gGain > 0 && gCutoff > 0 && freq > 0 && fVin > 0;
+    if(fFilter == BodeModel::kBandpass) ok &= (gQ > 0);
+    if(!ok || fFilter == BodeModel::kUnknown){
+        printf("%s", Logger::error("SimEngine: set filter type, gain, cutoff (and Q for bandpass) first, and measure at f > 0."));
+        return false;
+    }
+
+    switch(fFilter){
+        case BodeModel::kLowpass:   DoPoint<BodeModel::Lowpass>(freq, point, sweep, row); break;
+        case BodeModel::kHighpass:  DoPoint<BodeModel::Highpass>(freq, point, sweep, row); break;
+        case BodeModel::kBandpass:  DoPoint<BodeModel::Bandpass>(freq, point, sweep, row); break;
+        default: break;
+    }
+
+    return true;
+}
+
+std::vector<Double_t> SimEngine::Generate(ULong64_t sweep) const {
+
+    bool ok = gGain > 0 && gCutoff > 0 && fFmin > 0 && fFmax >= fFmin && fNpoints > 0 && fVin > 0;
+    if(fFilter == BodeModel::kBandpass) ok &= (gQ > 0);
+    if(!ok || fFilter == BodeModel::kUnknown){
+        printf("%s", Logger::error("SimEngine: set filter type, gain, cutoff (and Q for bandpass) and a valid frequency range first."));
+        return std::vector<Double_t>();
+    }
+
+    std::vector<Double_t> rows(8*fNpoints);
+    switch(fFilter){
+        case BodeModel::kLowpass:   DoGenerate<BodeModel::Lowpass>(sweep, rows.data());  break;
+        case BodeModel::kHighpass:  DoGenerate<BodeModel::Highpass>(sweep, rows.data()); break;
+        case BodeModel::kBandpass:  DoGenerate<BodeModel::Bandpass>(sweep, rows.data()); break;
+        default: break;
+    }
+
+    return rows;
+}
+
+Bool_t SimEngine::DataSim(const char *filename, ULong64_t sweep){
+
+    std::vector<Double_t> rows = Generate(sweep);
+    if(rows.empty()) return false;
+
+    if(!write_rows(filename, rows)){
+        printf("%s", Logger::error(Form("cannot write '%s'.", filename)));
+        return false;
+    }
+    return true;
+}
+
+Bool_t SimEngine::DataSimBatch(const char *pattern, ULong64_t nsweeps, unsigned nthreads){
+
+    std::vector<char> failed(nsweeps, 0);
+
+    // every sweep has its own Philox counter range: same files for any nthreads
+    ThreadPool pool(nthreads);
+    pool.ParallelFor(nsweeps, [&](std::size_t i){
+        char filename[4096];
+        snprintf(filename, sizeof(filename), pattern, (unsigned long long)i);
+        std::vector<Double_t> rows = Generate(i);
+        failed[i] = rows.empty() || !write_rows(filename, rows);
+    });
+
+    ULong64_t nfailed = std::count(failed.begin(), failed.end(), 1);
+    if(nfailed > 0){
+        printf("%s", Logger::error(Form("SimEngine: %llu of %llu sweeps could not be written.", nfailed, nsweeps)));
+    }
+    return nfailed == 0;
+}
+
+Bool_t SimEngine::DataSimArchive(const char *filename, ULong64_t nsweeps, bool deflate, unsigned nthreads){
+
+    BodeArchiveWriter archive(filename, deflate);
+    if(!archive.IsOpen()) return false;
+
+    std::vector<char> failed(nsweeps, 0);
+
+    // entries land in completion order, the names say which sweep they are
+    ThreadPool pool(nthreads);
+    pool.ParallelFor(nsweeps, [&](std::size_t i){
+        std::vector<Double_t> rows = Generate(i);
+        if(rows.empty()){
+            failed[i] = 1;
+            return;
+        }
+
+        ArchiveSweep_t stored;
+        stored.name = Form("sweep_%llu", (unsigned long long)i);
+        stored.filter = fFilter;
+        stored.raw.resize(8*fNpoints);
+        for(Int_t r = 0; r < fNpoints; r++){
+            for(int c = 0; c < 8; c++) stored.raw[c*fNpoints + r] = rows[8*r + c];
+        }
+
+        const Double_t *col = stored.raw.data();
+        RawColumns_t raw = {col, col + fNpoints, col + 2*fNpoints, col + 3*fNpoints,
+                            col + 4*fNpoints, col + 5*fNpoints, col + 6*fNpoints, col + 7*fNpoints};
+        stored.sweep.Resize(fNpoints);
+        Sweep &s = stored.sweep;
+        PropagateColumns(fNpoints, raw, s.Freq(), s.ErrFreq(), s.Gain(), s.ErrGain(), s.Phase(), s.ErrPhase());
+
+        failed[i] = !archive.Write(stored);
+    }, 16);
+
+    ULong64_t nfailed = std::count(failed.begin(), failed.end(), 1);
+    if(nfailed > 0){
+        printf("%s", Logger::error(Form("SimEngine: %llu of %llu sweeps could not be written.", nfailed, nsweeps)));
+    }
+    return archive.Close() && nfailed == 0;
+}
+
+void SimEngine::ToSweep(const std::vector<Double_t> &rows, Sweep &sweep) const {
+    Int_t n = rows.size()/8;
+    sweep.Resize(n);
+    Double_t out[6];
+    for(Int_t i = 0; i < n; i++){
+        PropagateRow(&rows[8*i], out);
+        for(int c = 0; c < Sweep::kNColumns; c++) sweep.Column(Sweep::Column_t(c))[i] = out[c];
+    }
+}
+
+Bool_t SimEngine::Fill(Bode &bode, ULong64_t sweep) const {
+
+    std::vector<Double_t> rows = Generate(sweep);
+    if(rows.empty()) return false;
+
+    // propagate straight into the columns Bode will own, then hand them over
+    Sweep sweepdata;
+    ToSweep(rows, sweepdata);
+
+    bode.SetSweep(std::move(sweepdata));
+    return bode.SetFunctions();
+}
+
+Bool_t SimEngine::GenerateSweeps(ULong64_t first, ULong64_t nsweeps, std::vector<Sweep> &sweeps, unsigned nthreads) const {
+
+    sweeps.resize(nsweeps);
+    if(nsweeps == 0) return true;
+    if(Generate(first).empty()) return false;
+
+    // sweep numbers address the draws (white noise and drift), not the thread
+    ThreadPool pool(nthreads);
+    pool.ParallelFor(nsweeps, [&](std::size_t i){
+        ToSweep(Generate(first + i), sweeps[i]);
+    }, 16);
+
+    return true;
+}
+
+Bool_t SimEngine::Stream(BodeLive &live, ULong64_t sweep, Double_t rate) const {
+
+    BodeLive::Queue_t *queue = live.AddProducer();
+    if(!queue) return false;
+
+    std::vector<Double_t> rows = Generate(sweep);
+    if(rows.empty()) return false;
+
+    // paced against a fixed schedule, not by sleeping a period after each push
+    auto start = std::chrono::steady_clock::now();
+    for(Int_t i = 0; i < fNpoints; i++){
+        if(rate > 0) std::this_thread::sleep_until(start + std::chrono::duration<double>(i/rate));
+        queue->Push(BodeLive::FromReading(&rows[8*i]));
+    }
 
-SimEngine::SimEngine(){ gen = new TRandom(); }
+    return true;
+}
 
 void SimEngine::SetFilterType(System_t filter){
     fltype = filter;
     switch(fltype.Hash()){
         case lowpass:
-            _gainformula = "[0]/sqrt(1+pow(x/[1], 2))"; // [0] gain, [1] cutoff
-            _phaseformula = "";
+            fFilter = BodeModel::kLowpass;     // [0] gain, [1] cutoff
+            _islowhighpass = true;
             break;
         case highpass:
-            _gainformula = "[0]/sqrt(1+pow([1]/x, 2))"; // [0] gain, [1] cutoff
-            _phaseformula = "";
+            fFilter = BodeModel::kHighpass;    // [0] gain, [1] cutoff
+            _islowhighpass = true;
             break;
         case bandpass:
-            _gainformula = "[0]/sqrt(1+pow([2], 2)*pow(x/[1]-[1]/x, 2))"; // [0] gain, [1] cutoff/peak frequency, [2] Q factor
-            _phaseformula = "";
+            fFilter = BodeModel::kBandpass;    // [0] gain, [1] cutoff/peak frequency, [2] Q factor
             _islowhighpass = false;
             break;
         default:
+            fFilter = BodeModel::kUnknown;
             fprintf(stderr, "%s", Logger::warning(Form("System_t option '%s' not recognised!\n"
             "Available options are: \n\t\"lowpass\"\n\t\"highpass\"\n\t\"bandpass\"\n ", filter.Data())));
     }
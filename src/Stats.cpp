@@ -0,0 +1,104 @@
+/**
+ * @file Stats.cpp
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include<cmath>
+#include<cstdio>
+#include<cstdlib>
+#include<cstring>
+
+#include"Bode/Stats.h"
+
+namespace {
+
+    bool enabled_by_env(){
+        static const bool enabled = [](){
+            const char *env = getenv("BODE_STATS");
+            return env && *env && strcmp(env, "0") != 0;
+        }();
+        return enabled;
+    }
+
+}
+
+BodeStats::BodeStats() : _enabled(enabled_by_env()) {}
+
+const char *BodeStats::Name(Stage_t stage){
+    switch(stage){
+        case kReadInput:        return "ReadInput";
+        case kSetFunctions:     return "SetFunctions";
+        case kFitGain:          return "FitGain";
+        case kFitPhase:         return "FitPhase";
+        case kFitCorrelated:    return "FitCorrelated";
+        case kPlot:             return "Plot";
+        default:                return "unknown";
+    }
+}
+
+std::string BodeStats::JSONNumber(double x){
+    if(!std::isfinite(x)) return "null";
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.9g", x);
+    return buf;
+}
+
+std::string BodeStats::JSONString(const char *s){
+    std::string out = "\"";
+    for(; *s; s++){
+        unsigned char c = *s;
+        if(c == '"' || c == '\\'){
+            out += '\\';
+            out += c;
+        }else if(c < 0x20){
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        }else{
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+void BodeStats::Reset(){
+    for(int s = 0; s < kNStages; s++) fStages[s] = StageStats_t();
+}
+
+std::string BodeStats::ToJSON() const {
+
+    std::string json = "{";
+    char buf[512];
+    bool first = true;
+
+    for(int s = 0; s < kNStages; s++){
+        const StageStats_t &st = fStages[s];
+        if(st.calls == 0) continue;
+
+        snprintf(buf, sizeof(buf), "%s\"%s\":{\"calls\":%ld,\"wall_s\":%s,\"last_s\":%s",
+            first? "" : ",", Name(Stage_t(s)), st.calls, JSONNumber(st.wall).c_str(), JSONNumber(st.last).c_str());
+        json += buf;
+        first = false;
+
+        if(s == kReadInput){
+            snprintf(buf, sizeof(buf), ",\"points\":%ld,\"rejected\":%ld", st.points, st.rejected);
+            json += buf;
+        }
+        if(s == kFitGain || s == kFitPhase || s == kFitCorrelated){
+            snprintf(buf, sizeof(buf), ",\"nfcn\":%ld,\"ngrad\":%ld,\"niter\":%ld,\"npass\":%ld,\"cache_hits\":%ld"
+                ",\"status\":%d,\"valid\":%s,\"chi2\":%s,\"ndf\":%d",
+                st.fit.nfcn, st.fit.ngrad, st.fit.niter, st.fit.npass, st.cachehits,
+                st.status, st.valid? "true" : "false", JSONNumber(st.chi2).c_str(), st.ndf);
+            json += buf;
+        }
+        json += "}";
+    }
+
+    return json + "}";
+}
@@ -0,0 +1,95 @@
+/**
+ * @file Sweep.cpp
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include<cstdlib>
+#include<cstring>
+#include<new>
+
+#include"Bode/Sweep.h"
+
+namespace {
+    const std::size_t kAlign = 64;                          // bytes, one cache line
+    const std::size_t kLane  = kAlign/sizeof(double);       // doubles per cache line
+}
+
+Sweep::Sweep(std::size_t n){
+    Resize(n);
+}
+
+Sweep::Sweep(const Sweep &other){
+    *this = other;
+}
+
+Sweep::Sweep(Sweep &&other) noexcept {
+    *this = static_cast<Sweep &&>(other);
+}
+
+Sweep &Sweep::operator=(const Sweep &other){
+    if(this == &other) return *this;
+    fSize = 0;
+    Reserve(other.fSize);
+    for(int c = 0; c < kNColumns; c++){
+        if(other.fSize) memcpy(Column(Column_t(c)), other.Column(Column_t(c)), other.fSize*sizeof(double));
+    }
+    fSize = other.fSize;
+    return *this;
+}
+
+Sweep &Sweep::operator=(Sweep &&other) noexcept {
+    if(this == &other) return *this;
+    std::free(fData);
+    fData = other.fData;
+    fSize = other.fSize;
+    fCapacity = other.fCapacity;
+    other.fData = 0;
+    other.fSize = 0;
+    other.fCapacity = 0;
+    return *this;
+}
+
+Sweep::~Sweep(){
+    std::free(fData);
+}
+
+void Sweep::Reallocate(std::size_t capacity){
+
+    capacity = (capacity + kLane - 1)/kLane*kLane;
+    double *data = static_cast<double *>(std::aligned_alloc(kAlign, kNColumns*capacity*sizeof(double)));
+    if(!data) throw std::bad_alloc();
+
+    // columns are laid out by capacity, so each one moves to its new offset
+    for(int c = 0; c < kNColumns; c++){
+        if(fSize) memcpy(data + c*capacity, fData + c*fCapacity, fSize*sizeof(double));
+    }
+    std::free(fData);
+    fData = data;
+    fCapacity = capacity;
+}
+
+void Sweep::Reserve(std::size_t n){
+    if(n > fCapacity) Reallocate(n);
+}
+
+void Sweep::Resize(std::size_t n){
+    Reserve(n);
+    fSize = n;
+}
+
+void Sweep::PushBack(double freq, double efreq, double gain, double egain, double phase, double ephase){
+    if(fSize == fCapacity) Reallocate(fCapacity? 2*fCapacity : kLane);
+    Freq()[fSize] = freq;
+    ErrFreq()[fSize] = efreq;
+    Gain()[fSize] = gain;
+    ErrGain()[fSize] = egain;
+    Phase()[fSize] = phase;
+    ErrPhase()[fSize] = ephase;
+    fSize++;
+}
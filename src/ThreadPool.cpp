@@ -0,0 +1,132 @@
+/**
+ * @file ThreadPool.cpp
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include<chrono>
+
+#include"Bode/ThreadPool.h"
+
+namespace {
+    // which pool/worker the calling thread belongs to, if any
+    thread_local const ThreadPool  *tl_pool = 0;
+    thread_local unsigned           tl_worker = 0;
+}
+
+ThreadPool::ThreadPool(unsigned nthreads){
+
+    if(nthreads == 0) nthreads = std::thread::hardware_concurrency();
+    if(nthreads == 0) nthreads = 1;
+
+    for(unsigned i = 0; i < nthreads; i++) fQueues.emplace_back(new Queue_t);
+    for(unsigned i = 0; i < nthreads; i++) fWorkers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool(){
+    // nobody is left to catch what a task threw: the error dies with the pool
+    Drain();
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        _stop = true;
+    }
+    fWake.notify_all();
+    for(auto &w: fWorkers) w.join();
+}
+
+void ThreadPool::Submit(std::function<void()> task){
+
+    unsigned target = (tl_pool == this)? tl_worker : fNext.fetch_add(1) % fQueues.size();
+
+    fPending.fetch_add(1);
+    {
+        // count it first, under fMutex, so a worker going to sleep can't miss it
+        std::lock_guard<std::mutex> lock(fMutex);
+        fQueued.fetch_add(1);
+    }
+    {
+        std::lock_guard<std::mutex> lock(fQueues[target]->lock);
+        fQueues[target]->tasks.push_back(std::move(task));
+    }
+    fWake.notify_one();
+}
+
+bool ThreadPool::TryRun(unsigned self){
+
+    std::function<void()> task;
+    unsigned nq = fQueues.size();
+
+    // own queue first (LIFO, cache friendly), then steal oldest work from the others
+    if(self < nq){
+        std::lock_guard<std::mutex> lock(fQueues[self]->lock);
+        if(!fQueues[self]->tasks.empty()){
+            task = std::move(fQueues[self]->tasks.back());
+            fQueues[self]->tasks.pop_back();
+        }
+    }
+    for(unsigned k = 1; !task && k <= nq; k++){
+        unsigned victim = (self + k) % nq;
+        std::lock_guard<std::mutex> lock(fQueues[victim]->lock);
+        if(!fQueues[victim]->tasks.empty()){
+            task = std::move(fQueues[victim]->tasks.front());
+            fQueues[victim]->tasks.pop_front();
+        }
+    }
+    if(!task) return false;
+
+    fQueued.fetch_sub(1);
+    try{
+        task();
+    }catch(...){
+        std::lock_guard<std::mutex> lock(fErrorMutex);
+        if(!fError) fError = std::current_exception();
+    }
+    fPending.fetch_sub(1);
+    fIdle.notify_all();
+
+    return true;
+}
+
+bool ThreadPool::RunOne(){
+    return TryRun((tl_pool == this)? tl_worker : fQueues.size());
+}
+
+void ThreadPool::WorkerLoop(unsigned id){
+
+    tl_pool = this;
+    tl_worker = id;
+
+    for(;;){
+        if(TryRun(id)) continue;
+
+        std::unique_lock<std::mutex> lock(fMutex);
+        fWake.wait(lock, [this](){ return _stop || fQueued.load() > 0; });
+        if(_stop && fQueued.load() == 0) return;
+    }
+}
+
+void ThreadPool::Drain(){
+    while(fPending.load() > 0){
+        if(!RunOne()){
+            std::unique_lock<std::mutex> lock(fMutex);
+            fIdle.wait_for(lock, std::chrono::microseconds(200), [this](){ return fPending.load() == 0; });
+        }
+    }
+}
+
+void ThreadPool::Wait(){
+
+    Drain();
+
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(fErrorMutex);
+        std::swap(error, fError);
+    }
+    if(error) std::rethrow_exception(error);
+}
@@ -0,0 +1,240 @@
+/**
+ * @file ToyMC.cpp
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include<algorithm>
+#include<cmath>
+#include<cstdio>
+
+#include<TROOT.h>
+
+#include"Bode/Analysis.h"
+#include"Bode/Chi2.h"
+#include"Bode/ErrorModel.h"
+#include"Bode/FitFCN.h"
+#include"Bode/Philox.h"
+#include"Bode/ThreadPool.h"
+#include"Bode/ToyMC.h"
+#include"Logger.h"
+
+namespace {
+    const char *kParName[BodeToyMC::kNPar] = {"gain", "cutoff", "Q", "GBW"};
+}
+
+BodeToyMC::BodeToyMC(const Bode &bode) : fSweep(bode.GetSweep()) {
+    fFilter = bode.GetFilter();
+    if(bode.GetRaw().size() == 8*fSweep.Size()) fRaw = bode.GetRaw();
+    fPar[0] = bode.GetGain();
+    fPar[1] = bode.GetCutoff();
+    fPar[2] = bode.GetQ();
+    bode.GetFitRange(BodeModel::kGain, fXmin, fXmax);
+}
+
+BodeToyMC::BodeToyMC(const Sweep &sweep, BodeModel::Filter_t filter, const Double_t *par, const Double_t *raw) : fSweep(sweep) {
+    fFilter = filter;
+    std::copy(par, par + BodeModel::NPar(filter), fPar);
+    if(raw) fRaw.assign(raw, raw + 8*sweep.Size());
+}
+
+void BodeToyMC::MakeReplica(ULong64_t replica, Sweep &toy) const {
+
+    std::size_t n = fSweep.Size();
+    toy.Resize(n);
+
+    std::uint32_t rlo = static_cast<std::uint32_t>(replica);
+    std::uint32_t rhi = static_cast<std::uint32_t>(replica >> 32);
+
+    if(fMode == kBootstrap){
+        for(std::size_t i = 0; i < n; i++){
+            Philox::Block_t b = Philox::Generate(i, rlo, rhi, 2, fSeed);
+            std::size_t j = b.v[0] % n;
+            for(int c = 0; c < Sweep::kNColumns; c++){
+                toy.Column(Sweep::Column_t(c))[i] = fSweep.Column(Sweep::Column_t(c))[j];
+            }
+        }
+        return;
+    }
+
+    // same spread as the reading error: sigma for a gaussian, sqrt(3) sigma half width if flat
+    for(std::size_t i = 0; i < n; i++){
+        Philox::Block_t u = Philox::Generate(i, rlo, rhi, 0, fSeed);
+        Philox::Block_t v = Philox::Generate(i, rlo, rhi, 1, fSeed);
+        Double_t z[4];
+        for(int k = 0; k < 4; k++){
+            z[k] = (fNoise == kGaus)? Philox::ToGaus(u.v[k], v.v[k]) : std::sqrt(3)*(2*Philox::ToUniform(u.v[k]) - 1);
+        }
+
+        if(!fRaw.empty()){
+            // the readings a perfect scope would give at the nominal parameters, then the
+            // noise on each of them: gain and phase both move with T, as measured
+            Double_t row[8], out[6];
+            for(int c = 0; c < 8; c++) row[c] = fRaw[c*n + i];
+            Double_t Vin = row[0], T = row[4];
+            Double_t f = 1/T;
+            row[0] = Vin + z[0]*get_VRange(row[1])/std::sqrt(3);
+            row[2] = Vin*BodeModel::Eval(fFilter, BodeModel::kGain, f, fPar) + z[1]*get_VRange(row[3])/std::sqrt(3);
+            row[4] = T + z[2]*get_TRange(row[5])/std::sqrt(3);
+            row[6] = BodeModel::Eval(fFilter, BodeModel::kPhase, f, fPar)*T/(2*M_PI) + z[3]*get_TRange(row[7])/std::sqrt(3);
+            PropagateRow(row, out);
+            for(int c = 0; c < Sweep::kNColumns; c++) toy.Column(Sweep::Column_t(c))[i] = out[c];
+            continue;
+        }
+
+        // no readings: the same noise on the propagated points, gain and phase independent
+        Double_t f = fSweep.Freq()[i];
+        toy.Freq()[i] = f + z[0]*fSweep.ErrFreq()[i];
+        toy.ErrFreq()[i] = fSweep.ErrFreq()[i];
+        toy.Gain()[i] = BodeModel::Eval(fFilter, BodeModel::kGain, f, fPar) + z[1]*fSweep.ErrGain()[i];
+        toy.ErrGain()[i] = fSweep.ErrGain()[i];
+        toy.Phase()[i] = BodeModel::Eval(fFilter, BodeModel::kPhase, f, fPar) + z[2]*fSweep.ErrPhase()[i];
+        toy.ErrPhase()[i] = fSweep.ErrPhase()[i];
+    }
+}
+
+bool BodeToyMC::DoReplica(ULong64_t replica, Sweep &toy, Double_t *out) const {
+
+    MakeReplica(replica, toy);
+
+    Chi2Function chi2(fFilter, toy.Size(), toy.Freq(), toy.ErrFreq());
+    if(_fitgain) chi2.AddTerm(BodeModel::kGain, toy.Gain(), toy.ErrGain());
+    if(_fitphase) chi2.AddTerm(BodeModel::kPhase, toy.Phase(), toy.ErrPhase());
+    chi2.SetRange(fXmin, fXmax);
+
+    // every replica starts from the nominal parameters
+    std::vector<double> par(fPar, fPar + chi2.NPar());
+    ROOT::Fit::FitResult result;
+    bool ok = BodeMinimize(chi2, par, !_fitgain, 0, result);
+
+    for(int k = 0; k < kNPar; k++) out[k] = -1111;
+    out[kCutoff] = par[1];
+    if(_fitgain) out[kGain] = par[0];
+    if(fFilter == BodeModel::kBandpass) out[kQ] = par[2];
+
+    // gain-bandwidth product, bandwidth being the cutoff for a lowpass and f0/Q for a bandpass
+    if(_fitgain && fFilter == BodeModel::kLowpass) out[kGBW] = par[0]*par[1];
+    if(_fitgain && fFilter == BodeModel::kBandpass) out[kGBW] = par[0]*par[1]/par[2];
+
+    return ok;
+}
+
+Bool_t BodeToyMC::Run(ULong64_t nreplicas){
+
+    if(fSweep.Empty() || fFilter == BodeModel::kUnknown){
+        printf("%s", Logger::error("BodeToyMC: empty sweep or unknown filter."));
+        return false;
+    }
+    if(fPar[1] <= 0){
+        printf("%s", Logger::error("BodeToyMC: no nominal cutoff, fit the sweep first."));
+        return false;
+    }
+    if(!_fitgain && !_fitphase) _fitgain = true;
+    if(fMode == kToy && fRaw.empty()){
+        fprintf(stderr, "%s\n", Logger::warning("BodeToyMC: no scope readings behind the sweep, toys drawn on the propagated points (gain/phase correlation lost)"));
+    }
+
+    ROOT::EnableThreadSafety();
+
+    for(int k = 0; k < kNPar; k++) fValues[k].assign(nreplicas, -1111);
+    fStatus.assign(nreplicas, 0);
+
+    ThreadPool pool(fNThreads);
+    pool.ParallelFor(nreplicas, [this](std::size_t r){
+        thread_local Sweep toy;     // reused by every replica this thread fits
+        Double_t out[kNPar];
+        fStatus[r] = DoReplica(r, toy, out);
+        for(int k = 0; k < kNPar; k++) fValues[k][r] = out[k];
+    }, 16);
+
+    Int_t failed = GetNFailed();
+    if(failed > 0){
+        fprintf(stderr, "%s\n", Logger::warning(Form("BodeToyMC: %d of %llu replicas did not converge", failed, nreplicas)));
+    }
+
+    return GetNGood() > 0;
+}
+
+Int_t BodeToyMC::GetNGood() const {
+    return std::count(fStatus.begin(), fStatus.end(), 1);
+}
+
+Double_t BodeToyMC::Percentile(Par_t par, Double_t q) const {
+
+    std::vector<Double_t> v;
+    v.reserve(fStatus.size());
+    for(std::size_t r = 0; r < fStatus.size(); r++){
+        if(fStatus[r] && fValues[par][r] != -1111) v.push_back(fValues[par][r]);
+    }
+    if(v.empty()) return -1111;
+
+    // linear interpolation between order statistics
+    std::sort(v.begin(), v.end());
+    Double_t pos = std::min(std::max(q, 0.), 1.)*(v.size() - 1);
+    std::size_t i = pos;
+    if(i + 1 >= v.size()) return v.back();
+    return v[i] + (pos - i)*(v[i+1] - v[i]);
+}
+
+ToyStat_t BodeToyMC::GetStat(Par_t par) const {
+
+    ToyStat_t stat;
+    // running mean and sum of squared deviations (Welford): no cancellation when
+    // the spread is small next to the mean, as for a cutoff at 10^5 Hz +- 1 Hz
+    Double_t mean = 0, m2 = 0;
+    Int_t n = 0;
+    for(std::size_t r = 0; r < fStatus.size(); r++){
+        if(!fStatus[r] || fValues[par][r] == -1111) continue;
+        Double_t x = fValues[par][r];
+        n++;
+        Double_t d = x - mean;
+        mean += d/n;
+        m2 += d*(x - mean);
+    }
+    if(n == 0) return stat;
+
+    stat.mean = mean;
+    stat.rms = std::sqrt(m2/n);
+    stat.median = Percentile(par, 0.5);
+    stat.lo68 = Percentile(par, 0.158655);
+    stat.hi68 = Percentile(par, 0.841345);
+    stat.lo95 = Percentile(par, 0.025);
+    stat.hi95 = Percentile(par, 0.975);
+
+    return stat;
+}
+
+void BodeToyMC::Print() const {
+
+    printf("BodeToyMC: %zu replicas (%s), %d converged\n", fStatus.size(),
+        (fMode == kToy)? "toy" : "bootstrap", GetNGood());
+    for(int k = 0; k < kNPar; k++){
+        ToyStat_t s = GetStat(Par_t(k));
+        if(s.mean == -1111) continue;
+        printf("  %-7s median %-12.6g 68%% [%.6g, %.6g]  95%% [%.6g, %.6g]  mean %.6g rms %.6g\n",
+            kParName[k], s.median, s.lo68, s.hi68, s.lo95, s.hi95, s.mean, s.rms);
+    }
+}
+
+Bool_t BodeToyMC::WriteResults(const char *filename) const {
+
+    FILE *out = fopen(filename, "w");
+    if(!out){
+        printf("%s", Logger::error(Form("cannot open '%s' for writing.", filename)));
+        return false;
+    }
+
+    fprintf(out, "# replica\tstatus\tgain\tcutoff\tQ\tGBW\n");
+    for(std::size_t r = 0; r < fStatus.size(); r++){
+        fprintf(out, "%zu\t%d\t%.10g\t%.10g\t%.10g\t%.10g\n", r, fStatus[r],
+            fValues[kGain][r], fValues[kCutoff][r], fValues[kQ][r], fValues[kGBW][r]);
+    }
+    fclose(out);
+
+    return true;
+}
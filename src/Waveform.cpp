@@ -0,0 +1,238 @@
+/**
+ * @file Waveform.cpp
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include<algorithm>
+#include<cmath>
+#include<cstdint>
+#include<cstdio>
+#include<cstring>
+#include<memory>
+#include<vector>
+
+#include"Bode/InputReader.h"
+#include"Bode/Waveform.h"
+
+namespace {
+
+    const std::size_t kBlock = 1 << 16;    // samples per channel read at once
+
+    /**
+     * @brief Sequential reader of (t, V_in, V_out) blocks; times are only
+     * filled for text files with a time column
+     */
+    class Source{
+    private:
+        WaveformFormat_t    fFormat;
+        FILE               *fFile = 0;
+        std::unique_ptr<InputReader> fText;
+        std::vector<char>   fRaw;
+
+    public:
+        Source(const char *filename, const WaveformFormat_t &format) : fFormat(format) {
+            if(format.type == WaveformFormat_t::kText){
+                fText.reset(new InputReader(filename));
+            }else{
+                fFile = fopen(filename, "rb");
+            }
+        }
+        ~Source(){ if(fFile) fclose(fFile); }
+        Source(const Source &) = delete;
+        Source &operator=(const Source &) = delete;
+
+        bool IsOpen() const { return fText? fText->IsOpen() : fFile != 0; }
+
+        std::size_t Next(double *t, double *a, double *b){
+
+            std::size_t n = 0;
+
+            if(fText){
+                double row[3];
+                int ncols = fFormat.hastime? 3 : 2;
+                while(n < kBlock && fText->NextRow(row, ncols)){
+                    t[n] = fFormat.hastime? row[0] : 0;
+                    a[n] = row[ncols - 2];
+                    b[n] = row[ncols - 1];
+                    n++;
+                }
+                return n;
+            }
+
+            std::size_t width = (fFormat.type == WaveformFormat_t::kFloat64)? 8 : (fFormat.type == WaveformFormat_t::kFloat32)? 4 : 2;
+            fRaw.resize(2*kBlock*width);
+            n = fread(fRaw.data(), 2*width, kBlock, fFile);
+
+            for(std::size_t i = 0; i < n; i++){
+                double v[2];
+                for(int c = 0; c < 2; c++){
+                    const char *p = fRaw.data() + (2*i + c)*width;
+                    if(width == 8){ double x; std::memcpy(&x, p, 8); v[c] = x; }
+                    else if(width == 4){ float x; std::memcpy(&x, p, 4); v[c] = x; }
+                    else{ std::int16_t x; std::memcpy(&x, p, 2); v[c] = x; }
+                    v[c] = v[c]*fFormat.scale[c] + fFormat.offset[c];
+                }
+                t[i] = 0;
+                a[i] = v[0];
+                b[i] = v[1];
+            }
+            return n;
+        }
+    };
+
+    struct Channel_t {
+        double sum = 0, min = HUGE_VAL, max = -HUGE_VAL, mean = 0;
+        double re = 0, im = 0, sumsq = 0;   // lock-in
+    };
+
+    bool fail(std::string *error, const std::string &reason){
+        if(error) *error = reason;
+        return false;
+    }
+
+}
+
+bool AnalyzeWaveform(const char *filename, const WaveformFormat_t &format, double frequency,
+                     WaveformResult_t &result, std::string *error){
+
+    std::vector<double> t(kBlock), a(kBlock), b(kBlock);
+    Channel_t in, out;
+    std::size_t nsamples = 0;
+    double tfirst = 0, tlast = 0;
+
+    // pass 1: mean and range
+    {
+        Source src(filename, format);
+        if(!src.IsOpen()) return fail(error, "cannot open file");
+        std::size_t n;
+        while((n = src.Next(t.data(), a.data(), b.data())) > 0){
+            if(nsamples == 0) tfirst = t[0];
+            tlast = t[n - 1];
+            for(std::size_t i = 0; i < n; i++){
+                in.sum += a[i];
+                out.sum += b[i];
+                in.min = std::min(in.min, a[i]);
+                in.max = std::max(in.max, a[i]);
+                out.min = std::min(out.min, b[i]);
+                out.max = std::max(out.max, b[i]);
+            }
+            nsamples += n;
+        }
+    }
+    if(nsamples < 4) return fail(error, "fewer than 4 samples");
+
+    double rate = format.rate;
+    if(format.type == WaveformFormat_t::kText && format.hastime && rate <= 0 && tlast > tfirst){
+        rate = (nsamples - 1)/(tlast - tfirst);
+    }
+    if(rate <= 0) return fail(error, "no sample rate (set WaveformFormat_t::rate)");
+    if(in.max <= in.min) return fail(error, "V_in is constant");
+
+    in.mean = in.sum/nsamples;
+    out.mean = out.sum/nsamples;
+
+    // pass 2: rising crossings of V_in through its mean, with 10% hysteresis;
+    // crossing time = period * index + const, fitted by least squares
+    std::size_t first = 0, last = nsamples;
+    double efreq = 0;
+    if(frequency <= 0){
+        Source src(filename, format);
+        double hyst = 0.1*(in.max - in.min)/2;
+        bool armed = false;
+        double prev = 0;
+        std::size_t k = 0, m = 0;
+        double sj = 0, st = 0, sjj = 0, sjt = 0, stt = 0;
+        std::size_t n;
+        while((n = src.Next(t.data(), a.data(), b.data())) > 0){
+            for(std::size_t i = 0; i < n; i++, k++){
+                double x = a[i] - in.mean;
+                if(x < -hyst) armed = true;
+                if(armed && x >= 0 && k > 0){
+                    double tc = (k - 1) + (-prev)/(x - prev);     // in samples
+                    if(m == 0) first = k;
+                    last = k;
+                    sj += m; st += tc; sjj += double(m)*m; sjt += m*tc; stt += tc*tc;
+                    m++;
+                    armed = false;
+                }
+                prev = x;
+            }
+        }
+        if(m < 3) return fail(error, "fewer than 3 rising crossings of V_in");
+
+        double det = m*sjj - sj*sj;
+        double period = (m*sjt - sj*st)/det;                     // samples
+        double icept = (st - period*sj)/m;
+        double chi2 = stt - 2*period*sjt - 2*icept*st + period*period*sjj + 2*period*icept*sj + m*icept*icept;
+        double eperiod = std::sqrt(std::max(chi2, 0.)/(m - 2)*m/det);
+        frequency = rate/period;
+        efreq = frequency*eperiod/period;
+    }else{
+        // whole periods from the start of the capture
+        double spp = rate/frequency;
+        std::size_t periods = std::floor(nsamples/spp);
+        if(periods < 1) return fail(error, "capture shorter than one period");
+        first = 0;
+        last = std::min<std::size_t>(nsamples, std::llround(periods*spp));
+    }
+
+    // pass 3: lock-in over [first, last); the reference oscillator is rotated
+    // sample by sample and recomputed exactly every 4096 samples
+    double omega = 2*M_PI*frequency/rate;
+    double rc = std::cos(omega), rs = std::sin(omega);
+    std::size_t used = last - first;
+    {
+        Source src(filename, format);
+        std::size_t k = 0, n;
+        double c = 1, s = 0;
+        while((n = src.Next(t.data(), a.data(), b.data())) > 0 && k < last){
+            for(std::size_t i = 0; i < n && k < last; i++, k++){
+                if(k < first) continue;
+                std::size_t j = k - first;
+                if(j % 4096 == 0){
+                    double ph = std::fmod(omega*j, 2*M_PI);
+                    c = std::cos(ph);
+                    s = std::sin(ph);
+                }
+                double x = a[i] - in.mean, y = b[i] - out.mean;
+                in.re += x*c;  in.im -= x*s;  in.sumsq += x*x;
+                out.re += y*c; out.im -= y*s; out.sumsq += y*y;
+                double cn = c*rc - s*rs;
+                s = s*rc + c*rs;
+                c = cn;
+            }
+        }
+    }
+
+    // amplitude 2|sum|/N; what is left of the power is noise, sigma_A = sigma sqrt(2/N)
+    double Ain = 2*std::hypot(in.re, in.im)/used, Aout = 2*std::hypot(out.re, out.im)/used;
+    if(Ain <= 0) return fail(error, "no V_in signal at the excitation frequency");
+    double varin = std::max(in.sumsq/used - Ain*Ain/2, 0.), varout = std::max(out.sumsq/used - Aout*Aout/2, 0.);
+    double relin = std::sqrt(2*varin/used)/Ain;
+    double relout = (Aout > 0)? std::sqrt(2*varout/used)/Aout : 1;
+    // a noiseless (synthetic) capture still gets a finite weight in the fit
+    double rel = std::max(std::sqrt(relin*relin + relout*relout), 1e-9);
+
+    double phase = std::atan2(out.im, out.re) - std::atan2(in.im, in.re);
+    phase = std::remainder(phase, 2*M_PI);
+    if(phase <= -M_PI) phase += 2*M_PI;
+
+    result.freq = frequency;
+    result.efreq = efreq;
+    result.gain = Aout/Ain;
+    result.egain = result.gain*rel;
+    result.phase = phase;
+    result.ephase = rel;
+    result.ampIn = Ain;
+    result.ampOut = Aout;
+    result.nsamples = nsamples;
+    result.nperiods = std::llround(used*frequency/rate);
+
+    return true;
+}
@@ -0,0 +1,202 @@
+/**
+ * @file WindowScan.cpp
+ * @author Mattia Sotgia (mattiasotgia01@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include<algorithm>
+#include<cmath>
+#include<cstdio>
+
+#include<TROOT.h>
+
+#include"Bode/Analysis.h"
+#include"Bode/Chi2.h"
+#include"Bode/FitFCN.h"
+#include"Bode/ThreadPool.h"
+#include"Bode/WindowScan.h"
+#include"Logger.h"
+
+namespace {
+    const char *kParName[BodeModel::kMaxPar] = {"gain", "cutoff", "Q"};
+}
+
+BodeWindowScan::BodeWindowScan(const Bode &bode) : fSweep(bode.GetSweep()) {
+    fFilter = bode.GetFilter();
+    fPar[0] = bode.GetGain();
+    fPar[1] = bode.GetCutoff();
+    fPar[2] = bode.GetQ();
+    bode.GetFitRange(BodeModel::kGain, fXmin, fXmax);
+}
+
+BodeWindowScan::BodeWindowScan(const Sweep &sweep, BodeModel::Filter_t filter, const Double_t *par) : fSweep(sweep) {
+    fFilter = filter;
+    std::copy(par, par + BodeModel::NPar(filter), fPar);
+}
+
+void BodeWindowScan::DoWindow(FitWindow_t &window) const {
+
+    Chi2Function chi2(fFilter, fSweep.Size(), fSweep.Freq(), fSweep.ErrFreq());
+    if(_fitgain) chi2.AddTerm(BodeModel::kGain, fSweep.Gain(), fSweep.ErrGain());
+    if(_fitphase) chi2.AddTerm(BodeModel::kPhase, fSweep.Phase(), fSweep.ErrPhase());
+    chi2.SetRange(window.xmin, window.xmax);
+
+    std::vector<double> par(fPar, fPar + chi2.NPar());
+    ROOT::Fit::FitResult result;
+    window.status = BodeMinimize(chi2, par, !_fitgain, 0, result);
+
+    for(int k = 0; k < chi2.NPar(); k++){
+        window.par[k] = par[k];
+        window.err[k] = result.ParError(k);
+    }
+    // phase alone says nothing about the gain
+    if(!_fitgain) window.par[0] = window.err[0] = -1111;
+    window.chi2 = result.Chi2();
+    window.ndf = result.Ndf();
+}
+
+Bool_t BodeWindowScan::Run(){
+
+    if(fSweep.Empty() || fFilter == BodeModel::kUnknown){
+        printf("%s", Logger::error("BodeWindowScan: empty sweep or unknown filter."));
+        return false;
+    }
+    if(fPar[1] <= 0){
+        printf("%s", Logger::error("BodeWindowScan: no cutoff to start from, fit the sweep first."));
+        return false;
+    }
+    if(!_fitgain && !_fitphase) _fitgain = true;
+
+    // windows are cut on the distinct frequencies of the nominal range, repeated
+    // readings go in or out together
+    bool ranged = fXmin < fXmax;
+    std::vector<Double_t> freq;
+    freq.reserve(fSweep.Size());
+    for(std::size_t i = 0; i < fSweep.Size(); i++){
+        Double_t f = fSweep.Freq()[i];
+        if(!ranged || (f >= fXmin && f <= fXmax)) freq.push_back(f);
+    }
+    Int_t npoints = freq.size();
+    std::sort(freq.begin(), freq.end());
+    freq.erase(std::unique(freq.begin(), freq.end()), freq.end());
+    Int_t nfreq = freq.size();
+    // a single frequency would make the range xmin = xmax, read as the whole sweep
+    if(nfreq < 2){
+        printf("%s", Logger::error(Form("BodeWindowScan: fewer than two frequencies in the range [%g, %g].", fXmin, fXmax)));
+        return false;
+    }
+    Int_t minpoints = BodeModel::NPar(fFilter) + 2;
+
+    fFull = FitWindow_t();
+    fFull.xmin = freq.front();
+    fFull.xmax = freq.back();
+    fFull.npoints = npoints;
+    fWindows.clear();
+
+    for(Int_t lo = 0; lo <= fTrimLow; lo++){
+        for(Int_t hi = 0; hi <= fTrimHigh; hi++){
+            if(lo + hi == 0 || lo + hi >= nfreq) continue;
+            FitWindow_t w;
+            w.trimlow = lo;
+            w.trimhigh = hi;
+            w.xmin = freq[lo];
+            w.xmax = freq[nfreq - 1 - hi];
+            w.npoints = std::count_if(fSweep.Freq(), fSweep.Freq() + fSweep.Size(),
+                [&w](Double_t f){ return f >= w.xmin && f <= w.xmax; });
+            if(w.npoints >= minpoints) fWindows.push_back(w);
+        }
+    }
+
+    ROOT::EnableThreadSafety();
+
+    // the nominal range is one more task, fits are independent
+    ThreadPool pool(fNThreads);
+    pool.ParallelFor(fWindows.size() + 1, [this](std::size_t i){
+        DoWindow(i == 0? fFull : fWindows[i - 1]);
+    });
+
+    if(!fFull.status){
+        fprintf(stderr, "%s\n", Logger::warning("BodeWindowScan: the full-range fit did not converge"));
+    }
+
+    for(FitWindow_t &w: fWindows){
+        for(int k = 0; k < BodeModel::kMaxPar; k++){
+            if(!w.status || w.par[k] == -1111 || fFull.par[k] == -1111) continue;
+            Double_t sigma = std::sqrt(std::fabs(w.err[k]*w.err[k] - fFull.err[k]*fFull.err[k]));
+            sigma = std::max(sigma, 0.1*w.err[k]);
+            w.pull[k] = (sigma > 0)? (w.par[k] - fFull.par[k])/sigma : 0;
+        }
+    }
+
+    return fFull.status;
+}
+
+Double_t BodeWindowScan::GetMaxPull(Int_t par) const {
+    Double_t pull = 0;
+    for(const FitWindow_t &w: fWindows){
+        if(w.status) pull = std::max(pull, std::fabs(w.pull[par]));
+    }
+    return pull;
+}
+
+Double_t BodeWindowScan::GetSpread(Int_t par) const {
+
+    Double_t sum = 0, sum2 = 0;
+    Int_t n = 0;
+    for(const FitWindow_t &w: fWindows){
+        if(!w.status || w.par[par] == -1111) continue;
+        sum += w.par[par];
+        sum2 += w.par[par]*w.par[par];
+        n++;
+    }
+    if(n == 0 || fFull.err[par] <= 0) return -1111;
+
+    Double_t mean = sum/n;
+    return std::sqrt(std::max(sum2/n - mean*mean, 0.))/fFull.err[par];
+}
+
+Bool_t BodeWindowScan::IsStable() const {
+    if(!fFull.status) return false;
+    if(GetMaxPull(1) > fThreshold) return false;
+    return fFilter != BodeModel::kBandpass || GetMaxPull(2) <= fThreshold;
+}
+
+void BodeWindowScan::Print() const {
+
+    Int_t ngood = std::count_if(fWindows.begin(), fWindows.end(), [](const FitWindow_t &w){ return w.status; });
+    printf("BodeWindowScan: %zu windows, %d converged, full range [%.6g, %.6g] -> %s\n",
+        fWindows.size(), ngood, fFull.xmin, fFull.xmax, IsStable()? "stable" : "NOT stable");
+    for(int k = 0; k < BodeModel::NPar(fFilter); k++){
+        if(fFull.par[k] == -1111) continue;
+        printf("  %-7s full %-12.6g +- %-10.4g spread %-8.3g max |pull| %.3g\n",
+            kParName[k], fFull.par[k], fFull.err[k], GetSpread(k), GetMaxPull(k));
+    }
+}
+
+Bool_t BodeWindowScan::WriteResults(const char *filename) const {
+
+    FILE *out = fopen(filename, "w");
+    if(!out){
+        printf("%s", Logger::error(Form("cannot open '%s' for writing.", filename)));
+        return false;
+    }
+
+    fprintf(out, "# xmin\txmax\ttrim_low\ttrim_high\tnpoints\tstatus\tgain\terr_gain\tcutoff\terr_cutoff\tQ\terr_Q"
+        "\tpull_gain\tpull_cutoff\tpull_Q\tchi2\tndf\n");
+    auto line = [out](const FitWindow_t &w){
+        fprintf(out, "%.10g\t%.10g\t%d\t%d\t%d\t%d", w.xmin, w.xmax, w.trimlow, w.trimhigh, w.npoints, w.status);
+        for(int k = 0; k < BodeModel::kMaxPar; k++) fprintf(out, "\t%.10g\t%.10g", w.par[k], w.err[k]);
+        for(int k = 0; k < BodeModel::kMaxPar; k++) fprintf(out, "\t%.4g", w.pull[k]);
+        fprintf(out, "\t%.10g\t%d\n", w.chi2, w.ndf);
+    };
+    line(fFull);
+    for(const FitWindow_t &w: fWindows) line(w);
+    fclose(out);
+
+    return true;
+}